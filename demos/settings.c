@@ -409,6 +409,7 @@ void update_settings(struct plplay *p, const struct pl_frame *target)
             nk_layout_row_dynamic(nk, 24, 2);
             par->skip_anti_aliasing = !nk_check_label(nk, "Anti-aliasing", !par->skip_anti_aliasing);
             nk_property_float(nk, "Antiringing", 0, &par->antiringing_strength, 1.0, 0.05, 0.001);
+            nk_checkbox_label(nk, "Pyramid downscaling", &par->pyramid_downscaling);
 
             struct pl_sigmoid_params *spar = &opts->sigmoid_params;
             nk_layout_row_dynamic(nk, 24, 2);
@@ -578,6 +579,7 @@ void update_settings(struct plplay *p, const struct pl_frame *target)
             nk_property_float(nk, "Peak percentile", 95.0, &ppar->percentile, 100.0, 0.01, 0.001);
             nk_property_float(nk, "Black cutoff", 0.0, &ppar->black_cutoff, 100.0, 0.01, 0.001);
             nk_checkbox_label(nk, "Allow 1-frame delay", &ppar->allow_delayed);
+            nk_property_int(nk, "Max delay (frames)", 0, &ppar->max_delay, 3, 1, 1);
 
             struct pl_hdr_metadata metadata;
             if (pl_renderer_get_hdr_metadata(p->renderer, &metadata)) {
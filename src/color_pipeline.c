@@ -0,0 +1,416 @@
+/*
+ * This file is part of libplacebo.
+ *
+ * libplacebo is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplacebo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplacebo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+
+#include "common.h"
+#include "colorspace.h"
+#include "log.h"
+#include "pl_thread.h"
+
+#include <libplacebo/color_pipeline.h>
+#include <libplacebo/gamut_mapping.h>
+#include <libplacebo/tone_mapping.h>
+
+enum {
+    BLOCK = 256, // number of pixels processed at once, per thread
+    MAX_WORKERS = 16,
+    MIN_PIXELS_PER_WORKER = 1 << 14,
+};
+
+enum tone_mode {
+    TONE_NONE,
+    TONE_CLIP,
+    TONE_LINEAR,
+    TONE_LUT,
+};
+
+struct pl_color_pipeline_t {
+    struct pl_color_space src, dst;
+    pl_transform3x3 decode; // input values -> normalized RGB
+    pl_transform3x3 encode; // normalized RGB -> output values
+    bool color_map;         // src and dst color spaces differ
+    bool full_map;          // requires conversion to IPT
+    pl_matrix3x3 rgb2lms;
+    pl_matrix3x3 lms2rgb;   // on the fast path, this is src RGB -> dst RGB
+
+    enum tone_mode tone_mode;
+    struct pl_tone_map_params tone;
+    float tone_scale, tone_offset; // input to [0,1] (TONE_LINEAR, TONE_LUT)
+    float tone_mul, tone_add;      // [0,1] to output (TONE_LINEAR)
+    float *tone_lut;
+
+    bool gamut_map;
+    struct pl_gamut_map_params gamut;
+};
+
+static bool repr_supported(pl_log log, const struct pl_color_repr *repr)
+{
+    switch (repr->sys) {
+    case PL_COLOR_SYSTEM_UNKNOWN:
+    case PL_COLOR_SYSTEM_RGB:
+    case PL_COLOR_SYSTEM_BT_601:
+    case PL_COLOR_SYSTEM_BT_709:
+    case PL_COLOR_SYSTEM_SMPTE_240M:
+    case PL_COLOR_SYSTEM_BT_2020_NC:
+    case PL_COLOR_SYSTEM_YCGCO:
+    case PL_COLOR_SYSTEM_YCGCO_RE:
+    case PL_COLOR_SYSTEM_YCGCO_RO:
+        return true;
+
+    case PL_COLOR_SYSTEM_BT_2020_C:
+    case PL_COLOR_SYSTEM_BT_2100_PQ:
+    case PL_COLOR_SYSTEM_BT_2100_HLG:
+    case PL_COLOR_SYSTEM_DOLBYVISION:
+    case PL_COLOR_SYSTEM_XYZ:
+        pl_err(log, "Color system '%s' is not supported by the CPU color "
+               "pipeline!", pl_color_system_name(repr->sys));
+        return false;
+
+    case PL_COLOR_SYSTEM_COUNT: break;
+    }
+
+    pl_unreachable();
+}
+
+pl_color_pipeline pl_color_pipeline_create(pl_log log,
+                                           const struct pl_color_pipeline_params *params)
+{
+    if (!repr_supported(log, &params->src_repr) ||
+        !repr_supported(log, &params->dst_repr))
+    {
+        return NULL;
+    }
+
+    struct pl_color_pipeline_t *pipe = pl_zalloc_ptr(NULL, pipe);
+    struct pl_color_repr repr = params->src_repr;
+    pipe->decode = pl_color_repr_decode(&repr, params->color_adjustment);
+    repr = params->dst_repr;
+    pipe->encode = pl_color_repr_decode(&repr, NULL);
+    pl_transform3x3_invert(&pipe->encode);
+
+    // Mirrors the logic of `pl_shader_color_map_ex`
+    pipe->src = params->src_csp;
+    pipe->dst = params->dst_csp;
+    pl_color_space_infer_map(&pipe->src, &pipe->dst);
+    pipe->color_map = !pl_color_space_equal(&pipe->src, &pipe->dst);
+    if (!pipe->color_map)
+        return pipe;
+
+    const struct pl_color_map_params *map_params;
+    map_params = PL_DEF(params->color_map_params, &pl_color_map_default_params);
+    struct pl_tone_map_params *tone = &pipe->tone;
+    struct pl_gamut_map_params *gamut = &pipe->gamut;
+    pl_color_map_infer(map_params, &pipe->src, &pipe->dst, tone, gamut);
+    pipe->rgb2lms = pl_ipt_rgb2lms(pl_raw_primaries_get(pipe->src.primaries));
+    pipe->lms2rgb = pl_ipt_lms2rgb(pl_raw_primaries_get(pipe->dst.primaries));
+
+    bool need_tone_map = !pl_tone_map_params_noop(tone);
+    pipe->gamut_map = !pl_gamut_map_params_noop(gamut);
+    if (pipe->gamut_map && gamut->function == &pl_gamut_map_saturation) {
+        const pl_matrix3x3 lms2src = pl_ipt_lms2rgb(&gamut->input_gamut);
+        const pl_matrix3x3 dst2lms = pl_ipt_rgb2lms(&gamut->output_gamut);
+        pl_matrix3x3_mul(&pipe->lms2rgb, &dst2lms);
+        pl_matrix3x3_mul(&pipe->lms2rgb, &lms2src);
+        pipe->gamut_map = false;
+    }
+
+    pipe->full_map = need_tone_map || pipe->gamut_map;
+    if (!pipe->full_map) {
+        pl_matrix3x3_mul(&pipe->lms2rgb, &pipe->rgb2lms);
+        return pipe;
+    }
+
+    if (!need_tone_map) {
+        pipe->tone_mode = TONE_NONE;
+    } else if (tone->function == &pl_tone_map_clip && !map_params->force_tone_mapping_lut) {
+        pipe->tone_mode = TONE_CLIP;
+    } else if (tone->function == &pl_tone_map_linear && !map_params->force_tone_mapping_lut) {
+        const float gain = tone->constants.exposure;
+        const float scale = tone->input_max - tone->input_min;
+        pipe->tone_mode = TONE_LINEAR;
+        pipe->tone_scale = gain / scale;
+        pipe->tone_offset = -gain / scale * tone->input_min;
+        pipe->tone_mul = tone->output_max - tone->output_min;
+        pipe->tone_add = tone->output_min;
+    } else {
+        const float lut_range = tone->input_max - tone->input_min;
+        pipe->tone_mode = TONE_LUT;
+        pipe->tone_scale = 1.0f / lut_range;
+        pipe->tone_offset = -tone->input_min / lut_range;
+        pipe->tone_lut = pl_calloc_ptr(pipe, tone->lut_size, pipe->tone_lut);
+        pl_tone_map_generate(pipe->tone_lut, tone);
+    }
+
+    return pipe;
+}
+
+void pl_color_pipeline_destroy(pl_color_pipeline *pipe)
+{
+    pl_free((void *) *pipe);
+    *pipe = NULL;
+}
+
+// Applies `m * x + c` to every pixel, in-place
+static void apply_transform(float *rgb[3], const pl_matrix3x3 *m,
+                            const float c[3], int num)
+{
+    float *restrict r = rgb[0], *restrict g = rgb[1], *restrict b = rgb[2];
+    for (int i = 0; i < num; i++) {
+        const float x = r[i], y = g[i], z = b[i];
+        r[i] = m->m[0][0] * x + m->m[0][1] * y + m->m[0][2] * z + c[0];
+        g[i] = m->m[1][0] * x + m->m[1][1] * y + m->m[1][2] * z + c[1];
+        b[i] = m->m[2][0] * x + m->m[2][1] * y + m->m[2][2] * z + c[2];
+    }
+}
+
+static void pq_encode(float *rgb[3], int num)
+{
+    for (int c = 0; c < 3; c++) {
+        float *restrict x = rgb[c];
+        for (int i = 0; i < num; i++) {
+            float v = powf(fmaxf(x[i] * (PL_COLOR_SDR_WHITE / 10000), 0.0f), PQ_M1);
+            v = (PQ_C1 + PQ_C2 * v) / (1.0f + PQ_C3 * v);
+            x[i] = powf(v, PQ_M2);
+        }
+    }
+}
+
+static void pq_decode(float *rgb[3], int num)
+{
+    for (int c = 0; c < 3; c++) {
+        float *restrict x = rgb[c];
+        for (int i = 0; i < num; i++) {
+            float v = powf(fmaxf(x[i], 0.0f), 1.0f / PQ_M2);
+            v = fmaxf(v - PQ_C1, 0.0f) / (PQ_C2 - PQ_C3 * v);
+            x[i] = powf(v, 1.0f / PQ_M1) * (10000 / PL_COLOR_SDR_WHITE);
+        }
+    }
+}
+
+static void tone_map(pl_color_pipeline pipe, float *restrict I, int num)
+{
+    const struct pl_tone_map_params *tone = &pipe->tone;
+    switch (pipe->tone_mode) {
+    case TONE_NONE:
+        return;
+    case TONE_CLIP:
+        for (int i = 0; i < num; i++)
+            I[i] = PL_CLAMP(I[i], tone->input_min, tone->input_max);
+        return;
+    case TONE_LINEAR:
+        for (int i = 0; i < num; i++) {
+            float x = PL_CLAMP(pipe->tone_scale * I[i] + pipe->tone_offset, 0.0f, 1.0f);
+            I[i] = pipe->tone_mul * x + pipe->tone_add;
+        }
+        return;
+    case TONE_LUT: {
+        const float *lut = pipe->tone_lut;
+        const int last = tone->lut_size - 1;
+        for (int i = 0; i < num; i++) {
+            float x = PL_CLAMP(pipe->tone_scale * I[i] + pipe->tone_offset, 0.0f, 1.0f);
+            x *= last;
+            const int idx = PL_MIN((int) x, last - 1);
+            const float t = x - idx;
+            I[i] = PL_MIX(lut[idx], lut[idx + 1], t);
+        }
+        return;
+    }
+    }
+
+    pl_unreachable();
+}
+
+static void color_map(pl_color_pipeline pipe, float *rgb[3], int num)
+{
+    pl_color_linearize_n(&pipe->src, rgb, num);
+    if (!pipe->full_map) {
+        apply_transform(rgb, &pipe->lms2rgb, (float[3]) {0}, num);
+        goto done;
+    }
+
+    // Convert to IPT, reusing the RGB planes
+    float i_orig[BLOCK];
+    apply_transform(rgb, &pipe->rgb2lms, (float[3]) {0}, num);
+    pq_encode(rgb, num);
+    apply_transform(rgb, &pl_ipt_lms2ipt, (float[3]) {0}, num);
+    float *restrict I = rgb[0], *restrict P = rgb[1], *restrict T = rgb[2];
+    memcpy(i_orig, I, num * sizeof(float));
+
+    if (pipe->tone_mode != TONE_NONE) {
+        tone_map(pipe, I, num);
+
+        // Same saturation adjustment as `pl_shader_color_map_ex`
+        for (int i = 0; i < num; i++) {
+            const float a = i_orig[i], b = I[i];
+            const float hull_a = ((a - 6) * a + 9) * a;
+            const float hull_b = ((b - 6) * b + 9) * b;
+            const float k = b > 0 ? fminf(a / b, hull_b / hull_a) : 0.0f;
+            P[i] *= k;
+            T[i] *= k;
+        }
+    }
+
+    if (pipe->gamut_map) {
+        float ipt[3 * BLOCK];
+        for (int i = 0; i < num; i++) {
+            ipt[3 * i + 0] = I[i];
+            ipt[3 * i + 1] = P[i];
+            ipt[3 * i + 2] = T[i];
+        }
+        pl_gamut_map_sample_n(ipt, num, &pipe->gamut);
+        for (int i = 0; i < num; i++) {
+            I[i] = ipt[3 * i + 0];
+            P[i] = ipt[3 * i + 1];
+            T[i] = ipt[3 * i + 2];
+        }
+    }
+
+    apply_transform(rgb, &pl_ipt_ipt2lms, (float[3]) {0}, num);
+    pq_decode(rgb, num);
+    apply_transform(rgb, &pipe->lms2rgb, (float[3]) {0}, num);
+
+done:
+    pl_color_delinearize_n(&pipe->dst, rgb, num);
+}
+
+static inline size_t buf_stride(const struct pl_color_buf *buf)
+{
+    switch (buf->type) {
+    case PL_COLOR_BUF_FLOAT:  return PL_DEF(buf->pixel_stride, sizeof(float));
+    case PL_COLOR_BUF_UINT16: return PL_DEF(buf->pixel_stride, sizeof(uint16_t));
+    }
+
+    pl_unreachable();
+}
+
+static void load_block(float *rgb[3], const struct pl_color_buf *buf,
+                       size_t start, int num)
+{
+    const size_t stride = buf_stride(buf);
+    for (int c = 0; c < 3; c++) {
+        const uint8_t *src = (const uint8_t *) buf->data[c] + start * stride;
+        float *restrict x = rgb[c];
+        switch (buf->type) {
+        case PL_COLOR_BUF_FLOAT:
+            for (int i = 0; i < num; i++)
+                memcpy(&x[i], src + i * stride, sizeof(float));
+            continue;
+        case PL_COLOR_BUF_UINT16:
+            for (int i = 0; i < num; i++) {
+                uint16_t v;
+                memcpy(&v, src + i * stride, sizeof(v));
+                x[i] = v * (1.0f / UINT16_MAX);
+            }
+            continue;
+        }
+
+        pl_unreachable();
+    }
+}
+
+static void store_block(const struct pl_color_buf *buf, float *rgb[3],
+                        size_t start, int num)
+{
+    const size_t stride = buf_stride(buf);
+    for (int c = 0; c < 3; c++) {
+        uint8_t *dst = (uint8_t *) buf->data[c] + start * stride;
+        const float *restrict x = rgb[c];
+        switch (buf->type) {
+        case PL_COLOR_BUF_FLOAT:
+            for (int i = 0; i < num; i++)
+                memcpy(dst + i * stride, &x[i], sizeof(float));
+            continue;
+        case PL_COLOR_BUF_UINT16:
+            for (int i = 0; i < num; i++) {
+                const float v = fminf(fmaxf(x[i], 0.0f), 1.0f);
+                const uint16_t u = v * UINT16_MAX + 0.5f;
+                memcpy(dst + i * stride, &u, sizeof(u));
+            }
+            continue;
+        }
+
+        pl_unreachable();
+    }
+}
+
+struct apply_args {
+    pl_color_pipeline pipe;
+    const struct pl_color_buf *src;
+    const struct pl_color_buf *dst;
+    size_t start;
+    size_t count;
+};
+
+static PL_THREAD_VOID apply_thread(void *priv)
+{
+    const struct apply_args *args = priv;
+    pl_color_pipeline pipe = args->pipe;
+
+    float planes[3][BLOCK];
+    float *rgb[3] = { planes[0], planes[1], planes[2] };
+    const size_t end = args->start + args->count;
+    for (size_t pos = args->start; pos < end; pos += BLOCK) {
+        const int num = PL_MIN(end - pos, BLOCK);
+        load_block(rgb, args->src, pos, num);
+        apply_transform(rgb, &pipe->decode.mat, pipe->decode.c, num);
+        if (pipe->color_map)
+            color_map(pipe, rgb, num);
+        apply_transform(rgb, &pipe->encode.mat, pipe->encode.c, num);
+        store_block(args->dst, rgb, pos, num);
+    }
+
+    PL_THREAD_RETURN();
+}
+
+void pl_color_pipeline_apply(pl_color_pipeline pipe,
+                             const struct pl_color_buf *src,
+                             const struct pl_color_buf *dst,
+                             size_t num_pixels)
+{
+    struct apply_args args[MAX_WORKERS];
+    const int num_workers = PL_CLAMP(num_pixels / MIN_PIXELS_PER_WORKER, 1, MAX_WORKERS);
+    const size_t num_per_worker = PL_ALIGN2(PL_DIV_UP(num_pixels, num_workers), BLOCK);
+    for (int i = 0; i < num_workers; i++) {
+        const size_t start = PL_MIN(i * num_per_worker, num_pixels);
+        args[i] = (struct apply_args) {
+            .pipe   = pipe,
+            .src    = src,
+            .dst    = dst,
+            .start  = start,
+            .count  = PL_MIN(num_per_worker, num_pixels - start),
+        };
+    }
+
+    if (num_workers == 1) {
+        apply_thread(&args[0]);
+        return;
+    }
+
+    pl_thread workers[MAX_WORKERS] = {0};
+    for (int i = 0; i < num_workers; i++) {
+        if (pl_thread_create(&workers[i], apply_thread, &args[i]) != 0)
+            apply_thread(&args[i]); // fallback
+    }
+
+    for (int i = 0; i < num_workers; i++) {
+        if (!workers[i])
+            continue;
+        if (pl_thread_join(workers[i]) != 0)
+            apply_thread(&args[i]); // fallback
+    }
+}
@@ -547,16 +547,20 @@ bool pl_color_space_is_black_scaled(const struct pl_color_space *csp)
     pl_unreachable();
 }
 
+// Applies an expression of `X` to every value in all three planes. Kept as
+// simple loops over each plane so that the compiler can vectorize them.
 #define MAP3(...)                                                               \
     do {                                                                        \
-        float X;                                                                \
-        for (int _i = 0; _i < 3; _i++) {                                        \
-            X = color[_i];                                                      \
-            color[_i] = __VA_ARGS__;                                            \
+        for (int _c = 0; _c < 3; _c++) {                                        \
+            float *const _p = rgb[_c];                                          \
+            for (int _i = 0; _i < num; _i++) {                                  \
+                const float X = _p[_i];                                         \
+                _p[_i] = __VA_ARGS__;                                           \
+            }                                                                   \
         }                                                                       \
     } while (0)
 
-void pl_color_linearize(const struct pl_color_space *csp, float color[3])
+void pl_color_linearize_n(const struct pl_color_space *csp, float *rgb[3], int num)
 {
     if (csp->transfer == PL_COLOR_TRC_LINEAR)
         return;
@@ -614,9 +618,12 @@ void pl_color_linearize(const struct pl_color_space *csp, float color[3])
         MAP3(X > 0.5f ? expf((X - HLG_C) / HLG_A) + HLG_B
                       : 4 * X * X);
         // OOTF
-        float luma = coef[0] * color[0] + coef[1] * color[1] + coef[2] * color[2];
-        luma = powf(fmaxf(luma / 12, 0), y - 1);
-        MAP3(luma * X / 12);
+        for (int i = 0; i < num; i++) {
+            float luma = coef[0] * rgb[0][i] + coef[1] * rgb[1][i] + coef[2] * rgb[2][i];
+            luma = powf(fmaxf(luma / 12, 0), y - 1);
+            for (int c = 0; c < 3; c++)
+                rgb[c][i] *= luma / 12;
+        }
         goto scale_out;
     }
     case PL_COLOR_TRC_V_LOG:
@@ -642,7 +649,7 @@ scale_out:
         MAP3((csp_max - csp_min) * X + csp_min);
 }
 
-void pl_color_delinearize(const struct pl_color_space *csp, float color[3])
+void pl_color_delinearize_n(const struct pl_color_space *csp, float *rgb[3], int num)
 {
     if (csp->transfer == PL_COLOR_TRC_LINEAR)
         return;
@@ -698,9 +705,12 @@ void pl_color_delinearize(const struct pl_color_space *csp, float color[3])
             pl_get_rgb2xyz_matrix(pl_raw_primaries_get(csp->primaries));
         const float *coef = rgb2xyz.m[1];
         // OOTF^-1
-        float luma = coef[0] * color[0] + coef[1] * color[1] + coef[2] * color[2];
-        luma = fmaxf(1e-6f, powf(luma / csp_max, (1 - y) / y));
-        MAP3(12 / csp_max * luma * X);
+        for (int i = 0; i < num; i++) {
+            float luma = coef[0] * rgb[0][i] + coef[1] * rgb[1][i] + coef[2] * rgb[2][i];
+            luma = fmaxf(1e-6f, powf(luma / csp_max, (1 - y) / y));
+            for (int c = 0; c < 3; c++)
+                rgb[c][i] *= 12 / csp_max * luma;
+        }
         // OETF
         MAP3(X > 1 ? HLG_A * logf(X - HLG_B) + HLG_C : 0.5f * sqrtf(X));
         MAP3((X - b) / (1 - b));
@@ -725,6 +735,18 @@ void pl_color_delinearize(const struct pl_color_space *csp, float color[3])
     pl_unreachable();
 }
 
+void pl_color_linearize(const struct pl_color_space *csp, float color[3])
+{
+    float *rgb[3] = { &color[0], &color[1], &color[2] };
+    pl_color_linearize_n(csp, rgb, 1);
+}
+
+void pl_color_delinearize(const struct pl_color_space *csp, float color[3])
+{
+    float *rgb[3] = { &color[0], &color[1], &color[2] };
+    pl_color_delinearize_n(csp, rgb, 1);
+}
+
 void pl_color_space_merge(struct pl_color_space *orig,
                           const struct pl_color_space *new)
 {
@@ -44,3 +44,25 @@ static const float SLOG_A = 0.432699,
                    SLOG_P = 3.538813,
                    SLOG_Q = 0.030001,
                    SLOG_K2 = 155.0 / 219.0;
+
+// Batched versions of `pl_color_linearize` and `pl_color_delinearize`,
+// operating in-place on `num` values stored in three separate planes.
+void pl_color_linearize_n(const struct pl_color_space *csp, float *rgb[3], int num);
+void pl_color_delinearize_n(const struct pl_color_space *csp, float *rgb[3], int num);
+
+struct pl_color_map_params;
+struct pl_tone_map_params;
+struct pl_gamut_map_params;
+
+// Batched version of `pl_gamut_map_sample`, for `num` consecutive IPTPQc4
+// values.
+void pl_gamut_map_sample_n(float *x, int num, const struct pl_gamut_map_params *params);
+
+// Derives the effective tone and gamut mapping parameters for a conversion
+// from `src` to `dst`, exactly as used by `pl_shader_color_map_ex`. `src`
+// and `dst` should already have been inferred.
+void pl_color_map_infer(const struct pl_color_map_params *params,
+                        const struct pl_color_space *src,
+                        const struct pl_color_space *dst,
+                        struct pl_tone_map_params *tone,
+                        struct pl_gamut_map_params *gamut);
@@ -46,6 +46,7 @@ struct pl_dispatch_t {
 
     void (*info_callback)(void *, const struct pl_dispatch_info *);
     void *info_priv;
+    struct timeline *timeline; // or NULL if disabled
 
     PL_ARRAY(pl_shader) shaders;                // to avoid re-allocations
     PL_ARRAY(struct pass *) passes;             // compiled passes
@@ -97,8 +98,66 @@ struct pass {
     uint64_t ts_sum;
     uint64_t samples[PL_ARRAY_SIZE(((struct pl_dispatch_info *) NULL)->samples)];
     int ts_idx;
+
+    // Timeline events still awaiting their timer results, oldest first
+    PL_ARRAY(uint64_t) pending;
+};
+
+// Maximum number of timer results to wait for per pass. Results may be
+// dropped by the implementation, so this bounds the resulting drift.
+#define MAX_PENDING 16
+
+struct timeline {
+    PL_ARRAY(struct pl_timeline_event) events;
+    PL_ARRAY(const char *) names; // interned copies of all event names
+    int max_events;
+    uint64_t first_id; // ID of `events.elem[0]`
+    uint64_t frame;
+    pl_clock_t base;
 };
 
+static uint64_t clock_ns(const struct timeline *tl, pl_clock_t ts)
+{
+    return ts > tl->base ? pl_clock_diff(ts, tl->base) * 1e9 : 0;
+}
+
+static const char *timeline_name(struct timeline *tl, const char *name)
+{
+    name = PL_DEF(name, "unknown");
+    for (int i = 0; i < tl->names.num; i++) {
+        if (strcmp(tl->names.elem[i], name) == 0)
+            return tl->names.elem[i];
+    }
+
+    const char *copy = pl_strdup0(tl, pl_str0(name));
+    PL_ARRAY_APPEND(tl, tl->names, copy);
+    return copy;
+}
+
+// Returns the ID of the newly added event
+static uint64_t timeline_add(struct timeline *tl, enum pl_timeline_op op,
+                             const char *name, pl_clock_t start, pl_clock_t end)
+{
+    if (tl->events.num == tl->max_events) {
+        // Drop the oldest half at once, to amortize the cost of shifting
+        const int drop = PL_MAX(tl->max_events / 2, 1);
+        memmove(tl->events.elem, &tl->events.elem[drop],
+                (tl->events.num - drop) * sizeof(tl->events.elem[0]));
+        tl->events.num -= drop;
+        tl->first_id += drop;
+    }
+
+    PL_ARRAY_APPEND(tl, tl->events, (struct pl_timeline_event) {
+        .op        = op,
+        .name      = timeline_name(tl, name),
+        .frame     = tl->frame,
+        .cpu_start = clock_ns(tl, start),
+        .cpu_end   = clock_ns(tl, end),
+    });
+
+    return tl->first_id + tl->events.num - 1;
+}
+
 static void pass_destroy(pl_dispatch dp, struct pass *pass)
 {
     if (!pass)
@@ -110,6 +169,139 @@ static void pass_destroy(pl_dispatch dp, struct pass *pass)
     pl_free(pass);
 }
 
+void pl_dispatch_set_timeline(pl_dispatch dp, int max_events)
+{
+    pl_mutex_lock(&dp->lock);
+    pl_free_ptr(&dp->timeline);
+    for (int i = 0; i < dp->passes.num; i++)
+        dp->passes.elem[i]->pending.num = 0;
+
+    if (max_events > 0) {
+        dp->timeline = pl_zalloc_ptr(dp, dp->timeline);
+        dp->timeline->max_events = max_events;
+        dp->timeline->base = pl_clock_now();
+    }
+    pl_mutex_unlock(&dp->lock);
+}
+
+void pl_dispatch_timeline_add(pl_dispatch dp, enum pl_timeline_op op,
+                              const char *name, pl_clock_t start, pl_clock_t end)
+{
+    pl_mutex_lock(&dp->lock);
+    if (dp->timeline)
+        timeline_add(dp->timeline, op, name, start, end);
+    pl_mutex_unlock(&dp->lock);
+}
+
+void pl_dispatch_timeline_frame(pl_dispatch dp, uint64_t frame)
+{
+    pl_mutex_lock(&dp->lock);
+    struct timeline *tl = dp->timeline;
+    if (tl) {
+        tl->frame = frame;
+        const pl_clock_t now = pl_clock_now();
+        timeline_add(tl, PL_TIMELINE_FRAME, "frame", now, now);
+    }
+    pl_mutex_unlock(&dp->lock);
+}
+
+int pl_dispatch_get_timeline(pl_dispatch dp, struct pl_timeline_event *out,
+                             int max_events)
+{
+    if (out && max_events <= 0)
+        return 0;
+
+    pl_mutex_lock(&dp->lock);
+    struct timeline *tl = dp->timeline;
+    int num = tl ? tl->events.num : 0;
+    if (out && tl) {
+        num = PL_MIN(num, max_events);
+        memcpy(out, tl->events.elem, num * sizeof(*out));
+    }
+    pl_mutex_unlock(&dp->lock);
+    return num;
+}
+
+static void append_json_str(void *alloc, pl_str *out, const char *str)
+{
+    static const char hex[] = "0123456789abcdef";
+    pl_str_append_raw(alloc, out, "\"", 1);
+    for (const char *c = str; *c; c++) {
+        const uint8_t ch = *c;
+        if (ch == '"' || ch == '\\') {
+            pl_str_append_asprintf_c(alloc, out, "\\%c", ch);
+        } else if (ch < 0x20) {
+            pl_str_append_asprintf_c(alloc, out, "\\u00%c%c",
+                                     hex[ch >> 4], hex[ch & 0xF]);
+        } else {
+            pl_str_append_raw(alloc, out, c, 1);
+        }
+    }
+    pl_str_append_raw(alloc, out, "\"", 1);
+}
+
+enum {
+    TRACK_CPU = 1,
+    TRACK_GPU = 2,
+};
+
+static void append_json_event(void *alloc, pl_str *out,
+                              const struct pl_timeline_event *ev,
+                              int track, uint64_t start, uint64_t dur)
+{
+    static const char *cats[] = {
+        [PL_TIMELINE_FRAME] = "frame",
+        [PL_TIMELINE_PASS]  = "pass",
+        [PL_TIMELINE_CLEAR] = "clear",
+    };
+
+    pl_str_append_asprintf_c(alloc, out, ",\n{\"name\":");
+    append_json_str(alloc, out, ev->name);
+    pl_str_append_asprintf_c(alloc, out, ",\"cat\":\"%s\",", cats[ev->op]);
+    if (ev->op == PL_TIMELINE_FRAME) {
+        pl_str_append_asprintf_c(alloc, out, "\"ph\":\"i\",\"s\":\"p\",");
+    } else {
+        pl_str_append_asprintf_c(alloc, out, "\"ph\":\"X\",\"dur\":%f,",
+                                 dur * 1e-3);
+    }
+    pl_str_append_asprintf_c(alloc, out, "\"ts\":%f,\"pid\":1,\"tid\":%d,"
+                             "\"args\":{\"frame\":%llu}}", start * 1e-3, track,
+                             (unsigned long long) ev->frame);
+}
+
+pl_str pl_dispatch_save_timeline(pl_dispatch dp, void *alloc)
+{
+    pl_str out = {0};
+    pl_str_append_asprintf_c(alloc, &out,
+        "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+        "\"args\":{\"name\":\"CPU\"}},\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+        "\"args\":{\"name\":\"GPU (estimated)\"}}",
+        TRACK_CPU, TRACK_GPU);
+
+    pl_mutex_lock(&dp->lock);
+    const struct timeline *tl = dp->timeline;
+    uint64_t gpu_end = 0;
+    for (int i = 0; tl && i < tl->events.num; i++) {
+        const struct pl_timeline_event *ev = &tl->events.elem[i];
+        append_json_event(alloc, &out, ev, TRACK_CPU, ev->cpu_start,
+                          ev->cpu_end - ev->cpu_start);
+        if (!ev->gpu_time)
+            continue;
+
+        // GPU work can't start before it was recorded, nor before the
+        // previous pass on the same queue finished
+        const uint64_t gpu_start = PL_MAX(ev->cpu_end, gpu_end);
+        append_json_event(alloc, &out, ev, TRACK_GPU, gpu_start, ev->gpu_time);
+        gpu_end = gpu_start + ev->gpu_time;
+    }
+    pl_mutex_unlock(&dp->lock);
+
+    pl_str_append_asprintf_c(alloc, &out, "\n]}\n");
+    return out;
+}
+
 pl_dispatch pl_dispatch_create(pl_log log, pl_gpu gpu)
 {
     struct pl_dispatch_t *dp = pl_zalloc_ptr(NULL, dp);
@@ -729,6 +921,26 @@ static void garbage_collect_passes(pl_dispatch dp)
     }
 }
 
+// Destroys stale passes, oldest first, while the GPU memory budget is exceeded
+static void trim_passes(pl_dispatch dp)
+{
+    if (!pl_mem_budget_excess(dp->gpu))
+        return;
+
+    qsort(dp->passes.elem, dp->passes.num, sizeof(struct pass *), cmp_pass_age);
+    int num_evicted = 0;
+    while (dp->passes.num && pl_mem_budget_excess(dp->gpu)) {
+        struct pass *pass = dp->passes.elem[dp->passes.num - 1];
+        if (pass_age(pass) < MIN_AGE)
+            break;
+        pass_destroy(dp, pass);
+        dp->passes.num--;
+        num_evicted++;
+    }
+
+    pl_mem_budget_evicted(dp->gpu, num_evicted);
+}
+
 static struct pass *finalize_pass(pl_dispatch dp, pl_shader sh,
                                   pl_tex target, int vert_idx,
                                   const struct pl_blend_params *blend, bool load,
@@ -1146,11 +1358,30 @@ static void translate_compute_shader(pl_dispatch dp, pl_shader sh,
 static void run_pass(pl_dispatch dp, pl_shader sh, struct pass *pass)
 {
     pl_shader_info shader = &sh->info->info;
+    struct timeline *tl = dp->timeline;
+    const pl_clock_t start = tl ? pl_clock_now() : 0;
     pl_pass_run(dp->gpu, &pass->run_params);
 
+    if (tl) {
+        uint64_t id = timeline_add(tl, PL_TIMELINE_PASS, shader->description,
+                                   start, pl_clock_now());
+        if (pass->timer && pass->run_params.timer == pass->timer) {
+            if (pass->pending.num == MAX_PENDING)
+                PL_ARRAY_REMOVE_AT(pass->pending, 0);
+            PL_ARRAY_APPEND(pass, pass->pending, id);
+        }
+    }
+
     for (uint64_t ts; (ts = pl_timer_query(dp->gpu, pass->timer));) {
         PL_TRACE(dp, "Spent %.3f ms on shader: %s", ts / 1e6, shader->description);
 
+        if (tl && pass->pending.num) {
+            const uint64_t id = pass->pending.elem[0];
+            PL_ARRAY_REMOVE_AT(pass->pending, 0);
+            if (id >= tl->first_id)
+                tl->events.elem[id - tl->first_id].gpu_time = ts;
+        }
+
         uint64_t old = pass->samples[pass->ts_idx];
         pass->samples[pass->ts_idx] = ts;
         pass->ts_last = ts;
@@ -1617,6 +1848,7 @@ void pl_dispatch_reset_frame(pl_dispatch dp)
     dp->current_ident = 0;
     dp->current_index++;
     garbage_collect_passes(dp);
+    trim_passes(dp);
 
     pl_mutex_unlock(&dp->lock);
 }
@@ -19,6 +19,8 @@
 
 #include "common.h"
 
+#include <libplacebo/renderer.h>
+
 // Like `pl_dispatch_begin`, but has an extra `unique` parameter. If this is
 // true, the generated shader will be uniquely namespaced `unique` and may be
 // freely merged with other shaders (`sh_subpass`). Otherwise, all shaders have
@@ -29,3 +31,24 @@ pl_shader pl_dispatch_begin_ex(pl_dispatch dp, bool unique);
 //
 // This is a private API because it's sort of clunky/stateful.
 void pl_dispatch_mark_dynamic(pl_dispatch dp, bool dynamic);
+
+// Timeline recording, backing `pl_renderer_get_timeline`. Setting
+// `max_events` to 0 disables recording and frees all recorded events.
+void pl_dispatch_set_timeline(pl_dispatch dp, int max_events);
+
+// Records an operation not otherwise tracked by the dispatch (e.g. a clear),
+// which took place between the CPU timestamps `start` and `end`. No-op if
+// the timeline is disabled.
+void pl_dispatch_timeline_add(pl_dispatch dp, enum pl_timeline_op op,
+                              const char *name, pl_clock_t start, pl_clock_t end);
+
+// Marks the start of a new frame, which all subsequent events belong to.
+void pl_dispatch_timeline_frame(pl_dispatch dp, uint64_t frame);
+
+// Semantics identical to `pl_renderer_get_timeline`.
+int pl_dispatch_get_timeline(pl_dispatch dp, struct pl_timeline_event *out,
+                             int max_events);
+
+// Returns the recorded timeline in the Chrome trace event JSON format,
+// allocated on `alloc`.
+pl_str pl_dispatch_save_timeline(pl_dispatch dp, void *alloc);
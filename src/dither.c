@@ -56,7 +56,7 @@ void pl_generate_bayer_matrix(float *data, int size)
 
 #define MAX_SIZEB 8
 #define MAX_SIZE (1 << MAX_SIZEB)
-#define MAX_SIZE2 (MAX_SIZE * MAX_SIZE)
+#define BLOCK 64
 
 typedef uint_fast32_t index_t;
 
@@ -65,13 +65,15 @@ typedef uint_fast32_t index_t;
 
 struct ctx {
     unsigned int sizeb, size, size2;
+    unsigned int block, num_blocks;
     unsigned int gauss_radius;
     unsigned int gauss_middle;
-    uint64_t gauss[MAX_SIZE2];
-    index_t randomat[MAX_SIZE2];
-    bool calcmat[MAX_SIZE2];
-    uint64_t gaussmat[MAX_SIZE2];
-    index_t unimat[MAX_SIZE2];
+    uint64_t *gauss;    // repeated twice, to avoid wrapping in `setbit`
+    index_t *randomat;
+    bool *calcmat;
+    uint64_t *gaussmat;
+    uint64_t *blockmin; // minimum energy of all unset entries in each block
+    index_t *unimat;
 };
 
 static void makegauss(struct ctx *k, unsigned int sizeb)
@@ -81,6 +83,15 @@ static void makegauss(struct ctx *k, unsigned int sizeb)
     k->sizeb = sizeb;
     k->size = 1 << k->sizeb;
     k->size2 = k->size * k->size;
+    k->block = PL_MIN(BLOCK, k->size2);
+    k->num_blocks = k->size2 / k->block;
+
+    k->gauss    = pl_calloc_ptr(k, 2 * k->size2, k->gauss);
+    k->randomat = pl_calloc_ptr(k, k->size2, k->randomat);
+    k->calcmat  = pl_calloc_ptr(k, k->size2, k->calcmat);
+    k->gaussmat = pl_calloc_ptr(k, k->size2, k->gaussmat);
+    k->blockmin = pl_calloc_ptr(k, k->num_blocks, k->blockmin);
+    k->unimat   = pl_calloc_ptr(k, k->size2, k->unimat);
 
     k->gauss_radius = k->size / 2 - 1;
     k->gauss_middle = XY(k, k->gauss_radius, k->gauss_radius);
@@ -88,9 +99,6 @@ static void makegauss(struct ctx *k, unsigned int sizeb)
     unsigned int gauss_size = k->gauss_radius * 2 + 1;
     unsigned int gauss_size2 = gauss_size * gauss_size;
 
-    for (index_t c = 0; c < k->size2; c++)
-        k->gauss[c] = 0;
-
     double sigma = -log(1.5 / (double) UINT64_MAX * gauss_size2) / k->gauss_radius;
 
     for (index_t gy = 0; gy <= k->gauss_radius; gy++) {
@@ -111,6 +119,8 @@ static void makegauss(struct ctx *k, unsigned int sizeb)
         }
     }
 
+    memcpy(k->gauss + k->size2, k->gauss, k->size2 * sizeof(k->gauss[0]));
+
 #ifndef NDEBUG
     uint64_t total = 0;
     for (index_t c = 0; c < k->size2; c++) {
@@ -121,37 +131,47 @@ static void makegauss(struct ctx *k, unsigned int sizeb)
 #endif
 }
 
+// Adds the gaussian centered at `c` to the energy of all entries, and
+// incrementally updates the per-block minimum in the same sweep. The inner
+// loop is kept branchless so that it can be vectorized by the compiler.
 static void setbit(struct ctx *k, index_t c)
 {
     if (k->calcmat[c])
         return;
     k->calcmat[c] = true;
-    uint64_t *m = k->gaussmat;
-    uint64_t *me = k->gaussmat + k->size2;
-    uint64_t *g = k->gauss + WRAP_SIZE2(k, k->gauss_middle + k->size2 - c);
-    uint64_t *ge = k->gauss + k->size2;
-    while (g < ge)
-        *m++ += *g++;
-    g = k->gauss;
-    while (m < me)
-        *m++ += *g++;
+
+    const uint64_t *restrict g = k->gauss + WRAP_SIZE2(k, k->gauss_middle + k->size2 - c);
+    const bool *restrict set = k->calcmat;
+    uint64_t *restrict m = k->gaussmat;
+    const unsigned int block = k->block;
+
+    for (index_t b = 0; b < k->num_blocks; b++) {
+        uint64_t min = UINT64_MAX;
+        for (index_t i = b * block; i < (b + 1) * block; i++) {
+            uint64_t total = m[i] + g[i];
+            m[i] = total;
+            total |= -(uint64_t) set[i]; // exclude already set entries
+            min = total < min ? total : min;
+        }
+        k->blockmin[b] = min;
+    }
 }
 
 static index_t getmin(struct ctx *k)
 {
     uint64_t min = UINT64_MAX;
+    for (index_t b = 0; b < k->num_blocks; b++)
+        min = PL_MIN(min, k->blockmin[b]);
+
+    // Only blocks containing the minimum need to be searched for candidates
     index_t resnum = 0;
     unsigned int size2 = k->size2;
-    for (index_t c = 0; c < size2; c++) {
-        if (k->calcmat[c])
+    for (index_t b = 0; b < k->num_blocks; b++) {
+        if (k->blockmin[b] != min)
             continue;
-        uint64_t total = k->gaussmat[c];
-        if (total <= min) {
-            if (total != min) {
-                min = total;
-                resnum = 0;
-            }
-            k->randomat[resnum++] = c;
+        for (index_t c = b * k->block; c < (b + 1) * k->block; c++) {
+            if (!k->calcmat[c] && k->gaussmat[c] == min)
+                k->randomat[resnum++] = c;
         }
     }
     assert(resnum > 0);
@@ -174,7 +194,7 @@ static void makeuniform(struct ctx *k)
 
 void pl_generate_blue_noise(float *data, int size)
 {
-    pl_assert(size > 0);
+    pl_assert(size > 0 && size <= MAX_SIZE);
     int shift = PL_LOG2(size);
 
     pl_assert((1 << shift) == size);
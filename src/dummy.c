@@ -263,6 +263,10 @@ static bool dumb_tex_upload(pl_gpu gpu, const struct pl_tex_transfer_params *par
     struct tex_priv *p = PL_PRIV(tex);
     pl_assert(p->data);
 
+    // Respect the configured buffer size limits, like real GPUs do
+    if (!params->buf && pl_tex_transfer_size(params) > gpu->limits.max_buf_size)
+        return pl_tex_upload_pbo(gpu, params);
+
     const uint8_t *src = params->ptr;
     uint8_t *dst = p->data;
     if (params->buf) {
@@ -273,13 +277,13 @@ static bool dumb_tex_upload(pl_gpu gpu, const struct pl_tex_transfer_params *par
     size_t texel_size = tex->params.format->texel_size;
     size_t row_size = pl_rect_w(params->rc) * texel_size;
     for (int z = params->rc.z0; z < params->rc.z1; z++) {
-        size_t src_plane = z * params->depth_pitch;
+        size_t src_plane = (z - params->rc.z0) * params->depth_pitch;
         size_t dst_plane = z * tex->params.h * tex->params.w * texel_size;
         for (int y = params->rc.y0; y < params->rc.y1; y++) {
-            size_t src_row = src_plane + y * params->row_pitch;
+            size_t src_row = src_plane + (y - params->rc.y0) * params->row_pitch;
             size_t dst_row = dst_plane + y * tex->params.w * texel_size;
             size_t pos = params->rc.x0 * texel_size;
-            memcpy(&dst[dst_row + pos], &src[src_row + pos], row_size);
+            memcpy(&dst[dst_row + pos], &src[src_row], row_size);
         }
     }
 
@@ -292,6 +296,9 @@ static bool dumb_tex_download(pl_gpu gpu, const struct pl_tex_transfer_params *p
     struct tex_priv *p = PL_PRIV(tex);
     pl_assert(p->data);
 
+    if (!params->buf && pl_tex_transfer_size(params) > gpu->limits.max_buf_size)
+        return pl_tex_download_pbo(gpu, params);
+
     const uint8_t *src = p->data;
     uint8_t *dst = params->ptr;
     if (params->buf) {
@@ -303,12 +310,12 @@ static bool dumb_tex_download(pl_gpu gpu, const struct pl_tex_transfer_params *p
     size_t row_size = pl_rect_w(params->rc) * texel_size;
     for (int z = params->rc.z0; z < params->rc.z1; z++) {
         size_t src_plane = z * tex->params.h * tex->params.w * texel_size;
-        size_t dst_plane = z * params->depth_pitch;
+        size_t dst_plane = (z - params->rc.z0) * params->depth_pitch;
         for (int y = params->rc.y0; y < params->rc.y1; y++) {
             size_t src_row = src_plane + y * tex->params.w * texel_size;
-            size_t dst_row = dst_plane + y * params->row_pitch;
+            size_t dst_row = dst_plane + (y - params->rc.y0) * params->row_pitch;
             size_t pos = params->rc.x0 * texel_size;
-            memcpy(&dst[dst_row + pos], &src[src_row + pos], row_size);
+            memcpy(&dst[dst_row], &src[src_row + pos], row_size);
         }
     }
 
@@ -443,10 +443,16 @@ void pl_gamut_map_generate(float *out, const struct pl_gamut_map_params *params)
 }
 
 void pl_gamut_map_sample(float x[3], const struct pl_gamut_map_params *params)
+{
+    pl_gamut_map_sample_n(x, 1, params);
+}
+
+void pl_gamut_map_sample_n(float *x, int num, const struct pl_gamut_map_params *params)
 {
     struct pl_gamut_map_params fixed = *params;
     fix_constants(&fixed.constants);
-    fixed.lut_size_I = fixed.lut_size_C = fixed.lut_size_h = 1;
+    fixed.lut_size_I = num;
+    fixed.lut_size_C = fixed.lut_size_h = 1;
     fixed.lut_stride = 3;
 
     FUN(params).map(x, &fixed);
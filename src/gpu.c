@@ -27,6 +27,8 @@ void pl_gpu_destroy(pl_gpu gpu)
 
     struct pl_gpu_fns *impl = PL_PRIV(gpu);
     pl_dispatch_destroy(&impl->dp);
+    pl_staging_pool_destroy(gpu);
+    pl_mem_budget_destroy(gpu);
     impl->destroy(gpu);
 }
 
@@ -186,6 +188,23 @@ static inline bool check_mod(pl_gpu gpu, pl_fmt fmt, uint64_t mod)
     return false;
 }
 
+// Approximate size (in bytes) of the memory backing a texture
+static size_t tex_size(const struct pl_tex_params *params)
+{
+    const int w = params->w, h = PL_MAX(params->h, 1), d = PL_MAX(params->d, 1);
+    pl_fmt fmt = params->format;
+    if (!fmt->num_planes)
+        return (size_t) w * h * d * fmt->texel_size;
+
+    size_t size = 0;
+    for (int i = 0; i < fmt->num_planes; i++) {
+        const struct pl_fmt_plane *plane = &fmt->planes[i];
+        size += (size_t) PL_RSHIFT_UP(w, plane->shift_x) *
+                PL_RSHIFT_UP(h, plane->shift_y) * d * plane->format->texel_size;
+    }
+    return size;
+}
+
 pl_tex pl_tex_create(pl_gpu gpu, const struct pl_tex_params *params)
 {
     require(params->format);
@@ -255,7 +274,10 @@ pl_tex pl_tex_create(pl_gpu gpu, const struct pl_tex_params *params)
     require(!params->blit_dst   || fmt_caps & PL_FMT_CAP_BLITTABLE);
 
     const struct pl_gpu_fns *impl = PL_PRIV(gpu);
-    return impl->tex_create(gpu, params);
+    pl_tex tex = impl->tex_create(gpu, params);
+    if (tex && !params->import_handle)
+        pl_mem_budget_add(gpu, tex, params->debug_tag, tex_size(params), true);
+    return tex;
 
 error:
     if (params->debug_tag)
@@ -269,6 +291,7 @@ void pl_tex_destroy(pl_gpu gpu, pl_tex *tex)
         return;
 
     const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    pl_mem_budget_remove(gpu, *tex);
     impl->tex_destroy(gpu, *tex);
     *tex = NULL;
 }
@@ -609,6 +632,8 @@ pl_buf pl_buf_create(pl_gpu gpu, const struct pl_buf_params *params)
     pl_buf buf = impl->buf_create(gpu, params);
     if (buf)
         require(!params->host_mapped || buf->data);
+    if (buf && !params->import_handle)
+        pl_mem_budget_add(gpu, buf, params->debug_tag, params->size, false);
 
     return buf;
 
@@ -624,6 +649,7 @@ void pl_buf_destroy(pl_gpu gpu, pl_buf *buf)
         return;
 
     const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    pl_mem_budget_remove(gpu, *buf);
     impl->buf_destroy(gpu, *buf);
     *buf = NULL;
 }
@@ -1022,7 +1048,7 @@ static void log_spec_constants(pl_log log, enum pl_log_level lev,
     }
 }
 
-pl_pass pl_pass_create(pl_gpu gpu, const struct pl_pass_params *params)
+static bool pass_params_valid(pl_gpu gpu, const struct pl_pass_params *params)
 {
     require(params->glsl_shader);
     switch(params->type) {
@@ -1081,6 +1107,23 @@ pl_pass pl_pass_create(pl_gpu gpu, const struct pl_pass_params *params)
 
     log_shader_sources(gpu->log, PL_LOG_DEBUG, params);
     log_spec_constants(gpu->log, PL_LOG_DEBUG, params, params->constant_data);
+    return true;
+
+error:
+    return false;
+}
+
+static void pass_create_failed(pl_gpu gpu, const struct pl_pass_params *params)
+{
+    log_shader_sources(gpu->log, PL_LOG_ERR, params);
+    pl_log_stack_trace(gpu->log, PL_LOG_ERR);
+    pl_debug_abort();
+}
+
+pl_pass pl_pass_create(pl_gpu gpu, const struct pl_pass_params *params)
+{
+    if (!pass_params_valid(gpu, params))
+        goto error;
 
     const struct pl_gpu_fns *impl = PL_PRIV(gpu);
     pl_pass pass = impl->pass_create(gpu, params);
@@ -1090,12 +1133,53 @@ pl_pass pl_pass_create(pl_gpu gpu, const struct pl_pass_params *params)
     return pass;
 
 error:
-    log_shader_sources(gpu->log, PL_LOG_ERR, params);
-    pl_log_stack_trace(gpu->log, PL_LOG_ERR);
-    pl_debug_abort();
+    pass_create_failed(gpu, params);
     return NULL;
 }
 
+int pl_pass_create_batch(pl_gpu gpu, const struct pl_pass_params *params,
+                         int num, pl_pass *out)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    int num_created = 0;
+    if (!impl->pass_create_batch) {
+        for (int i = 0; i < num; i++)
+            num_created += !!(out[i] = pl_pass_create(gpu, &params[i]));
+        return num_created;
+    }
+
+    // Validate everything up front, and only hand the valid passes to the
+    // backend
+    struct pl_pass_params *valid = pl_calloc_ptr(NULL, num, valid);
+    pl_pass *passes = pl_calloc_ptr(valid, num, passes);
+    int *index = pl_calloc_ptr(valid, num, index);
+    int num_valid = 0;
+    for (int i = 0; i < num; i++) {
+        out[i] = NULL;
+        if (pass_params_valid(gpu, &params[i])) {
+            index[num_valid] = i;
+            valid[num_valid++] = params[i];
+        } else {
+            pass_create_failed(gpu, &params[i]);
+        }
+    }
+
+    if (num_valid)
+        impl->pass_create_batch(gpu, valid, num_valid, passes);
+
+    for (int n = 0; n < num_valid; n++) {
+        const int i = index[n];
+        if ((out[i] = passes[n])) {
+            num_created++;
+        } else {
+            pass_create_failed(gpu, &params[i]);
+        }
+    }
+
+    pl_free(valid);
+    return num_created;
+}
+
 void pl_pass_destroy(pl_gpu gpu, pl_pass *pass)
 {
     if (!*pass)
@@ -44,6 +44,12 @@ struct pl_gpu_fns {
     // Internal cache, or NULL. Set by the user (via pl_gpu_set_cache).
     _Atomic(pl_cache) cache;
 
+    // Pool of recycled staging buffers, used by pl_tex_upload/download_pbo
+    struct pl_staging_pool *staging;
+
+    // Memory accounting, see `pl_gpu_set_mem_budget`
+    struct pl_mem_budget *budget;
+
     // Destructors: These also free the corresponding objects, but they
     // must not be called on NULL. (The NULL checks are done by the pl_*_destroy
     // wrappers)
@@ -68,6 +74,7 @@ struct pl_gpu_fns {
     GPU_PFN(buf_poll); // optional: if NULL, buffers are always free to use
     GPU_PFN(desc_namespace);
     GPU_PFN(pass_create);
+    GPU_PFN(pass_create_batch); // optional: if NULL, passes are created in order
     GPU_PFN(pass_run);
     GPU_PFN(timer_create); // optional
     GPU_PFN(timer_query); // optional
@@ -126,8 +133,52 @@ int pl_tex_transfer_slices(pl_gpu gpu, pl_fmt texel_fmt,
                            const struct pl_tex_transfer_params *params,
                            struct pl_tex_transfer_params **out_slices);
 
+// Staging buffer pool, internally used by pl_tex_upload/download_pbo. Buffers
+// are grouped into size classes and recycled once `pl_buf_poll` reports them
+// as idle. The total size of the idle buffers held by the pool is capped.
+//
+// `pl_staging_get` returns a host-writable (or host-readable, if `readback`)
+// buffer of at least `size` bytes, or NULL on failure. The buffer is also
+// host-mapped, if the size permits. Buffers must be returned with
+// `pl_staging_release`, which also accepts (and ignores) NULL. Once the pool
+// has been destroyed, these fall back to plain `pl_buf_create/destroy`, since
+// completion callbacks may still release buffers while the GPU is destroyed.
+pl_buf pl_staging_get(pl_gpu gpu, size_t size, bool readback);
+void pl_staging_release(pl_gpu gpu, pl_buf *buf);
+
+struct pl_staging_stats {
+    int num_bufs;       // number of idle buffers currently held by the pool
+    size_t size;        // total size of these buffers
+    uint64_t hits;      // number of requests served from the pool
+    uint64_t misses;    // number of requests requiring a new buffer
+};
+
+struct pl_staging_stats pl_staging_stats(pl_gpu gpu);
+
+// Frees all buffers held by the pool. Called by `pl_gpu_destroy`.
+void pl_staging_pool_destroy(pl_gpu gpu);
+
+// Memory budget accounting. Textures and buffers are registered when created
+// by `pl_tex/buf_create`, and unregistered when destroyed. Objects which were
+// never registered (e.g. wrapped textures, or objects created internally by
+// the backend before `pl_gpu_finalize`) are ignored.
+struct pl_mem_budget *pl_mem_budget_create(pl_gpu gpu);
+void pl_mem_budget_destroy(pl_gpu gpu);
+void pl_mem_budget_add(pl_gpu gpu, const void *obj, pl_debug_tag tag,
+                       size_t size, bool tex);
+void pl_mem_budget_remove(pl_gpu gpu, const void *obj);
+
+// Returns the number of bytes by which the budget is currently exceeded, or 0
+// if there is no budget. Caches should check this at convenient points (e.g.
+// once per frame) and release their least recently used resources until it
+// returns 0, reporting the number of released objects via
+// `pl_mem_budget_evicted`.
+size_t pl_mem_budget_excess(pl_gpu gpu);
+void pl_mem_budget_evicted(pl_gpu gpu, int num);
+
 // Helper that wraps pl_tex_upload/download using texture upload buffers to
-// ensure that params->buf is always set.
+// ensure that params->buf is always set. Transfers exceeding the maximum
+// buffer size are split into multiple slices.
 bool pl_tex_upload_pbo(pl_gpu gpu, const struct pl_tex_transfer_params *params);
 bool pl_tex_download_pbo(pl_gpu gpu, const struct pl_tex_transfer_params *params);
 
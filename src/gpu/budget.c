@@ -0,0 +1,296 @@
+/*
+ * This file is part of libplacebo.
+ *
+ * libplacebo is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplacebo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplacebo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "common.h"
+#include "gpu.h"
+#include "pl_thread.h"
+
+// A single tracked texture or buffer
+struct budget_obj {
+    const void *obj;    // or NULL for empty hash table slots
+    size_t size;
+    int entry;          // index into `pl_mem_budget.entries`
+    bool tex;
+};
+
+struct pl_mem_budget {
+    pl_mutex lock;
+    size_t budget;
+    size_t total;
+    size_t peak;
+    size_t tex_size;
+    size_t buf_size;
+    uint64_t evictions;
+    bool exceeded;      // budget was exceeded (and reported) already
+
+    PL_ARRAY(struct pl_gpu_mem_entry) entries;
+
+    // Open-addressing hash table of all live objects, with linear probing
+    struct budget_obj *objs;
+    size_t num_objs;
+    size_t mask;        // table size minus one, or 0 if not allocated
+};
+
+static inline size_t obj_hash(const struct pl_mem_budget *b, const void *obj)
+{
+    uint64_t h = (uintptr_t) obj;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdLLU;
+    h ^= h >> 33;
+    return h & b->mask;
+}
+
+static struct budget_obj *obj_find(struct pl_mem_budget *b, const void *obj)
+{
+    if (!b->mask)
+        return NULL;
+
+    for (size_t i = obj_hash(b, obj);; i = (i + 1) & b->mask) {
+        if (b->objs[i].obj == obj)
+            return &b->objs[i];
+        if (!b->objs[i].obj)
+            return NULL;
+    }
+}
+
+static void obj_insert(struct pl_mem_budget *b, struct budget_obj obj)
+{
+    // Keep the load factor below 50%
+    if (2 * (b->num_objs + 1) > b->mask + 1) {
+        struct budget_obj *old = b->objs;
+        const size_t old_size = b->mask ? b->mask + 1 : 0;
+        const size_t new_size = PL_MAX(old_size * 2, 64);
+        b->objs = pl_calloc_ptr(b, new_size, b->objs);
+        b->mask = new_size - 1;
+        b->num_objs = 0;
+        for (size_t i = 0; i < old_size; i++) {
+            if (old[i].obj)
+                obj_insert(b, old[i]);
+        }
+        pl_free(old);
+    }
+
+    size_t i = obj_hash(b, obj.obj);
+    while (b->objs[i].obj)
+        i = (i + 1) & b->mask;
+    b->objs[i] = obj;
+    b->num_objs++;
+}
+
+// Removes the entry at `slot`, shifting back any following entries which
+// would otherwise become unreachable
+static void obj_remove(struct pl_mem_budget *b, struct budget_obj *slot)
+{
+    size_t i = slot - b->objs, j = i;
+    for (;;) {
+        j = (j + 1) & b->mask;
+        if (!b->objs[j].obj)
+            break;
+        const size_t k = obj_hash(b, b->objs[j].obj);
+        // Move `j` into the hole at `i` unless its home `k` lies in (i, j]
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+            continue;
+        b->objs[i] = b->objs[j];
+        i = j;
+    }
+
+    b->objs[i] = (struct budget_obj) {0};
+    b->num_objs--;
+}
+
+static int find_entry(struct pl_mem_budget *b, pl_debug_tag tag)
+{
+    tag = PL_DEF(tag, "unknown");
+    for (int i = 0; i < b->entries.num; i++) {
+        pl_debug_tag other = b->entries.elem[i].tag;
+        if (other == tag || strcmp(other, tag) == 0)
+            return i;
+    }
+
+    PL_ARRAY_APPEND(b, b->entries, (struct pl_gpu_mem_entry) { .tag = tag });
+    return b->entries.num - 1;
+}
+
+struct pl_mem_budget *pl_mem_budget_create(pl_gpu gpu)
+{
+    struct pl_mem_budget *b = pl_zalloc_ptr((void *) gpu, b);
+    pl_mutex_init(&b->lock);
+    return b;
+}
+
+void pl_mem_budget_destroy(pl_gpu gpu)
+{
+    struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    if (!impl->budget)
+        return;
+
+    pl_mutex_destroy(&impl->budget->lock);
+    pl_free_ptr(&impl->budget);
+}
+
+void pl_mem_budget_add(pl_gpu gpu, const void *obj, pl_debug_tag tag,
+                       size_t size, bool tex)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_mem_budget *b = impl->budget;
+    if (!b || !obj)
+        return; // backend-internal objects created before `pl_gpu_finalize`
+
+    pl_mutex_lock(&b->lock);
+    const int idx = find_entry(b, tag);
+    struct pl_gpu_mem_entry *entry = &b->entries.elem[idx];
+    entry->size += size;
+    entry->num_tex += tex;
+    entry->num_buf += !tex;
+    obj_insert(b, (struct budget_obj) {
+        .obj   = obj,
+        .size  = size,
+        .entry = idx,
+        .tex   = tex,
+    });
+
+    *(tex ? &b->tex_size : &b->buf_size) += size;
+    b->total += size;
+    b->peak = PL_MAX(b->peak, b->total);
+
+    const size_t budget = b->budget;
+    const bool report = budget && b->total > budget && !b->exceeded;
+    b->exceeded |= report;
+    pl_mutex_unlock(&b->lock);
+
+    if (report) {
+        PL_INFO(gpu, "Memory budget of %zu bytes exceeded while allocating "
+                "%zu bytes for: %s", budget, size, PL_DEF(tag, "unknown"));
+        pl_gpu_print_mem_report(gpu, PL_LOG_INFO);
+    }
+}
+
+void pl_mem_budget_remove(pl_gpu gpu, const void *obj)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_mem_budget *b = impl->budget;
+    if (!b)
+        return; // before `pl_gpu_finalize` or during `pl_gpu_destroy`
+
+    pl_mutex_lock(&b->lock);
+    struct budget_obj *slot = obj_find(b, obj);
+    if (slot) {
+        struct pl_gpu_mem_entry *entry = &b->entries.elem[slot->entry];
+        entry->size -= slot->size;
+        entry->num_tex -= slot->tex;
+        entry->num_buf -= !slot->tex;
+        *(slot->tex ? &b->tex_size : &b->buf_size) -= slot->size;
+        b->total -= slot->size;
+        b->exceeded &= b->total > b->budget;
+        obj_remove(b, slot);
+    }
+    pl_mutex_unlock(&b->lock);
+}
+
+size_t pl_mem_budget_excess(pl_gpu gpu)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_mem_budget *b = impl->budget;
+
+    pl_mutex_lock(&b->lock);
+    size_t excess = 0;
+    if (b->budget && b->total > b->budget)
+        excess = b->total - b->budget;
+    pl_mutex_unlock(&b->lock);
+    return excess;
+}
+
+void pl_mem_budget_evicted(pl_gpu gpu, int num)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_mem_budget *b = impl->budget;
+    if (!num)
+        return;
+
+    pl_mutex_lock(&b->lock);
+    b->evictions += num;
+    pl_mutex_unlock(&b->lock);
+}
+
+void pl_gpu_set_mem_budget(pl_gpu gpu, size_t budget)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_mem_budget *b = impl->budget;
+
+    pl_mutex_lock(&b->lock);
+    b->budget = budget;
+    b->exceeded = false;
+    pl_mutex_unlock(&b->lock);
+}
+
+static int cmp_entry_size(const void *pa, const void *pb)
+{
+    const struct pl_gpu_mem_entry *a = pa, *b = pb;
+    return PL_CMP(b->size, a->size);
+}
+
+struct pl_gpu_mem_report *pl_gpu_mem_report(pl_gpu gpu)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_mem_budget *b = impl->budget;
+    struct pl_gpu_mem_report *report = pl_zalloc_ptr(NULL, report);
+    struct pl_gpu_mem_entry *entries;
+
+    pl_mutex_lock(&b->lock);
+    entries = pl_calloc_ptr(report, b->entries.num, entries);
+    for (int i = 0; i < b->entries.num; i++) {
+        const struct pl_gpu_mem_entry *entry = &b->entries.elem[i];
+        if (entry->num_tex || entry->num_buf)
+            entries[report->num_entries++] = *entry;
+    }
+
+    report->budget    = b->budget;
+    report->total     = b->total;
+    report->peak      = b->peak;
+    report->tex_size  = b->tex_size;
+    report->buf_size  = b->buf_size;
+    report->evictions = b->evictions;
+    pl_mutex_unlock(&b->lock);
+
+    qsort(entries, report->num_entries, sizeof(*entries), cmp_entry_size);
+    report->entries = entries;
+    return report;
+}
+
+void pl_gpu_mem_report_free(struct pl_gpu_mem_report **report)
+{
+    pl_free_ptr(report);
+}
+
+void pl_gpu_print_mem_report(pl_gpu gpu, enum pl_log_level lev)
+{
+    if (!pl_msg_test(gpu->log, lev))
+        return;
+
+    struct pl_gpu_mem_report *report = pl_gpu_mem_report(gpu);
+    PL_MSG(gpu, lev, "GPU memory usage: %zu bytes total (%zu textures, %zu "
+           "buffers), peak %zu, budget %zu, evictions %"PRIu64,
+           report->total, report->tex_size, report->buf_size, report->peak,
+           report->budget, report->evictions);
+    for (int i = 0; i < report->num_entries; i++) {
+        const struct pl_gpu_mem_entry *entry = &report->entries[i];
+        PL_MSG(gpu, lev, "    %12zu bytes: %3d tex %3d buf  [%s]",
+               entry->size, entry->num_tex, entry->num_buf, entry->tag);
+    }
+
+    pl_gpu_mem_report_free(&report);
+}
@@ -20,6 +20,7 @@
 #include "common.h"
 #include "shaders.h"
 #include "gpu.h"
+#include "pl_thread.h"
 
 // GPU-internal helpers
 
@@ -147,6 +148,161 @@ static void print_formats(pl_gpu gpu)
     }
 }
 
+enum {
+    STAGING_MIN_SIZE = 64 << 10,    // 64 KiB, smallest size class
+    STAGING_MAX_BUFS = 16,          // maximum number of idle buffers
+};
+
+#define STAGING_MAX_SIZE ((size_t) 256 << 20) // maximum total idle size
+
+struct pl_staging_pool {
+    pl_mutex lock;
+    PL_ARRAY(pl_buf) bufs; // ordered from least to most recently released
+    size_t size;
+    uint64_t hits, misses;
+};
+
+// Rounds up to the next size class. These are spaced a quarter octave apart,
+// which bounds the wasted space to 25%.
+static size_t staging_class_size(pl_gpu gpu, size_t size)
+{
+    size_t class = PL_MAX(size, STAGING_MIN_SIZE);
+    size_t step = STAGING_MIN_SIZE >> 2;
+    while ((step << 3) <= class)
+        step <<= 1;
+    class = PL_ALIGN2(class, step);
+    return PL_MAX(PL_MIN(class, gpu->limits.max_buf_size), size);
+}
+
+static bool staging_remove(struct pl_staging_pool *pool, pl_buf buf)
+{
+    for (int i = 0; i < pool->bufs.num; i++) {
+        if (pool->bufs.elem[i] == buf) {
+            PL_ARRAY_REMOVE_AT(pool->bufs, i);
+            pool->size -= buf->params.size;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+pl_buf pl_staging_get(pl_gpu gpu, size_t size, bool readback)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_staging_pool *pool = impl->staging;
+    const size_t class = staging_class_size(gpu, size);
+    if (!pool)
+        goto create;
+
+    // Collect the candidates first, since polling a buffer may run
+    // completion callbacks, which in turn may release buffers to the pool
+    pl_buf candidates[STAGING_MAX_BUFS];
+    int num_candidates = 0;
+    pl_mutex_lock(&pool->lock);
+    for (int i = 0; i < pool->bufs.num; i++) {
+        pl_buf buf = pool->bufs.elem[i];
+        if (buf->params.size != class)
+            continue;
+        if (buf->params.host_readable != readback)
+            continue;
+        if (num_candidates < PL_ARRAY_SIZE(candidates))
+            candidates[num_candidates++] = buf;
+    }
+    pl_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < num_candidates; i++) {
+        if (pl_buf_poll(gpu, candidates[i], 0))
+            continue; // still in use
+
+        pl_mutex_lock(&pool->lock);
+        bool ok = staging_remove(pool, candidates[i]);
+        pool->hits += ok;
+        pl_mutex_unlock(&pool->lock);
+        if (ok)
+            return candidates[i];
+    }
+
+    pl_mutex_lock(&pool->lock);
+    pool->misses++;
+    pl_mutex_unlock(&pool->lock);
+
+create:
+    // Map the buffers where possible, so that the host copies for sliced
+    // transfers can be done directly (and in parallel)
+    return pl_buf_create(gpu, pl_buf_params(
+        .size = class,
+        .host_writable = !readback,
+        .host_readable = readback,
+        .host_mapped = class <= gpu->limits.max_mapped_size,
+    ));
+}
+
+void pl_staging_release(pl_gpu gpu, pl_buf *pbuf)
+{
+    pl_buf buf = *pbuf;
+    if (!buf)
+        return;
+
+    *pbuf = NULL;
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_staging_pool *pool = impl->staging;
+    if (!pool || buf->params.size > STAGING_MAX_SIZE) {
+        // The pool may already be gone if this is called from a completion
+        // callback run during `pl_gpu_destroy`
+        pl_buf_destroy(gpu, &buf);
+        return;
+    }
+
+    pl_buf evicted[STAGING_MAX_BUFS + 1];
+    int num_evicted = 0;
+
+    pl_mutex_lock(&pool->lock);
+    PL_ARRAY_APPEND((void *) pool, pool->bufs, buf);
+    pool->size += buf->params.size;
+    while (pool->size > STAGING_MAX_SIZE || pool->bufs.num > STAGING_MAX_BUFS) {
+        pl_buf old = pool->bufs.elem[0];
+        staging_remove(pool, old);
+        evicted[num_evicted++] = old;
+    }
+    pl_mutex_unlock(&pool->lock);
+
+    // Destroy these outside the lock, for the same reason as above
+    for (int i = 0; i < num_evicted; i++)
+        pl_buf_destroy(gpu, &evicted[i]);
+}
+
+struct pl_staging_stats pl_staging_stats(pl_gpu gpu)
+{
+    const struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_staging_pool *pool = impl->staging;
+    if (!pool)
+        return (struct pl_staging_stats) {0};
+
+    pl_mutex_lock(&pool->lock);
+    struct pl_staging_stats stats = {
+        .num_bufs   = pool->bufs.num,
+        .size       = pool->size,
+        .hits       = pool->hits,
+        .misses     = pool->misses,
+    };
+    pl_mutex_unlock(&pool->lock);
+    return stats;
+}
+
+void pl_staging_pool_destroy(pl_gpu gpu)
+{
+    struct pl_gpu_fns *impl = PL_PRIV(gpu);
+    struct pl_staging_pool *pool = impl->staging;
+    if (!pool)
+        return;
+
+    for (int i = 0; i < pool->bufs.num; i++)
+        pl_buf_destroy(gpu, &pool->bufs.elem[i]);
+    pl_mutex_destroy(&pool->lock);
+    pl_free_ptr(&impl->staging);
+}
+
 pl_gpu pl_gpu_finalize(struct pl_gpu_t *gpu)
 {
     // Sort formats
@@ -281,7 +437,10 @@ pl_gpu pl_gpu_finalize(struct pl_gpu_t *gpu)
     // Finally, create a `pl_dispatch` object for internal operations
     struct pl_gpu_fns *impl = PL_PRIV(gpu);
     atomic_init(&impl->cache, NULL);
+    impl->budget = pl_mem_budget_create(gpu);
     impl->dp = pl_dispatch_create(gpu->log, gpu);
+    impl->staging = pl_zalloc_ptr(gpu, impl->staging);
+    pl_mutex_init(&impl->staging->lock);
     return gpu;
 }
 
@@ -480,18 +639,12 @@ size_t pl_tex_transfer_size(const struct pl_tex_transfer_params *par)
     return (d - 1) * par->depth_pitch + (h - 1) * par->row_pitch + w * pixel_pitch;
 }
 
-int pl_tex_transfer_slices(pl_gpu gpu, pl_fmt texel_fmt,
-                           const struct pl_tex_transfer_params *params,
+static int transfer_slices(const struct pl_tex_transfer_params *params,
+                           size_t max_size,
                            struct pl_tex_transfer_params **out_slices)
 {
     PL_ARRAY(struct pl_tex_transfer_params) slices = {0};
-    size_t max_size = params->buf ? gpu->limits.max_buf_size : SIZE_MAX;
-
     pl_fmt fmt = params->tex->params.format;
-    if (fmt->emulated && texel_fmt) {
-        size_t max_texel = gpu->limits.max_buffer_texels * texel_fmt->texel_size;
-        max_size = PL_MIN(gpu->limits.max_ssbo_size, max_texel);
-    }
 
     int slice_w = pl_rect_w(params->rc);
     int slice_h = pl_rect_h(params->rc);
@@ -538,12 +691,264 @@ int pl_tex_transfer_slices(pl_gpu gpu, pl_fmt texel_fmt,
     return slices.num;
 }
 
+int pl_tex_transfer_slices(pl_gpu gpu, pl_fmt texel_fmt,
+                           const struct pl_tex_transfer_params *params,
+                           struct pl_tex_transfer_params **out_slices)
+{
+    size_t max_size = params->buf ? gpu->limits.max_buf_size : SIZE_MAX;
+
+    pl_fmt fmt = params->tex->params.format;
+    if (fmt->emulated && texel_fmt) {
+        size_t max_texel = gpu->limits.max_buffer_texels * texel_fmt->texel_size;
+        max_size = PL_MIN(gpu->limits.max_ssbo_size, max_texel);
+    }
+
+    return transfer_slices(params, max_size, out_slices);
+}
+
+// Host memory copy, for the staging of sliced transfers
+struct xfer_copy {
+    void *dst;
+    const void *src;
+    size_t size;
+};
+
+struct xfer_copy_args {
+    const struct xfer_copy *copies;
+    int start, count;
+};
+
+static PL_THREAD_VOID xfer_copy_thread(void *priv)
+{
+    const struct xfer_copy_args *args = priv;
+    for (int i = args->start; i < args->start + args->count; i++) {
+        const struct xfer_copy *c = &args->copies[i];
+        memcpy(c->dst, c->src, c->size);
+    }
+
+    PL_THREAD_RETURN();
+}
+
+// Performs a list of independent copies, spread across multiple threads
+static void xfer_copies_run(const struct xfer_copy *copies, int num)
+{
+    enum { MAX_WORKERS = 8 };
+    struct xfer_copy_args args[MAX_WORKERS];
+
+    const int num_per_worker = PL_DIV_UP(num, MAX_WORKERS);
+    const int num_workers = PL_DIV_UP(num, num_per_worker);
+    for (int i = 0; i < num_workers; i++) {
+        const int start = i * num_per_worker;
+        args[i] = (struct xfer_copy_args) {
+            .copies = copies,
+            .start  = start,
+            .count  = PL_MIN(num_per_worker, num - start),
+        };
+    }
+
+    if (num_workers == 1) {
+        xfer_copy_thread(&args[0]);
+        return;
+    }
+
+    pl_thread workers[MAX_WORKERS] = {0};
+    for (int i = 0; i < num_workers; i++) {
+        if (pl_thread_create(&workers[i], xfer_copy_thread, &args[i]) != 0)
+            xfer_copy_thread(&args[i]); // fallback
+    }
+
+    for (int i = 0; i < num_workers; i++) {
+        if (!workers[i])
+            continue;
+        if (pl_thread_join(workers[i]) != 0)
+            xfer_copy_thread(&args[i]); // fallback
+    }
+}
+
+// Transfers exceeding the maximum buffer size are split into slices, each
+// staged via a separate buffer. The host copies for these are performed in
+// parallel (if the staging buffers are mapped), and all of the slices are
+// submitted together, followed by a single flush.
+static bool tex_upload_sliced(pl_gpu gpu, const struct pl_tex_transfer_params *params)
+{
+    struct pl_tex_transfer_params *slices = NULL;
+    int num_slices = transfer_slices(params, gpu->limits.max_buf_size, &slices);
+    struct xfer_copy *copies = pl_calloc_ptr(NULL, num_slices, copies);
+    bool ok = num_slices > 0, mapped = true;
+    for (int i = 0; ok && i < num_slices; i++) {
+        const size_t size = pl_tex_transfer_size(&slices[i]);
+        slices[i].buf = pl_staging_get(gpu, size, false);
+        if (!slices[i].buf) {
+            ok = false;
+            break;
+        }
+
+        mapped &= slices[i].buf->data != NULL;
+        copies[i] = (struct xfer_copy) {
+            .dst  = slices[i].buf->data,
+            .src  = slices[i].ptr,
+            .size = size,
+        };
+    }
+
+    if (ok) {
+        if (mapped) {
+            xfer_copies_run(copies, num_slices);
+        } else {
+            for (int i = 0; i < num_slices; i++)
+                pl_buf_write(gpu, slices[i].buf, 0, copies[i].src, copies[i].size);
+        }
+
+        // The data has been copied, so the caller's buffer is free to reuse
+        if (params->callback)
+            params->callback(params->priv);
+    }
+
+    for (int i = 0; i < num_slices; i++) {
+        if (ok) {
+            slices[i].ptr = NULL;
+            slices[i].buf_offset = 0;
+            ok = pl_tex_upload(gpu, &slices[i]);
+        }
+        pl_staging_release(gpu, &slices[i].buf);
+    }
+
+    if (ok)
+        pl_gpu_flush(gpu);
+
+    pl_free(copies);
+    pl_free(slices);
+    return ok;
+}
+
+struct sliced_download {
+    pl_gpu gpu;
+    pl_rc_t rc;
+    bool failed;
+    bool mapped;
+    int num_slices;
+    pl_buf *bufs;
+    struct xfer_copy *copies;
+    void (*callback)(void *priv);
+    void *priv;
+};
+
+// Returns false if this dropped the final reference, and the download failed
+static bool sliced_download_deref(struct sliced_download *ctx)
+{
+    if (!pl_rc_deref(&ctx->rc))
+        return true;
+
+    pl_gpu gpu = ctx->gpu;
+    if (!ctx->failed) {
+        if (ctx->mapped) {
+            xfer_copies_run(ctx->copies, ctx->num_slices);
+        } else {
+            for (int i = 0; i < ctx->num_slices; i++) {
+                const struct xfer_copy *c = &ctx->copies[i];
+                ctx->failed |= !pl_buf_read(gpu, ctx->bufs[i], 0, c->dst, c->size);
+            }
+        }
+
+        if (ctx->callback)
+            ctx->callback(ctx->priv);
+    }
+
+    bool ok = !ctx->failed;
+    for (int i = 0; i < ctx->num_slices; i++)
+        pl_staging_release(gpu, &ctx->bufs[i]);
+    pl_free(ctx);
+    return ok;
+}
+
+static void sliced_download_cb(void *priv)
+{
+    sliced_download_deref(priv);
+}
+
+static bool tex_download_sliced(pl_gpu gpu, const struct pl_tex_transfer_params *params)
+{
+    struct pl_tex_transfer_params *slices = NULL;
+    int num_slices = transfer_slices(params, gpu->limits.max_buf_size, &slices);
+
+    struct sliced_download *ctx = pl_alloc_ptr(NULL, ctx);
+    *ctx = (struct sliced_download) {
+        .gpu        = gpu,
+        .failed     = !num_slices,
+        .mapped     = true,
+        .num_slices = num_slices,
+        .bufs       = pl_calloc_ptr(ctx, num_slices, ctx->bufs),
+        .copies     = pl_calloc_ptr(ctx, num_slices, ctx->copies),
+        .callback   = params->callback,
+        .priv       = params->priv,
+    };
+
+    // The submitting thread holds one reference, and each pending slice one
+    pl_rc_init(&ctx->rc);
+
+    for (int i = 0; i < num_slices; i++) {
+        const size_t size = pl_tex_transfer_size(&slices[i]);
+        ctx->bufs[i] = pl_staging_get(gpu, size, true);
+        if (!ctx->bufs[i]) {
+            ctx->failed = true;
+            break;
+        }
+
+        ctx->mapped &= ctx->bufs[i]->data != NULL;
+        ctx->copies[i] = (struct xfer_copy) {
+            .dst  = slices[i].ptr,
+            .src  = ctx->bufs[i]->data,
+            .size = size,
+        };
+    }
+
+    for (int i = 0; !ctx->failed && i < num_slices; i++) {
+        slices[i].ptr = NULL;
+        slices[i].buf = ctx->bufs[i];
+        slices[i].buf_offset = 0;
+        if (params->callback) {
+            slices[i].callback = sliced_download_cb;
+            slices[i].priv = ctx;
+            pl_rc_ref(&ctx->rc);
+        }
+
+        if (!pl_tex_download(gpu, &slices[i])) {
+            if (params->callback)
+                (void) pl_rc_deref(&ctx->rc);
+            ctx->failed = true;
+        }
+    }
+
+    pl_free(slices);
+    if (ctx->failed) {
+        sliced_download_deref(ctx);
+        return false;
+    }
+
+    pl_gpu_flush(gpu);
+    if (!params->callback) {
+        for (int i = 0; i < num_slices; i++) {
+            while (pl_buf_poll(gpu, ctx->bufs[i], 10000000)) // 10 ms
+                PL_TRACE(gpu, "pl_tex_download: synchronous/blocking (slow path)");
+        }
+
+        // This drops the final reference, which performs the host copies
+        return sliced_download_deref(ctx);
+    }
+
+    sliced_download_deref(ctx);
+    return true;
+}
+
 bool pl_tex_upload_pbo(pl_gpu gpu, const struct pl_tex_transfer_params *params)
 {
     if (params->buf)
         return pl_tex_upload(gpu, params);
 
     const size_t size = pl_tex_transfer_size(params);
+    if (size > gpu->limits.max_buf_size)
+        return tex_upload_sliced(gpu, params);
+
     struct pl_tex_transfer_params fixed = *params;
     fixed.ptr = NULL;
 
@@ -572,13 +977,12 @@ bool pl_tex_upload_pbo(pl_gpu gpu, const struct pl_tex_transfer_params *params)
         pl_log_level_cap(gpu->log, PL_LOG_NONE);
     }
 
+    bool pooled = false;
     if (!fixed.buf) {
-        fixed.buf = pl_buf_create(gpu, pl_buf_params(
-            .size = size,
-            .host_writable = true,
-        ));
+        fixed.buf = pl_staging_get(gpu, size, false);
         if (!fixed.buf)
             return false;
+        pooled = true;
         pl_buf_write(gpu, fixed.buf, 0, params->ptr, size);
         if (params->callback)
             params->callback(params->priv);
@@ -586,13 +990,18 @@ bool pl_tex_upload_pbo(pl_gpu gpu, const struct pl_tex_transfer_params *params)
     }
 
     bool ok = pl_tex_upload(gpu, &fixed);
-    pl_buf_destroy(gpu, &fixed.buf);
+    if (pooled && ok) {
+        pl_staging_release(gpu, &fixed.buf);
+    } else {
+        pl_buf_destroy(gpu, &fixed.buf);
+    }
     return ok;
 }
 
 struct pbo_cb_ctx {
     pl_gpu gpu;
     pl_buf buf;
+    size_t size;
     void *ptr;
     void (*callback)(void *priv);
     void *priv;
@@ -601,8 +1010,8 @@ struct pbo_cb_ctx {
 static void pbo_download_cb(void *priv)
 {
     struct pbo_cb_ctx *p = priv;
-    pl_buf_read(p->gpu, p->buf, 0, p->ptr, p->buf->params.size);
-    pl_buf_destroy(p->gpu, &p->buf);
+    pl_buf_read(p->gpu, p->buf, 0, p->ptr, p->size);
+    pl_staging_release(p->gpu, &p->buf);
 
     // Run the original callback
     p->callback(p->priv);
@@ -615,6 +1024,9 @@ bool pl_tex_download_pbo(pl_gpu gpu, const struct pl_tex_transfer_params *params
         return pl_tex_download(gpu, params);
 
     const size_t size = pl_tex_transfer_size(params);
+    if (size > gpu->limits.max_buf_size)
+        return tex_download_sliced(gpu, params);
+
     pl_buf buf = NULL;
 
     // If we can import host pointers directly, we can avoid an extra memcpy
@@ -642,10 +1054,7 @@ bool pl_tex_download_pbo(pl_gpu gpu, const struct pl_tex_transfer_params *params
 
     if (!buf) {
         // Fallback when host pointer import is not supported
-        buf = pl_buf_create(gpu, pl_buf_params(
-            .size = size,
-            .host_readable = true,
-        ));
+        buf = pl_staging_get(gpu, size, true);
     }
 
     if (!buf)
@@ -662,6 +1071,7 @@ bool pl_tex_download_pbo(pl_gpu gpu, const struct pl_tex_transfer_params *params
         newparams.priv = pl_alloc_struct(NULL, struct pbo_cb_ctx, {
             .gpu = gpu,
             .buf = buf,
+            .size = size,
             .ptr = params->ptr,
             .callback = params->callback,
             .priv = params->priv,
@@ -688,7 +1098,7 @@ bool pl_tex_download_pbo(pl_gpu gpu, const struct pl_tex_transfer_params *params
     } else if (!params->callback) {
         // Synchronous read back to the host pointer
         ok = pl_buf_read(gpu, buf, 0, params->ptr, size);
-        pl_buf_destroy(gpu, &buf);
+        pl_staging_release(gpu, &buf);
     } else {
         // Nothing left to do here, the rest will be done by pbo_download_cb
         ok = true;
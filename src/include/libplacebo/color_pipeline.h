@@ -0,0 +1,99 @@
+/*
+ * This file is part of libplacebo.
+ *
+ * libplacebo is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * libplacebo is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with libplacebo.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LIBPLACEBO_COLOR_PIPELINE_H_
+#define LIBPLACEBO_COLOR_PIPELINE_H_
+
+#include <libplacebo/colorspace.h>
+#include <libplacebo/log.h>
+#include <libplacebo/shaders/colorspace.h>
+
+PL_API_BEGIN
+
+// CPU implementation of the color conversion pipeline used by the renderer:
+// decoding (e.g. YCbCr -> RGB), linearization, tone mapping, gamut mapping,
+// delinearization and encoding. This is mainly intended for processing small
+// numbers of pixels without a GPU (e.g. thumbnails, overlay colors), and as a
+// reference implementation to validate GPU output against.
+//
+// Note: The results closely match `pl_shader_color_map_ex`, but are not
+// bit-exact. In particular, gamut mapping is evaluated directly instead of
+// via a 3DLUT, and dynamic peak detection / contrast recovery (which require
+// whole-frame analysis) are not performed.
+typedef const struct pl_color_pipeline_t *pl_color_pipeline;
+
+struct pl_color_pipeline_params {
+    // Color representation and space of the input. `src_repr` is used to
+    // decode the input values to normalized RGB. Supported systems are
+    // RGB and all "simple" YCbCr-like systems (i.e. excluding BT.2020-C,
+    // BT.2100, XYZ and Dolby Vision).
+    struct pl_color_repr src_repr;
+    struct pl_color_space src_csp;
+
+    // Color representation and space of the output. Same restrictions apply.
+    struct pl_color_repr dst_repr;
+    struct pl_color_space dst_csp;
+
+    // Optional color adjustment, applied while decoding the input.
+    const struct pl_color_adjustment *color_adjustment;
+
+    // Tone and gamut mapping parameters, same as used by the renderer. If
+    // NULL, defaults to `pl_color_map_default_params`. Options that only
+    // affect visualization/debugging are ignored.
+    const struct pl_color_map_params *color_map_params;
+};
+
+#define pl_color_pipeline_params(...) (&(struct pl_color_pipeline_params) { __VA_ARGS__ })
+
+// Creates a color pipeline for a given conversion. All expensive setup
+// (e.g. generation of the tone mapping LUT) happens here, so the resulting
+// object should be reused when converting multiple buffers. Returns NULL if
+// the configuration is not supported.
+PL_API pl_color_pipeline pl_color_pipeline_create(pl_log log,
+                                                  const struct pl_color_pipeline_params *params);
+PL_API void pl_color_pipeline_destroy(pl_color_pipeline *pipe);
+
+enum pl_color_buf_type {
+    PL_COLOR_BUF_FLOAT,     // 32-bit floats, nominally in the range [0,1]
+    PL_COLOR_BUF_UINT16,    // 16-bit unsigned integers, normalized to [0,1]
+};
+
+// Describes the layout of a buffer of pixels. Both planar and interleaved
+// layouts are supported, by specifying a separate base pointer per channel
+// together with a common stride between consecutive pixels. For example,
+// packed RGBA floats would use `data = {p, p + 1, p + 2}` and a
+// `pixel_stride` of `4 * sizeof(float)`. Channels beyond the first three
+// (e.g. alpha) are left untouched.
+struct pl_color_buf {
+    enum pl_color_buf_type type;
+    void *data[3];
+    size_t pixel_stride;    // in bytes, or 0 for tightly packed planes
+};
+
+// Converts `num_pixels` pixels from `src` to `dst`, which may alias (for
+// in-place conversion). Large conversions are automatically spread across
+// multiple threads. Integer outputs are rounded and clamped.
+//
+// Thread-safety: Safe (the pipeline object itself is not modified)
+PL_API void pl_color_pipeline_apply(pl_color_pipeline pipe,
+                                    const struct pl_color_buf *src,
+                                    const struct pl_color_buf *dst,
+                                    size_t num_pixels);
+
+PL_API_END
+
+#endif // LIBPLACEBO_COLOR_PIPELINE_H_
@@ -31,8 +31,10 @@ PL_API void pl_generate_bayer_matrix(float *data, int size);
 // `size` must be a positive power of two no larger than 256. The resulting
 // texture will be roughly uniformly distributed within the range [0,1).
 //
-// Note: This function is very, *very* slow for large sizes. Generating a
-// dither matrix with size 256 can take several seconds on a modern processor.
+// Note: This function is slow for large sizes, since the runtime grows with
+// the square of the number of entries. Generating a dither matrix with size
+// 128 takes a fraction of a second, but size 256 can take several seconds on
+// a modern processor.
 PL_API void pl_generate_blue_noise(float *data, int size);
 
 // Defines the border of all error diffusion kernels
@@ -261,6 +261,52 @@ typedef const struct pl_gpu_t {
 // this early, before creating any passes.
 PL_API void pl_gpu_set_cache(pl_gpu gpu, pl_cache cache);
 
+// Memory accounting. libplacebo keeps track of the (approximate) size of all
+// textures and buffers created on a `pl_gpu`, grouped by their `debug_tag`.
+// Imported and wrapped objects are not included.
+//
+// Optionally, a memory budget (in bytes) may be set. Whenever the total
+// exceeds it, the caches associated with this GPU (the `pl_renderer` FBO and
+// frame mixing caches, the `pl_queue` texture cache and the `pl_dispatch`
+// pass cache) release their least recently used resources, at their next
+// opportunity (e.g. the next `pl_render_image` call). Intermediate textures
+// used by the most recent frame are never released, so this is a soft limit.
+// Setting `budget = 0` (the default) disables this mechanism.
+//
+// Thread-safety: Safe
+PL_API void pl_gpu_set_mem_budget(pl_gpu gpu, size_t budget);
+
+struct pl_gpu_mem_entry {
+    pl_debug_tag tag;   // call site which created these objects
+    size_t size;        // total size of all live objects, in bytes
+    int num_tex;        // number of live textures
+    int num_buf;        // number of live buffers
+};
+
+struct pl_gpu_mem_report {
+    size_t budget;      // currently configured budget, or 0
+    size_t total;       // total size of all live textures and buffers
+    size_t peak;        // highest value of `total` observed so far
+    size_t tex_size;    // total size of all live textures
+    size_t buf_size;    // total size of all live buffers
+    uint64_t evictions; // number of cached objects released due to the budget
+
+    // Breakdown per debug tag, sorted by descending size
+    const struct pl_gpu_mem_entry *entries;
+    int num_entries;
+};
+
+// Returns a snapshot of the current memory usage, which must be freed with
+// `pl_gpu_mem_report_free` when no longer needed.
+//
+// Thread-safety: Safe
+PL_API struct pl_gpu_mem_report *pl_gpu_mem_report(pl_gpu gpu);
+PL_API void pl_gpu_mem_report_free(struct pl_gpu_mem_report **report);
+
+// Logs the current memory usage report. This also happens automatically (at
+// PL_LOG_INFO) whenever the budget is first exceeded.
+PL_API void pl_gpu_print_mem_report(pl_gpu gpu, enum pl_log_level lev);
+
 enum pl_fmt_type {
     PL_FMT_UNKNOWN = 0, // also used for inconsistent multi-component formats
     PL_FMT_UNORM,       // unsigned, normalized integer format (sampled as float)
@@ -1263,6 +1309,14 @@ typedef const struct pl_pass_t {
 PL_API pl_pass pl_pass_create(pl_gpu gpu, const struct pl_pass_params *params);
 PL_API void pl_pass_destroy(pl_gpu gpu, pl_pass *pass);
 
+// Creates `num` passes at once, as if by calling `pl_pass_create` on each
+// element of `params`, and writes the results to the corresponding elements
+// of `out` (NULL on failure). Backends may compile the passes in parallel, so
+// this reduces startup latency when several passes are known in advance.
+// Returns the number of passes successfully created.
+PL_API int pl_pass_create_batch(pl_gpu gpu, const struct pl_pass_params *params,
+                                int num, pl_pass *out);
+
 struct pl_desc_binding {
     const void *object; // pl_* object with type corresponding to pl_desc_type
 
@@ -73,6 +73,80 @@ PL_API void pl_renderer_destroy(pl_renderer *rr);
 // Returns current renderer state, see pl_render_errors.
 PL_API struct pl_render_errors pl_renderer_get_errors(pl_renderer rr);
 
+// Statistics about the frame cache used by `pl_render_image_mix`.
+struct pl_render_cache_stats {
+    int num_frames;     // number of frames currently held in the cache
+    size_t size;        // total size (in bytes) of all cached textures
+    uint64_t hits;      // frames reused from the cache without re-rendering
+    uint64_t misses;    // frames which had to be (re-)rendered
+    uint64_t evictions; // frames evicted from the cache
+};
+
+// Returns the current frame cache statistics. The counters are cumulative
+// over the lifetime of the renderer.
+PL_API struct pl_render_cache_stats pl_renderer_get_cache_stats(pl_renderer rr);
+
+// Statistics about the intermediate passes performed by the renderer.
+struct pl_render_stats {
+    uint64_t frames;        // number of `pl_render_image(_mix)` calls
+    uint64_t fbo_passes;    // intermediate passes rendered to an FBO
+    uint64_t fused_passes;  // FBO round-trips avoided by fusing passes
+};
+
+// Returns the current pass statistics. The counters are cumulative over the
+// lifetime of the renderer.
+PL_API struct pl_render_stats pl_renderer_get_stats(pl_renderer rr);
+
+enum pl_timeline_op {
+    PL_TIMELINE_FRAME,  // start of a `pl_render_image(_mix)` call (instant)
+    PL_TIMELINE_PASS,   // a single shader pass (draw or compute dispatch)
+    PL_TIMELINE_CLEAR,  // clearing of the target frame
+};
+
+// A single recorded operation. All timestamps are in nanoseconds.
+struct pl_timeline_event {
+    enum pl_timeline_op op;
+    const char *name;   // shader description or similar (never NULL)
+    uint64_t frame;     // index of the `pl_render_image(_mix)` call
+
+    // CPU time spent recording/submitting this operation, relative to the
+    // point in time at which the timeline was enabled.
+    uint64_t cpu_start;
+    uint64_t cpu_end;
+
+    // GPU execution time of this operation, or 0 if unknown. Since timer
+    // queries complete asynchronously, this is typically only filled in a
+    // few frames after the operation was recorded, and may be missing
+    // altogether for operations without timer support (e.g. clears).
+    uint64_t gpu_time;
+};
+
+// Enables recording of a timeline of (at most) the `max_events` most recent
+// operations performed by this renderer. Setting this to 0 disables the
+// timeline and discards all recorded events. Disabled by default.
+PL_API void pl_renderer_set_timeline(pl_renderer rr, int max_events);
+
+// Copies up to `max_events` of the recorded events (in chronological order)
+// into `out`, and returns the number of events copied. If `out` is NULL,
+// this instead returns the total number of events available. The `name`
+// pointers remain valid until the timeline is disabled again.
+PL_API int pl_renderer_get_timeline(pl_renderer rr, struct pl_timeline_event *out,
+                                    int max_events);
+
+// Exports the recorded timeline as a Chrome trace event JSON file, which can
+// be loaded into e.g. `chrome://tracing` or `ui.perfetto.dev`. The CPU side
+// of each operation is shown on one track, and the GPU side on another.
+//
+// Note: Since GPU timers only measure durations, the GPU track is a
+// reconstruction, placing each pass no earlier than its CPU submission and
+// the end of the preceding pass. Gaps on this track are therefore an upper
+// bound on actual GPU idle time.
+//
+// Writes data directly to a pointer. Returns the number of bytes that *would*
+// have been written, so this can be used on a size 0 buffer to get the
+// required total size.
+PL_API size_t pl_renderer_save_timeline(pl_renderer rr, uint8_t *out, size_t size);
+
 // Clears errors state of renderer. If `errors` is NULL, all render errors will
 // be cleared. Otherwise only selected errors/hooks will be cleared.
 // If `PL_RENDER_ERR_HOOKS` is set and `num_disabled_hooks` is 0, clear all hooks.
@@ -289,6 +363,18 @@ struct pl_render_params {
     // Significantly speeds up downscaling with high downscaling ratios.
     bool skip_anti_aliasing;
 
+    // Enables pyramidal downscaling. When downscaling by a factor of more
+    // than 4x, the image is first reduced by a series of cheap 2x box filter
+    // passes, until the remaining ratio is at most 4x, and only then scaled
+    // with `downscaler`. This makes the cost per output pixel roughly
+    // independent of the downscaling ratio, which helps a lot for very large
+    // ratios (e.g. 8K -> 720p previews), at the cost of slightly different
+    // filter response. Compared to the direct kernel, the result differs by
+    // less than 1% for smooth content (below a quarter of the output Nyquist
+    // frequency). Fine detail, such as noise, is attenuated more strongly,
+    // so individual pixels of such content can differ by 10% or more.
+    bool pyramid_downscaling;
+
     // Normally, when the size of the `target` used with `pl_render_image_mix`
     // changes, or the render parameters are updated, the internal cache of
     // mixed frames must be discarded in order to re-render all required
@@ -308,6 +394,18 @@ struct pl_render_params {
     // it will still read from, if they happen to already be cached)
     bool skip_caching_single_frame;
 
+    // Upper bound (in bytes) on the total size of the textures retained by
+    // the `pl_render_image_mix` frame cache. If set, frames which are no
+    // longer part of the current mix are kept around (and evicted in least
+    // recently used order once this limit is exceeded), so that they can be
+    // reused without re-rendering if they become relevant again, e.g. when
+    // seeking backwards or alternating between render parameters. If left as
+    // 0, frames are evicted as soon as they drop out of the frame mix.
+    //
+    // Note: Frames required by the current mix are never evicted, even if
+    // this would exceed the limit.
+    size_t mixing_cache_size;
+
     // Disables linearization / sigmoidization before scaling. This might be
     // useful when tracking down unexpected image artifacts or excessing
     // ringing, but it shouldn't normally be necessary.
@@ -319,6 +417,11 @@ struct pl_render_params {
     // general-purpose ones.
     bool disable_builtin_scalers;
 
+    // Disables fusing pointwise plane passes (e.g. debanding) into the film
+    // grain pass, forcing them to be written out to an FBO first. The result
+    // should be the same either way, so this is mainly useful for testing.
+    bool disable_pass_fusion;
+
     // Forces correction of subpixel offsets (using the configured `upscaler`).
     bool correct_subpixel_offsets;
 
@@ -101,6 +101,59 @@ PL_API void pl_shader_sigmoidize(pl_shader sh, const struct pl_sigmoid_params *p
 // This performs the inverse operation to `pl_shader_sigmoidize`.
 PL_API void pl_shader_unsigmoidize(pl_shader sh, const struct pl_sigmoid_params *params);
 
+// Number of histogram bins exported by `pl_hdr_frame_stats`. Bin `i` covers
+// PQ values in the range [0.5 + i/128, 0.5 + (i+1)/128), except for the first
+// bin, which also includes all values below PQ 0.5 (roughly 92 nits). In
+// other words, only the HDR part of the signal is resolved in detail.
+#define PL_HDR_HIST_BINS 64
+
+// Percentiles exported by `pl_hdr_frame_stats`, in percent. These correspond
+// to the distribution points used by HDR10+ (SMPTE ST 2094-40):
+// 1, 5, 10, 25, 50, 75, 90, 95, 99 and 99.98.
+#define PL_HDR_NUM_PERCENTILES 10
+PL_API extern const float pl_hdr_percentiles[PL_HDR_NUM_PERCENTILES];
+
+// Full (unsmoothed) statistics of a single frame, as measured by
+// `pl_shader_detect_peak`. All luminance values are PQ-encoded luma (Y), in
+// the range [0,1]. Pixels below `pl_peak_detect_params.black_cutoff` are
+// excluded from all statistics.
+struct pl_hdr_frame_stats {
+    // Index of the frame, counting calls to `pl_shader_detect_peak` since the
+    // state object was created or last reset (including implicit resets due
+    // to changed parameters). This can be used to match the
+    // statistics back to the source frame, since results are only exported
+    // once they have been read back from the GPU, which may happen with
+    // some delay (see `pl_peak_detect_params.max_delay`).
+    uint64_t frame;
+
+    // Whether this frame was detected as the start of a new scene, based on
+    // `pl_peak_detect_params.scene_threshold_high`. Always true for the first
+    // frame. Never true if scene change detection is disabled.
+    bool scene_change;
+
+    float avg_pq;   // average brightness
+    float max_pq;   // brightest pixel
+
+    // Brightness at each of `pl_hdr_percentiles`, linearly interpolated
+    // within histogram bins
+    float percentiles[PL_HDR_NUM_PERCENTILES];
+
+    // Number of (non-black) pixels falling into each histogram bin
+    uint32_t histogram[PL_HDR_HIST_BINS];
+};
+
+// Caller-supplied ring buffer to receive `pl_hdr_frame_stats`.
+struct pl_hdr_stats_ring {
+    // Array of `size` entries, allocated by the user.
+    struct pl_hdr_frame_stats *frames;
+    int size;
+
+    // Total number of entries written so far. Updated by libplacebo. The most
+    // recent entry is `frames[(num_frames - 1) % size]`. Entries older than
+    // `size` frames are overwritten. The user may reset this to 0 at any time.
+    uint64_t num_frames;
+};
+
 struct pl_peak_detect_params {
     // Smoothing coefficient for the detected values. This controls the time
     // parameter (tau) of an IIR low pass filter. In other words, it represent
@@ -146,6 +199,29 @@ struct pl_peak_detect_params {
     // possibility of 1-frame flickers on transitions. Disabled by default.
     bool allow_delayed;
 
+    // Maximum number of frames by which the peak detection result may lag
+    // behind the frame being rendered. Results are read back asynchronously
+    // from a small ring of buffers, and only once the GPU has finished with
+    // them, so higher values avoid stalling the CPU on the GPU at the cost of
+    // reacting more slowly to scene changes. Results older than this are
+    // read back synchronously. Setting this to a nonzero value implies
+    // `allow_delayed`. If left as 0, defaults to 1 when `allow_delayed` is
+    // set, and 0 otherwise. Values above 3 are clamped.
+    int max_delay;
+
+    // If set, the full statistics of every frame are additionally written to
+    // this ring buffer, whenever the measurement is read back from the GPU.
+    // This happens during calls to `pl_shader_detect_peak` and
+    // `pl_get_detected_hdr_metadata` (and hence `pl_render_image` etc.), so
+    // the ring must remain valid for as long as it is set here, and must not
+    // be accessed concurrently with those functions. Enables the histogram
+    // measurement regardless of `percentile`, which has a small cost.
+    //
+    // Changing or clearing this field takes effect immediately: results still
+    // in flight are exported to the new ring, or dropped, and the previous
+    // ring is never written to again after that call.
+    struct pl_hdr_stats_ring *stats;
+
     // --- Deprecated / removed fields
     PL_DEPRECATED_IN(v6.313) float minimum_peak;
 };
@@ -189,7 +265,8 @@ PL_API bool pl_shader_detect_peak(pl_shader sh, struct pl_color_space csp,
 // `metadata` are not written to. Returns whether or not any values were
 // written. If not, the values are left untouched, so this can be used to
 // safely update `pl_hdr_metadata` values in-place. This function may or may
-// not block, depending on the previous setting of `allow_delayed`.
+// not block, depending on the previous setting of `allow_delayed` and
+// `max_delay`.
 PL_API bool pl_get_detected_hdr_metadata(const pl_shader_obj state,
                                          struct pl_hdr_metadata *metadata);
 
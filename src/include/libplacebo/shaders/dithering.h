@@ -29,9 +29,10 @@ PL_API_BEGIN
 enum pl_dither_method {
     // Dither with blue noise. Very high quality, but requires the use of a
     // LUT. Warning: Computing a blue noise texture with a large size can be
-    // very slow, however this only needs to be performed once. Even so, using
-    // this with a `lut_size` greater than 6 is generally ill-advised. This is
-    // the preferred/default dither method.
+    // slow, however this only needs to be performed once, and the result is
+    // saved to the GPU's `pl_cache` (if any). Even so, using this with a
+    // `lut_size` greater than 7 is generally ill-advised. This is the
+    // preferred/default dither method.
     PL_DITHER_BLUE_NOISE,
 
     // Dither with an ordered (bayer) dither matrix, using a LUT. Low quality,
@@ -116,23 +117,50 @@ struct pl_error_diffusion_params {
     // Error diffusion kernel to use. Optional. If unspecified, defaults to
     // `&pl_error_diffusion_sierra_lite`.
     const struct pl_error_diffusion_kernel *kernel;
+
+    // If nonzero, splits the image into horizontal bands of this many rows,
+    // which are processed independently (and in parallel) by separate work
+    // groups. To avoid visible seams, each band first re-processes the last
+    // `PL_EDF_BAND_OVERLAP` rows of the band above it (without writing them),
+    // which reconstructs the error propagated across the boundary. This
+    // reduces the shared memory requirements to that of an image of height
+    // `band_height + PL_EDF_BAND_OVERLAP`, at the cost of results that are
+    // no longer identical to (but statistically indistinguishable from)
+    // processing the whole image at once. If 0, the whole image is processed
+    // as a single band.
+    int band_height;
 };
 
+#define PL_EDF_BAND_OVERLAP 8
+
 #define pl_error_diffusion_params(...) (&(struct pl_error_diffusion_params) { __VA_ARGS__ })
 
 // Computes the shared memory requirements for a given error diffusion kernel.
 // This can be used to test up-front whether or not error diffusion would be
-// supported or not, before having to initialize textures.
+// supported or not, before having to initialize textures. When using
+// `band_height`, pass `band_height + PL_EDF_BAND_OVERLAP` as the height.
 PL_API size_t pl_error_diffusion_shmem_req(const struct pl_error_diffusion_kernel *kernel,
                                            int height);
 
+// Returns the number of work groups the shader generated by
+// `pl_shader_error_diffusion` must be dispatched with, i.e. the number of
+// bands (or 1 if `band_height` is unset).
+static inline int pl_error_diffusion_bands(const struct pl_error_diffusion_params *params)
+{
+    const int height = params->input_tex->params.h;
+    if (params->band_height <= 0 || params->band_height >= height)
+        return 1;
+    return (height + params->band_height - 1) / params->band_height;
+}
+
 // Apply an error diffusion dithering kernel. This is a much more expensive and
 // heavy dithering method, and is not generally recommended for realtime usage
 // where performance is critical.
 //
 // Requires compute shader support. Returns false if dithering fail e.g. as a
 // result of shader memory limits being exceeded. The resulting shader must be
-// dispatched with a work group count of exactly 1.
+// dispatched with a work group count of exactly `{ N, 1, 1 }`, where `N` is
+// given by `pl_error_diffusion_bands`.
 PL_API bool pl_shader_error_diffusion(pl_shader sh, const struct pl_error_diffusion_params *params);
 
 PL_API_END
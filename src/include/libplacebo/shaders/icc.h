@@ -64,6 +64,14 @@ struct pl_icc_params {
     // wish to split this cache off from the main shader cache. (Optional)
     pl_cache cache;
 
+    // If true, `pl_icc_open` and `pl_icc_update` start generating both the
+    // decoding and encoding 3DLUTs on a background thread, so that they are
+    // (ideally) already available by the time `pl_icc_decode` or
+    // `pl_icc_encode` first needs them. If a LUT is requested before this
+    // background job completes, the call waits for it to finish. Skipped if
+    // the LUTs are already present in `cache`.
+    bool prebuild_luts;
+
     // Deprecated legacy caching API. Replaced by `cache`.
     PL_DEPRECATED_IN(v6.321) void *cache_priv;
     PL_DEPRECATED_IN(v6.321) void (*cache_save)(void *priv, uint64_t sig, const uint8_t *cache, size_t size);
@@ -59,6 +59,13 @@ struct pl_custom_lut {
 // Parse a 3DLUT in .cube format. Returns NULL if the file fails parsing.
 PL_API struct pl_custom_lut *pl_lut_parse_cube(pl_log log, const char *str, size_t str_len);
 
+// Variant of `pl_lut_parse_cube` which first looks up the parsed LUT in
+// `cache` (keyed by the hash of the file contents), and stores the result
+// there after successful parsing. Repeated loads of the same file can thus
+// skip parsing entirely. `cache` may be NULL.
+PL_API struct pl_custom_lut *pl_lut_parse_cube_cached(pl_log log, pl_cache cache,
+                                                      const char *str, size_t str_len);
+
 // Frees a LUT created by `pl_lut_parse_*`.
 PL_API void pl_lut_free(struct pl_custom_lut **lut);
 
@@ -166,6 +166,13 @@ struct pl_sample_filter_params {
     // Disable the use of filter widening / anti-aliasing (for downscaling)
     bool no_widening;
 
+    // Tile (work group) size, in output pixels, to use for the compute shader
+    // path of `pl_shader_sample_polar`. Each tile loads the block of source
+    // texels it depends on into shared memory once. Larger tiles reuse more
+    // texels, but require more shared memory. If left as {0}, a good default
+    // is chosen automatically. Values exceeding device limits are clamped.
+    int tile_size[2];
+
     // This shader object is used to store the LUT, and will be recreated
     // if necessary. To avoid thrashing the resource, users should avoid trying
     // to re-use the same LUT for different filter configurations or scaling
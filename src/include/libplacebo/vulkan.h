@@ -235,6 +235,12 @@ struct pl_vulkan_params {
     // the driver is misbehaving. Some features may be disabled if this is set.
     bool no_compute;
 
+    // Serve device memory allocations from variable-size blocks (using a
+    // two-level segregated fit allocator), instead of the default fixed-size
+    // pages. This can reduce the amount of memory wasted when allocating many
+    // objects of differing sizes. (Experimental)
+    bool malloc_tlsf;
+
     // Bitmask of extra queue families to enable. If set, then *all* queue
     // families matching *any* of these flags will be enabled at device
     // creation time. Setting this to VK_QUEUE_FLAG_BITS_MAX_ENUM effectively
@@ -298,6 +304,24 @@ PL_API void pl_vulkan_destroy(pl_vulkan *vk);
 // the underlying `pl_vulkan`. Returns NULL for any other type of `gpu`.
 PL_API pl_vulkan pl_vulkan_get(pl_gpu gpu);
 
+// Command submission statistics, for profiling purposes. Operations (passes,
+// transfers, blits, clears etc.) are recorded into shared command buffers,
+// which get submitted once enough work has been batched up (or some time has
+// passed since the first operation was recorded), as well as on every
+// `pl_gpu_flush` and whenever switching queues.
+struct pl_vulkan_submit_stats {
+    uint64_t frames;        // number of `pl_gpu_flush` calls so far
+    uint64_t submissions;   // total number of queue submissions
+    uint64_t operations;    // total number of recorded operations
+    int frame_submissions;  // submissions during the last frame
+    int frame_operations;   // operations recorded during the last frame
+};
+
+// Returns the current submission statistics. Returns {0} for a `gpu` not
+// backed by `pl_vulkan`. Note that `frame_*` only reflect the last frame
+// after it was flushed.
+PL_API struct pl_vulkan_submit_stats pl_vulkan_submit_stats(pl_gpu gpu);
+
 struct pl_vulkan_device_params {
     // The instance to use. Required!
     //
@@ -432,6 +456,9 @@ struct pl_vulkan_import_params {
     bool no_compute;
     int max_glsl_version;
     uint32_t max_api_version;
+
+    // See `pl_vulkan_params.malloc_tlsf`.
+    bool malloc_tlsf;
 };
 
 #define pl_vulkan_import_params(...) (&(struct pl_vulkan_import_params) { __VA_ARGS__ })
@@ -40,6 +40,11 @@ static void gl_gpu_destroy(pl_gpu gpu)
     while (p->callbacks.num > 0)
         gl_poll_callbacks(gpu);
 
+    if (p->preloaded.num && MAKE_CURRENT()) {
+        gl_preload_reset(gpu);
+        RELEASE_CURRENT();
+    }
+
     pl_free((void *) gpu);
 }
 
@@ -248,6 +253,11 @@ pl_gpu pl_gpu_create_gl(pl_log log, pl_opengl pl_gl, const struct pl_opengl_para
     p->has_storage = gl_test_ext(gpu, "GL_ARB_shader_image_load_store", 42, 31);
     p->has_readback = true;
 
+    // Let the driver compile and link shaders on as many threads as it likes
+    p->has_parallel_compile = pl_opengl_has_ext(p->gl, "GL_KHR_parallel_shader_compile");
+    if (p->has_parallel_compile)
+        gl->MaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+
     if (p->has_readback && p->gles_ver) {
         GLuint fbo = 0, tex = 0;
         GLint read_type = 0, read_fmt = 0;
@@ -468,6 +478,48 @@ bool gl_buf_poll(pl_gpu gpu, pl_buf buf, uint64_t timeout)
     return !!buf_gl->fence;
 }
 
+// Persistently mapped buffers which are only ever used as transfer sources
+// or destinations can be accessed directly through the (coherent) mapping,
+// since their fence covers all pending GPU accesses. Every GPU-side access
+// to such a buffer must therefore update the fence, see `buf_update_fence`
+static bool buf_is_streaming(pl_buf buf)
+{
+    const struct pl_buf_params *params = &buf->params;
+    return buf->data && !params->storable && !params->uniform &&
+           !params->drawable;
+}
+
+// Blocks until the GPU is done accessing the buffer. Must be called with the
+// context current.
+static void buf_wait_fence(pl_gpu gpu, pl_buf buf)
+{
+    const gl_funcs *gl = gl_funcs_get(gpu);
+    struct pl_buf_gl *buf_gl = PL_PRIV(buf);
+    if (!buf_gl->fence)
+        return;
+
+    GLenum res;
+    do {
+        res = gl->ClientWaitSync(buf_gl->fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                                 1000000000); // 1 s
+    } while (res == GL_TIMEOUT_EXPIRED);
+
+    gl->DeleteSync(buf_gl->fence);
+    buf_gl->fence = NULL;
+}
+
+// Replaces the buffer's fence by one covering all commands submitted so far,
+// including any previously fenced ones. Must be called with the context
+// current.
+static void buf_update_fence(pl_gpu gpu, pl_buf buf)
+{
+    const gl_funcs *gl = gl_funcs_get(gpu);
+    struct pl_buf_gl *buf_gl = PL_PRIV(buf);
+    if (buf_gl->fence)
+        gl->DeleteSync(buf_gl->fence);
+    buf_gl->fence = gl->FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
 void gl_buf_write(pl_gpu gpu, pl_buf buf, size_t offset,
                   const void *data, size_t size)
 {
@@ -475,6 +527,13 @@ void gl_buf_write(pl_gpu gpu, pl_buf buf, size_t offset,
     if (!MAKE_CURRENT())
         return;
 
+    if (buf_is_streaming(buf)) {
+        buf_wait_fence(gpu, buf);
+        memcpy(buf->data + offset, data, size);
+        RELEASE_CURRENT();
+        return;
+    }
+
     struct pl_buf_gl *buf_gl = PL_PRIV(buf);
     gl->BindBuffer(GL_ARRAY_BUFFER, buf_gl->buffer);
     gl->BufferSubData(GL_ARRAY_BUFFER, buf_gl->offset + offset, size, data);
@@ -490,6 +549,13 @@ bool gl_buf_read(pl_gpu gpu, pl_buf buf, size_t offset,
     if (!MAKE_CURRENT())
         return false;
 
+    if (buf_is_streaming(buf)) {
+        buf_wait_fence(gpu, buf);
+        memcpy(dest, buf->data + offset, size);
+        RELEASE_CURRENT();
+        return true;
+    }
+
     struct pl_buf_gl *buf_gl = PL_PRIV(buf);
     gl->BindBuffer(GL_ARRAY_BUFFER, buf_gl->buffer);
     gl->GetBufferSubData(GL_ARRAY_BUFFER, buf_gl->offset + offset, size, dest);
@@ -513,6 +579,12 @@ void gl_buf_copy(pl_gpu gpu, pl_buf dst, size_t dst_offset,
     gl->CopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
                           src_gl->offset + src_offset,
                           dst_gl->offset + dst_offset, size);
+
+    // Direct host accesses through the mapping must wait for the copy
+    if (buf_is_streaming(src))
+        buf_update_fence(gpu, src);
+    if (buf_is_streaming(dst))
+        buf_update_fence(gpu, dst);
     gl_check_err(gpu, "gl_buf_copy");
     RELEASE_CURRENT();
 }
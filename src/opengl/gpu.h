@@ -25,6 +25,11 @@ pl_gpu pl_gpu_create_gl(pl_log log, pl_opengl gl, const struct pl_opengl_params
 
 // --- pl_gpu internal structs and functions
 
+struct gl_preload {
+    uint64_t key;   // pl_cache key of the program binary
+    GLuint prog;    // program object, possibly still being linked
+};
+
 struct pl_gl {
     struct pl_gpu_fns impl;
     pl_opengl gl;
@@ -43,6 +48,10 @@ struct pl_gl {
     // Sync objects and associated callbacks
     PL_ARRAY(struct gl_cb) callbacks;
 
+    // Program binaries preloaded from `preload_cache`, which are taken over
+    // by `gl_pass_create` on a matching cache key
+    pl_cache preload_cache;
+    PL_ARRAY(struct gl_preload) preloaded;
 
     // Incrementing counters to keep track of object uniqueness
     int buf_id;
@@ -59,6 +68,7 @@ struct pl_gl {
     bool has_readback;
     bool has_egl_storage;
     bool has_egl_import;
+    bool has_parallel_compile;
     int gather_comps;
 };
 
@@ -140,3 +150,6 @@ int gl_desc_namespace(pl_gpu, enum pl_desc_type type);
 pl_pass gl_pass_create(pl_gpu, const struct pl_pass_params *);
 void gl_pass_destroy(pl_gpu, pl_pass);
 void gl_pass_run(pl_gpu, const struct pl_pass_run_params *);
+
+// Deletes all preloaded programs. Must be called with the context current.
+void gl_preload_reset(pl_gpu);
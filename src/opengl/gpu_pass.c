@@ -26,32 +26,120 @@ int gl_desc_namespace(pl_gpu gpu, enum pl_desc_type type)
 }
 
 struct gl_cache_header {
+    uint64_t sig; // `pl_gl.sig` of the context that produced this binary
     GLenum format;
 };
 
-static GLuint load_cached_program(pl_gpu gpu, pl_cache cache, pl_cache_obj *obj)
+void gl_preload_reset(pl_gpu gpu)
 {
     const gl_funcs *gl = gl_funcs_get(gpu);
+    struct pl_gl *p = PL_PRIV(gpu);
+    for (int i = 0; i < p->preloaded.num; i++)
+        gl->DeleteProgram(p->preloaded.elem[i].prog);
+    p->preloaded.num = 0;
+}
+
+static void preload_program(void *priv, pl_cache_obj obj)
+{
+    pl_gpu gpu = priv;
+    const gl_funcs *gl = gl_funcs_get(gpu);
+    struct pl_gl *p = PL_PRIV(gpu);
+
+    const struct gl_cache_header *header = obj.data;
+    if (obj.size <= sizeof(*header) || header->sig != p->sig)
+        return; // not a program binary, or from a different driver
+
+    GLuint prog = gl->CreateProgram();
+    if (!prog)
+        return;
+
+    // With GL_KHR_parallel_shader_compile, this returns immediately and the
+    // driver finishes loading the binary in the background
+    gl->ProgramBinary(prog, header->format, &header[1], obj.size - sizeof(*header));
+    PL_ARRAY_APPEND(p, p->preloaded, (struct gl_preload) {
+        .key  = obj.key,
+        .prog = prog,
+    });
+}
+
+// Issues all program binaries contained in `cache` to the driver at once, so
+// that they can be loaded in parallel before the corresponding passes are
+// actually created
+static void preload_programs(pl_gpu gpu, pl_cache cache)
+{
+    const gl_funcs *gl = gl_funcs_get(gpu);
+    struct pl_gl *p = PL_PRIV(gpu);
+    if (cache == p->preload_cache)
+        return;
+
+    gl_preload_reset(gpu);
+    p->preload_cache = cache;
+    if (!cache || !p->has_parallel_compile)
+        return;
+    if (!gl_test_ext(gpu, "GL_ARB_get_program_binary", 41, 30))
+        return;
+
+    pl_clock_t start = pl_clock_now();
+    pl_cache_iterate(cache, preload_program, (void *) gpu);
+    gl->GetError(); // discard potential useless errors
+    pl_log_cpu_time(gpu->log, start, pl_clock_now(), "preloading programs");
+    PL_DEBUG(gpu, "Preloading %d cached GL programs", p->preloaded.num);
+}
+
+static GLuint take_preloaded_program(pl_gpu gpu, uint64_t key)
+{
+    struct pl_gl *p = PL_PRIV(gpu);
+    for (int i = 0; i < p->preloaded.num; i++) {
+        if (p->preloaded.elem[i].key == key) {
+            GLuint prog = p->preloaded.elem[i].prog;
+            PL_ARRAY_REMOVE_AT(p->preloaded, i);
+            return prog;
+        }
+    }
+
+    return 0;
+}
+
+// Returns a program loaded from `cache`, or 0. `*update` is set if the
+// program binary was removed from the cache in the process, and needs to be
+// re-inserted by the caller.
+static GLuint load_cached_program(pl_gpu gpu, pl_cache cache, pl_cache_obj *obj,
+                                  bool *update)
+{
+    const gl_funcs *gl = gl_funcs_get(gpu);
+    struct pl_gl *p = PL_PRIV(gpu);
+    *update = true;
     if (!gl_test_ext(gpu, "GL_ARB_get_program_binary", 41, 30))
         return 0;
 
+    GLint status = 0;
+    GLuint prog = take_preloaded_program(gpu, obj->key);
+    if (prog) {
+        gl->GetProgramiv(prog, GL_LINK_STATUS, &status);
+        if (status) {
+            *update = false;
+            return prog;
+        }
+        gl->DeleteProgram(prog);
+        gl->GetError();
+    }
+
     if (!pl_cache_get(cache, obj))
         return 0;
 
-    if (obj->size < sizeof(struct gl_cache_header))
+    const struct gl_cache_header *header = obj->data;
+    if (obj->size <= sizeof(*header) || header->sig != p->sig)
         return 0;
 
-    GLuint prog = gl->CreateProgram();
+    prog = gl->CreateProgram();
     if (!gl_check_err(gpu, "load_cached_program: glCreateProgram"))
         return 0;
 
-    struct gl_cache_header *header = (struct gl_cache_header *) obj->data;
     pl_str rest = (pl_str) { obj->data, obj->size };
     rest = pl_str_drop(rest, sizeof(*header));
     gl->ProgramBinary(prog, header->format, rest.buf, rest.len);
     gl->GetError(); // discard potential useless error
 
-    GLint status = 0;
     gl->GetProgramiv(prog, GL_LINK_STATUS, &status);
     if (status)
         return prog;
@@ -72,12 +160,26 @@ static enum pl_log_level gl_log_level(GLint status, GLint log_length)
     }
 }
 
-static bool gl_attach_shader(pl_gpu gpu, GLuint program, GLenum type, const char *src)
+// Issues the compilation of a shader and attaches it to `program`. The result
+// is only checked by `gl_check_shader`, which allows the driver to compile
+// multiple shaders in parallel (GL_KHR_parallel_shader_compile)
+static GLuint gl_begin_shader(pl_gpu gpu, GLuint program, GLenum type, const char *src)
 {
     const gl_funcs *gl = gl_funcs_get(gpu);
     GLuint shader = gl->CreateShader(type);
     gl->ShaderSource(shader, 1, &src, NULL);
     gl->CompileShader(shader);
+    gl->AttachShader(program, shader);
+    return shader;
+}
+
+// Waits for the compilation of `shader` to complete and checks the result.
+// Always deletes the shader, which stays alive while attached to a program.
+static bool gl_check_shader(pl_gpu gpu, GLuint shader)
+{
+    const gl_funcs *gl = gl_funcs_get(gpu);
+    if (!shader)
+        return true;
 
     GLint status = 0;
     gl->GetShaderiv(shader, GL_COMPILE_STATUS, &status);
@@ -92,31 +194,25 @@ static bool gl_attach_shader(pl_gpu gpu, GLuint program, GLenum type, const char
         pl_free(logstr);
     }
 
-    if (!status || !gl_check_err(gpu, "gl_attach_shader"))
-        goto error;
-
-    gl->AttachShader(program, shader);
-    gl->DeleteShader(shader);
-    return true;
-
-error:
     gl->DeleteShader(shader);
-    return false;
+    return status && gl_check_err(gpu, "gl_check_shader");
 }
 
 static GLuint gl_compile_program(pl_gpu gpu, const struct pl_pass_params *params)
 {
     const gl_funcs *gl = gl_funcs_get(gpu);
     GLuint prog = gl->CreateProgram();
+    GLuint shaders[2] = {0};
     bool ok = true;
 
+    // Issue all compilations before checking any of them
     switch (params->type) {
     case PL_PASS_COMPUTE:
-        ok &= gl_attach_shader(gpu, prog, GL_COMPUTE_SHADER, params->glsl_shader);
+        shaders[0] = gl_begin_shader(gpu, prog, GL_COMPUTE_SHADER, params->glsl_shader);
         break;
     case PL_PASS_RASTER:
-        ok &= gl_attach_shader(gpu, prog, GL_VERTEX_SHADER, params->vertex_shader);
-        ok &= gl_attach_shader(gpu, prog, GL_FRAGMENT_SHADER, params->glsl_shader);
+        shaders[0] = gl_begin_shader(gpu, prog, GL_VERTEX_SHADER, params->vertex_shader);
+        shaders[1] = gl_begin_shader(gpu, prog, GL_FRAGMENT_SHADER, params->glsl_shader);
         for (int i = 0; i < params->num_vertex_attribs; i++)
             gl->BindAttribLocation(prog, i, params->vertex_attribs[i].name);
         break;
@@ -125,6 +221,9 @@ static GLuint gl_compile_program(pl_gpu gpu, const struct pl_pass_params *params
         pl_unreachable();
     }
 
+    for (int i = 0; i < PL_ARRAY_SIZE(shaders); i++)
+        ok &= gl_check_shader(gpu, shaders[i]);
+
     if (!ok || !gl_check_err(gpu, "gl_compile_program: attach shader"))
         goto error;
 
@@ -236,7 +335,10 @@ pl_pass gl_pass_create(pl_gpu gpu, const struct pl_pass_params *params)
     }
 
     // Load/Compile program
-    if ((pass_gl->program = load_cached_program(gpu, cache, &obj))) {
+    bool update_cache = true;
+    if (cache)
+        preload_programs(gpu, cache);
+    if ((pass_gl->program = load_cached_program(gpu, cache, &obj, &update_cache))) {
         PL_DEBUG(gpu, "Using cached GL program");
     } else {
         pl_clock_t start = pl_clock_now();
@@ -248,13 +350,14 @@ pl_pass gl_pass_create(pl_gpu gpu, const struct pl_pass_params *params)
         goto error;
 
     // Update program cache if possible
-    if (cache && gl_test_ext(gpu, "GL_ARB_get_program_binary", 41, 30)) {
+    if (cache && update_cache && gl_test_ext(gpu, "GL_ARB_get_program_binary", 41, 30)) {
         GLint buf_size = 0;
         gl->GetProgramiv(pass_gl->program, GL_PROGRAM_BINARY_LENGTH, &buf_size);
         if (buf_size > 0) {
             buf_size += sizeof(struct gl_cache_header);
             pl_cache_obj_resize(NULL, &obj, buf_size);
             struct gl_cache_header *header = obj.data;
+            header->sig = p->sig;
             void *buffer = &header[1];
             GLsizei binary_size = 0;
             gl->GetProgramBinary(pass_gl->program, buf_size, &binary_size,
@@ -895,8 +895,12 @@ bool gl_tex_upload(pl_gpu gpu, const struct pl_tex_transfer_params *params)
 
     // If the user requests asynchronous uploads, it's more efficient to do
     // them via a PBO - this allows us to skip blocking the caller, especially
-    // when the host pointer can be imported directly.
-    if (params->callback && !buf) {
+    // when the host pointer can be imported directly. The same goes for
+    // synchronous uploads when we have persistently mapped buffers, since the
+    // host copy into the (recycled) staging buffer is then just a memcpy,
+    // and the actual transfer can proceed in the background.
+    bool streaming = params->callback || gpu->limits.max_mapped_size;
+    if (streaming && !buf) {
         size_t buf_size = pl_tex_transfer_size(params);
         const size_t min_size = 32*1024; // 32 KiB
         if (buf_size >= min_size && buf_size <= gpu->limits.max_buf_size)
@@ -963,6 +963,7 @@ const struct pl_opt_t pl_option_list[] = {
     OPT_FLOAT("peak_percentile", "Peak detection percentile", peak_detect_params.percentile, .max = 100.0),
     OPT_FLOAT("black_cutoff", "Peak detection black cutoff", peak_detect_params.black_cutoff, .max = 100.0),
     OPT_BOOL("allow_delayed_peak", "Allow delayed peak detection", peak_detect_params.allow_delayed),
+    OPT_INT("peak_max_delay", "Maximum peak detection delay", peak_detect_params.max_delay, .max = 3),
 
     // Color mapping
     OPT_ENABLE_PARAMS("color_map", "Enable color mapping", color_map_params),
@@ -1150,12 +1151,14 @@ const struct pl_opt_t pl_option_list[] = {
 
     // Performance / quality trade-offs and debugging options
     OPT_BOOL("skip_anti_aliasing", "Skip anti-aliasing", params.skip_anti_aliasing),
+    OPT_BOOL("pyramid_downscaling", "Pyramidal downscaling", params.pyramid_downscaling),
     OPT_INT("lut_entries", "Scaler LUT entries", params.lut_entries, .max = 256, .deprecated = true),
     OPT_FLOAT("polar_cutoff", "Polar LUT cutoff", params.polar_cutoff, .max = 1.0, .deprecated = true),
     OPT_BOOL("preserve_mixing_cache", "Preserve mixing cache", params.preserve_mixing_cache),
     OPT_BOOL("skip_caching_single_frame", "Skip caching single frame", params.skip_caching_single_frame),
     OPT_BOOL("disable_linear_scaling", "Disable linear scaling", params.disable_linear_scaling),
     OPT_BOOL("disable_builtin_scalers", "Disable built-in scalers", params.disable_builtin_scalers),
+    OPT_BOOL("disable_pass_fusion", "Disable pass fusion", params.disable_pass_fusion),
     OPT_BOOL("correct_subpixel_offset", "Correct subpixel offsets", params.correct_subpixel_offsets),
     OPT_BOOL("ignore_icc_profiles", "Ignore ICC profiles", params.ignore_icc_profiles, .deprecated = true),
     OPT_BOOL("force_dither", "Force-enable dithering", params.force_dither),
@@ -22,6 +22,7 @@
 #include "hash.h"
 #include "shaders.h"
 #include "dispatch.h"
+#include "shaders/film_grain.h"
 
 #include <libplacebo/renderer.h>
 
@@ -33,9 +34,15 @@ struct cached_frame {
     pl_rect2df crop;
     pl_tex tex;
     int comps;
+    uint64_t last_used; // for LRU eviction
     bool evict; // for garbage collection
 };
 
+struct fbo {
+    pl_tex tex;
+    uint64_t last_used; // for eviction under memory pressure
+};
+
 struct sampler {
     pl_shader_obj upscaler_state;
     pl_shader_obj downscaler_state;
@@ -69,7 +76,7 @@ struct pl_renderer_t {
     pl_shader_obj grain_state[4];
     pl_shader_obj lut_state[3];
     pl_shader_obj icc_state[2];
-    PL_ARRAY(pl_tex) fbos[PL_RENDER_STAGE_COUNT];
+    PL_ARRAY(struct fbo) fbos[PL_RENDER_STAGE_COUNT];
     struct sampler sampler_main;
     struct sampler sampler_contrast;
     struct sampler samplers_src[4];
@@ -83,6 +90,12 @@ struct pl_renderer_t {
     // Frame cache (for frame mixing / interpolation)
     PL_ARRAY(struct cached_frame) frames;
     PL_ARRAY(pl_tex) frame_fbos;
+    struct pl_render_cache_stats frame_stats;
+    uint64_t frame_counter;
+
+    // Incremented once per `pl_render_image(_mix)` call
+    uint64_t render_counter;
+    struct pl_render_stats stats;
 
     // For debugging / logging purposes
     int prev_dither;
@@ -147,7 +160,7 @@ void pl_renderer_destroy(pl_renderer *p_rr)
     // Free all intermediate FBOs
     for (int n = 0; n < PL_ARRAY_SIZE(rr->fbos); n++) {
         for (int i = 0; i < rr->fbos[n].num; i++)
-            pl_tex_destroy(rr->gpu, &rr->fbos[n].elem[i]);
+            pl_tex_destroy(rr->gpu, &rr->fbos[n].elem[i].tex);
     }
     for (int i = 0; i < rr->frames.num; i++)
         pl_tex_destroy(rr->gpu, &rr->frames.elem[i].tex);
@@ -259,6 +272,11 @@ struct img {
     // If true, created shaders will be set to unique
     bool unique;
 
+    // If true, `sh` is evaluated on the same pixel grid as `err_tex`, so it
+    // can be fused into a consumer which only ever fetches the pixel it's
+    // currently generating, rather than going through an FBO
+    bool pointwise;
+
     // Information about what to log/disable/fallback to if the shader fails
     const char *err_msg;
     enum pl_render_error err_enum;
@@ -475,9 +493,9 @@ static pl_tex get_fbo(struct pass_state *pass, int w, int h, pl_fmt fmt,
             continue;
 
         // Orthogonal distance, with penalty for format mismatches
-        int diff = abs(rr->fbos[n].elem[i]->params.w - w) +
-                   abs(rr->fbos[n].elem[i]->params.h - h) +
-                   ((rr->fbos[n].elem[i]->params.format != fmt) ? 1000 : 0);
+        const struct pl_tex_params *tpars = &rr->fbos[n].elem[i].tex->params;
+        int diff = abs(tpars->w - w) + abs(tpars->h - h) +
+                   ((tpars->format != fmt) ? 1000 : 0);
 
         if (best_idx < 0 || diff < best_diff) {
             best_idx = i;
@@ -488,16 +506,75 @@ static pl_tex get_fbo(struct pass_state *pass, int w, int h, pl_fmt fmt,
     // No texture found at all, add a new one
     if (best_idx < 0) {
         best_idx = rr->fbos[n].num;
-        PL_ARRAY_APPEND(rr, rr->fbos[n], NULL);
+        PL_ARRAY_APPEND(rr, rr->fbos[n], (struct fbo) {0});
         pl_grow(pass->tmp, &pass->fbos_used, rr->fbos[n].num * sizeof(bool));
         pass->fbos_used[best_idx] = false;
     }
 
-    if (!pl_tex_recreate(rr->gpu, &rr->fbos[n].elem[best_idx], &params))
+    struct fbo *fbo = &rr->fbos[n].elem[best_idx];
+    if (!pl_tex_recreate(rr->gpu, &fbo->tex, &params))
         return NULL;
 
     pass->fbos_used[best_idx] = true;
-    return rr->fbos[n].elem[best_idx];
+    fbo->last_used = rr->render_counter;
+    return fbo->tex;
+}
+
+// Evicts cached resources while the GPU memory budget is exceeded, starting
+// with spare frame textures, then the least recently used mixer frames, and
+// finally intermediate FBOs that went unused during the previous render. Must
+// only be called at the start of a render, when nothing is in use.
+static void trim_caches(pl_renderer rr)
+{
+    int evicted = 0;
+    if (!pl_mem_budget_excess(rr->gpu))
+        goto done;
+
+    while (pl_mem_budget_excess(rr->gpu) && rr->frame_fbos.num) {
+        pl_tex_destroy(rr->gpu, &rr->frame_fbos.elem[--rr->frame_fbos.num]);
+        evicted++;
+    }
+
+    while (pl_mem_budget_excess(rr->gpu) && rr->frames.num) {
+        int lru = 0;
+        for (int i = 1; i < rr->frames.num; i++) {
+            if (rr->frames.elem[i].last_used < rr->frames.elem[lru].last_used)
+                lru = i;
+        }
+
+        struct cached_frame *f = &rr->frames.elem[lru];
+        PL_TRACE(rr, "Evicting frame with signature %llx from cache (budget)",
+                 (unsigned long long) f->signature);
+        pl_tex_destroy(rr->gpu, &f->tex);
+        PL_ARRAY_REMOVE_AT(rr->frames, lru);
+        rr->frame_stats.evictions++;
+        evicted++;
+    }
+
+    while (pl_mem_budget_excess(rr->gpu)) {
+        int lru_stage = -1, lru = -1;
+        for (int n = 0; n < PL_RENDER_STAGE_COUNT; n++) {
+            for (int i = 0; i < rr->fbos[n].num; i++) {
+                const struct fbo *fbo = &rr->fbos[n].elem[i];
+                if (fbo->last_used >= rr->render_counter)
+                    continue;
+                if (lru < 0 || fbo->last_used < rr->fbos[lru_stage].elem[lru].last_used) {
+                    lru_stage = n;
+                    lru = i;
+                }
+            }
+        }
+        if (lru < 0)
+            break; // everything left is still in active use
+
+        pl_tex_destroy(rr->gpu, &rr->fbos[lru_stage].elem[lru].tex);
+        PL_ARRAY_REMOVE_AT(rr->fbos[lru_stage], lru);
+        evicted++;
+    }
+
+done:
+    pl_mem_budget_evicted(rr->gpu, evicted);
+    rr->render_counter++;
 }
 
 // Forcibly convert an img to `tex`, dispatching where necessary
@@ -542,6 +619,8 @@ static pl_tex _img_tex(struct pass_state *pass, struct img *img, pl_debug_tag ta
     }
 
     img->tex = tex;
+    img->pointwise = false;
+    rr->stats.fbo_passes++;
     return img->tex;
 }
 
@@ -680,6 +759,86 @@ static struct sampler_info sample_src_info(struct pass_state *pass,
     return info;
 }
 
+// Reduces `src` using a series of cheap 2x box filter passes (a single
+// bilinear tap each), until the remaining downscaling ratio is at most
+// PYRAMID_RATIO in both directions. Dimensions that need no further reduction
+// are passed through unmodified. The final (high quality) sampling pass then
+// takes the reduced texture as input, with the original components and scale.
+// Returns false on failure.
+#define PYRAMID_RATIO       4.0f
+#define MAX_PYRAMID_PASSES  16
+
+static bool pass_pyramid(struct pass_state *pass, struct pl_sample_src *src)
+{
+    pl_renderer rr = pass->rr;
+    pl_fmt fmt = src->tex->params.format;
+    const int comps = fmt->num_components;
+    pl_fmt fbofmt = pass->fbofmt[comps];
+    if (!(fmt->caps & PL_FMT_CAP_LINEAR) || !fbofmt ||
+        !(fbofmt->caps & PL_FMT_CAP_LINEAR))
+        return true; // unsupported, use the direct kernel instead
+
+    for (int i = 0; i < MAX_PYRAMID_PASSES; i++) {
+        const float rw = fabsf(pl_rect_w(src->rect));
+        const float rh = fabsf(pl_rect_h(src->rect));
+        const bool half_x = rw > PYRAMID_RATIO * src->new_w;
+        const bool half_y = rh > PYRAMID_RATIO * src->new_h;
+        if (!half_x && !half_y)
+            break;
+
+        struct pl_sample_src tmp = {
+            .tex          = src->tex,
+            .rect         = src->rect,
+            .address_mode = src->address_mode,
+            .new_w        = src->tex->params.w,
+            .new_h        = src->tex->params.h,
+        };
+
+        if (half_x) {
+            tmp.new_w = PL_MAX(lrintf(rw / 2), 1);
+        } else {
+            tmp.rect.x0 = 0;
+            tmp.rect.x1 = tmp.new_w;
+        }
+
+        if (half_y) {
+            tmp.new_h = PL_MAX(lrintf(rh / 2), 1);
+        } else {
+            tmp.rect.y0 = 0;
+            tmp.rect.y1 = tmp.new_h;
+        }
+
+        pl_tex fbo = get_fbo(pass, tmp.new_w, tmp.new_h, NULL, comps, PL_DEBUG_TAG);
+        if (!fbo)
+            return false;
+
+        pl_shader sh = pl_dispatch_begin(rr->dp);
+        sh_describef(sh, "pyramid downscale pass %d", i + 1);
+        bool ok = pl_shader_sample_direct(sh, &tmp);
+        ok = ok && pl_dispatch_finish(rr->dp, pl_dispatch_params(
+            .shader = &sh,
+            .target = fbo,
+        ));
+        if (!ok) {
+            pl_dispatch_abort(rr->dp, &sh);
+            return false;
+        }
+
+        rr->stats.fbo_passes++;
+        src->tex = fbo;
+        if (half_x) {
+            src->rect.x0 = 0;
+            src->rect.x1 = tmp.new_w;
+        }
+        if (half_y) {
+            src->rect.y0 = 0;
+            src->rect.y1 = tmp.new_h;
+        }
+    }
+
+    return true;
+}
+
 static void dispatch_sampler(struct pass_state *pass, pl_shader sh,
                              struct sampler *sampler, enum sampler_usage usage,
                              pl_tex target_tex, const struct pl_sample_src *src)
@@ -724,6 +883,17 @@ static void dispatch_sampler(struct pass_state *pass, pl_shader sh,
         break; // continue below
     }
 
+    struct pl_sample_src reduced;
+    if (params->pyramid_downscaling && info.dir == SAMPLER_DOWN && src->tex) {
+        reduced = *src;
+        if (!pass_pyramid(pass, &reduced)) {
+            PL_ERR(rr, "Failed dispatching pyramid downscaling.. disabling");
+            rr->errors |= PL_RENDER_ERR_SAMPLING;
+            goto fallback;
+        }
+        src = &reduced;
+    }
+
     pl_assert(lut);
     struct pl_sample_filter_params fparams = {
         .filter      = *info.config,
@@ -1207,7 +1377,9 @@ static void hdr_update_peak(struct pass_state *pass)
     if (params->lut && params->lut_type == PL_LUT_CONVERSION)
         goto cleanup; // LUT handles tone mapping
 
-    if (!pass->fbofmt[4] && !params->peak_detect_params->allow_delayed) {
+    const struct pl_peak_detect_params *ppar = params->peak_detect_params;
+    const bool delayed = ppar->allow_delayed || ppar->max_delay > 0;
+    if (!pass->fbofmt[4] && !delayed) {
         PL_WARN(rr, "Disabling peak detection because "
                 "`pl_peak_detect_params.allow_delayed` is false, but lack of "
                 "FBOs forces the result to be delayed.");
@@ -1216,14 +1388,14 @@ static void hdr_update_peak(struct pass_state *pass)
     }
 
     bool ok = pl_shader_detect_peak(img_sh(pass, &pass->img), pass->img.color,
-                                    &rr->tone_map_state, params->peak_detect_params);
+                                    &rr->tone_map_state, ppar);
     if (!ok) {
         PL_WARN(rr, "Failed creating HDR peak detection shader.. disabling");
         rr->errors |= PL_RENDER_ERR_PEAK_DETECT;
         goto cleanup;
     }
 
-    pass->need_peak_fbo = !params->peak_detect_params->allow_delayed;
+    pass->need_peak_fbo = !delayed;
     return;
 
 cleanup:
@@ -1331,6 +1503,7 @@ static bool plane_deband(struct pass_state *pass, struct img *img, float neutral
     img->err_enum = PL_RENDER_ERR_DEBANDING;
     img->err_tex = src.tex;
     img->repr = repr;
+    img->pointwise = true;
     return true;
 }
 
@@ -1391,17 +1564,44 @@ static bool plane_film_grain(struct pass_state *pass, int plane_idx,
         return false;
     }
 
+    // Film grain only ever fetches the pixel it's generating, so a preceding
+    // pointwise stage (e.g. debanding) can be fused into the same pass
+    // instead of being written out to an FBO first
+    pl_shader_obj *state = &rr->grain_state[plane_idx];
+    pl_tex src_tex = img->err_tex;
+    if (img->sh && img->pointwise && src_tex &&
+        src_tex->params.w == img->w && src_tex->params.h == img->h &&
+        !pass->params->disable_pass_fusion)
+    {
+        const struct pl_color_repr orig_repr = repr;
+        grain_params.tex = src_tex;
+        pl_shader sh = pl_dispatch_begin_ex(rr->dp, true);
+        if (sh_film_grain_fused(sh, state, &grain_params, img->sh)) {
+            PL_TRACE(rr, "Fused plane %d pass into film grain", plane_idx);
+            pl_dispatch_abort(rr->dp, &img->sh);
+            img->sh = sh;
+            img->pointwise = false;
+            rr->stats.fused_passes++;
+            goto done;
+        }
+
+        // Fall back to the regular path, `repr` was normalized in-place
+        pl_dispatch_abort(rr->dp, &sh);
+        repr = orig_repr;
+    }
+
     grain_params.tex = img_tex(pass, img);
     if (!grain_params.tex)
         return false;
 
     img->sh = pl_dispatch_begin_ex(rr->dp, true);
-    if (!pl_shader_film_grain(img->sh, &rr->grain_state[plane_idx], &grain_params)) {
+    if (!pl_shader_film_grain(img->sh, state, &grain_params)) {
         pl_dispatch_abort(rr->dp, &img->sh);
         rr->errors |= PL_RENDER_ERR_FILM_GRAIN;
         return false;
     }
 
+done:
     img->tex = NULL;
     img->err_msg = "Failed applying film grain.. disabling!";
     img->err_enum = PL_RENDER_ERR_FILM_GRAIN;
@@ -1591,6 +1791,7 @@ static bool pass_read_image(struct pass_state *pass)
             img->err_msg = "Failed deinterlacing plane.. disabling!";
             img->err_enum = PL_RENDER_ERR_DEINTERLACING;
             img->err_tex = planes[i].plane.texture;
+            img->pointwise = true;
         }
     }
 
@@ -2268,11 +2469,25 @@ static bool pass_error_diffusion(struct pass_state *pass, pl_shader *sh,
     if (!params->error_diffusion || (rr->errors & PL_RENDER_ERR_ERROR_DIFFUSION))
         return false;
 
-    size_t shmem_req = pl_error_diffusion_shmem_req(params->error_diffusion, out_h);
-    if (shmem_req > rr->gpu->glsl.max_shmem_size) {
-        PL_TRACE(rr, "Disabling error diffusion due to shmem requirements (%zu) "
-                 "exceeding capabilities (%zu)", shmem_req, rr->gpu->glsl.max_shmem_size);
-        return false;
+    // If the whole image doesn't fit into shared memory, split it into the
+    // largest bands that do
+    const struct pl_error_diffusion_kernel *kernel = params->error_diffusion;
+    const size_t max_shmem = rr->gpu->glsl.max_shmem_size;
+    size_t shmem_req = pl_error_diffusion_shmem_req(kernel, out_h);
+    int band_height = 0;
+    if (shmem_req > max_shmem) {
+        size_t row_req = pl_error_diffusion_shmem_req(kernel, 1) -
+                         pl_error_diffusion_shmem_req(kernel, 0);
+        size_t max_rows = max_shmem / row_req;
+        if (max_rows < 4 * PL_EDF_BAND_OVERLAP) {
+            PL_TRACE(rr, "Disabling error diffusion due to shmem requirements "
+                     "(%zu) exceeding capabilities (%zu)", shmem_req, max_shmem);
+            return false;
+        }
+
+        band_height = max_rows - PL_EDF_BAND_OVERLAP - PL_EDF_MAX_DY;
+        pl_assert(pl_error_diffusion_shmem_req(kernel, band_height +
+                                               PL_EDF_BAND_OVERLAP) <= max_shmem);
     }
 
     pl_fmt fmt = pass->fbofmt[comps];
@@ -2284,7 +2499,8 @@ static bool pass_error_diffusion(struct pass_state *pass, pl_shader *sh,
 
     struct pl_error_diffusion_params edpars = {
         .new_depth = new_depth,
-        .kernel = params->error_diffusion,
+        .kernel = kernel,
+        .band_height = band_height,
     };
 
     // Create temporary framebuffers
@@ -2308,7 +2524,7 @@ static bool pass_error_diffusion(struct pass_state *pass, pl_shader *sh,
     if (ok) {
         ok = pl_dispatch_compute(rr->dp, pl_dispatch_compute_params(
             .shader = &dsh,
-            .dispatch_size = {1, 1, 1},
+            .dispatch_size = { pl_error_diffusion_bands(&edpars), 1, 1 },
         ));
     }
 
@@ -2479,12 +2695,17 @@ static void clear_target(pl_renderer rr, const struct pl_frame *target,
     if (border == PL_CLEAR_BLUR && !background)
         border = PL_CLEAR_COLOR;
 
+    const pl_clock_t start = pl_clock_now();
     switch (border) {
     case PL_CLEAR_COLOR:
         pl_frame_clear_rgba(rr->gpu, target, CLEAR_COL(params));
+        pl_dispatch_timeline_add(rr->dp, PL_TIMELINE_CLEAR, "clear target",
+                                 start, pl_clock_now());
         break;
     case PL_CLEAR_TILES:
         pl_frame_clear_tiles(rr->gpu, target, params->tile_colors, params->tile_size);
+        pl_dispatch_timeline_add(rr->dp, PL_TIMELINE_CLEAR, "clear target (tiles)",
+                                 start, pl_clock_now());
         break;
     case PL_CLEAR_BLUR: ;
         // Map of the output frame buffer:
@@ -3463,15 +3684,10 @@ done:
     return true;
 }
 
-bool pl_render_image(pl_renderer rr, const struct pl_frame *pimage,
-                     const struct pl_frame *ptarget,
-                     const struct pl_render_params *params)
+static bool render_image(pl_renderer rr, const struct pl_frame *pimage,
+                         const struct pl_frame *ptarget,
+                         const struct pl_render_params *params)
 {
-    params = PL_DEF(params, &pl_render_default_params);
-    pl_dispatch_mark_dynamic(rr->dp, params->dynamic_constants);
-    if (!pimage)
-        return draw_empty_overlays(rr, ptarget, params);
-
     struct pass_state pass = {
         .rr = rr,
         .params = params,
@@ -3507,6 +3723,20 @@ error:
     return false;
 }
 
+bool pl_render_image(pl_renderer rr, const struct pl_frame *pimage,
+                     const struct pl_frame *ptarget,
+                     const struct pl_render_params *params)
+{
+    params = PL_DEF(params, &pl_render_default_params);
+    pl_dispatch_mark_dynamic(rr->dp, params->dynamic_constants);
+    pl_dispatch_timeline_frame(rr->dp, rr->render_counter);
+    trim_caches(rr);
+    if (!pimage)
+        return draw_empty_overlays(rr, ptarget, params);
+
+    return render_image(rr, pimage, ptarget, params);
+}
+
 const struct pl_frame *pl_frame_mix_current(const struct pl_frame_mix *mix)
 {
     const struct pl_frame *cur = NULL;
@@ -3614,6 +3844,7 @@ static struct params_info render_params_info(const struct pl_render_params *para
     CLEAR(params.frame_mixer);
     CLEAR(params.preserve_mixing_cache);
     CLEAR(params.skip_caching_single_frame);
+    CLEAR(params.mixing_cache_size);
 
     // Clear out fields only relevant to pass_output_target
     CLEAR(params.background);
@@ -3630,6 +3861,7 @@ static struct params_info render_params_info(const struct pl_render_params *para
     CLEAR(params.error_diffusion);
     CLEAR(params.force_dither);
     CLEAR(params.corner_rounding);
+    CLEAR(params.blur_radius);
 
     // Clear out other irrelevant fields
     CLEAR(params.dynamic_constants);
@@ -3642,6 +3874,69 @@ static struct params_info render_params_info(const struct pl_render_params *para
 
 #define MAX_MIX_FRAMES 16
 
+static bool frame_cache_compatible(const struct cached_frame *f,
+                                   const struct pl_frame *img,
+                                   const struct pl_frame *target,
+                                   int out_w, int out_h, uint64_t params_hash)
+{
+    return f->tex &&
+           f->tex->params.w == out_w &&
+           f->tex->params.h == out_h &&
+           pl_rect2d_eq(f->crop, img->crop) &&
+           f->params_hash == params_hash &&
+           pl_color_space_equal(&f->color, &target->color) &&
+           pl_icc_profile_equal(&f->profile, &target->profile);
+}
+
+static size_t frame_tex_size(pl_tex tex)
+{
+    if (!tex)
+        return 0;
+    return (size_t) tex->params.w * tex->params.h * tex->params.format->texel_size;
+}
+
+static size_t frame_cache_size(pl_renderer rr)
+{
+    size_t total = 0;
+    for (int i = 0; i < rr->frames.num; i++)
+        total += frame_tex_size(rr->frames.elem[i].tex);
+    for (int i = 0; i < rr->frame_fbos.num; i++)
+        total += frame_tex_size(rr->frame_fbos.elem[i]);
+    return total;
+}
+
+// Shrinks the frame cache down to at most `limit` bytes, by first freeing
+// spare textures and then evicting the least recently used frames. Frames
+// required by the current mix are never evicted.
+static void frame_cache_trim(pl_renderer rr, size_t limit)
+{
+    size_t total = frame_cache_size(rr);
+    while (total > limit && rr->frame_fbos.num) {
+        pl_tex tex = rr->frame_fbos.elem[--rr->frame_fbos.num];
+        total -= frame_tex_size(tex);
+        pl_tex_destroy(rr->gpu, &tex);
+    }
+
+    while (total > limit) {
+        int lru = -1;
+        for (int i = 0; i < rr->frames.num; i++) {
+            const struct cached_frame *f = &rr->frames.elem[i];
+            if (f->evict && (lru < 0 || f->last_used < rr->frames.elem[lru].last_used))
+                lru = i;
+        }
+        if (lru < 0)
+            break; // everything left is in use
+
+        struct cached_frame *f = &rr->frames.elem[lru];
+        PL_TRACE(rr, "Evicting frame with signature %llx from cache (LRU)",
+                 (unsigned long long) f->signature);
+        total -= frame_tex_size(f->tex);
+        pl_tex_destroy(rr->gpu, &f->tex);
+        PL_ARRAY_REMOVE_AT(rr->frames, lru);
+        rr->frame_stats.evictions++;
+    }
+}
+
 bool pl_render_image_mix(pl_renderer rr, const struct pl_frame_mix *images,
                          const struct pl_frame *ptarget,
                          const struct pl_render_params *params)
@@ -3652,6 +3947,8 @@ bool pl_render_image_mix(pl_renderer rr, const struct pl_frame_mix *images,
     params = PL_DEF(params, &pl_render_default_params);
     struct params_info par_info = render_params_info(params);
     pl_dispatch_mark_dynamic(rr->dp, params->dynamic_constants);
+    pl_dispatch_timeline_frame(rr->dp, rr->render_counter);
+    trim_caches(rr);
 
     require(images->num_frames >= 1);
     require(images->vsync_duration > 0.0);
@@ -3684,6 +3981,7 @@ bool pl_render_image_mix(pl_renderer rr, const struct pl_frame_mix *images,
     struct cached_frame frames[MAX_MIX_FRAMES];
     float weights[MAX_MIX_FRAMES];
     float wsum = 0.0;
+    rr->frame_counter++;
 
     // Garbage collect the cache by evicting all frames from the cache that are
     // not determined to still be required
@@ -3770,15 +4068,35 @@ retry:
 
         }
 
+        // Prefer an entry which can be reused as-is, falling back to the most
+        // recently used entry with a matching signature
+        bool strict_reuse = single_frame || !params->preserve_mixing_cache;
         struct cached_frame *f = NULL;
         for (int j = 0; j < rr->frames.num; j++) {
-            if (rr->frames.elem[j].signature == sig) {
-                f = &rr->frames.elem[j];
-                f->evict = false;
+            struct cached_frame *e = &rr->frames.elem[j];
+            if (e->signature != sig)
+                continue;
+            if (frame_cache_compatible(e, img, target, out_w, out_h, par_info.hash)) {
+                f = e;
                 break;
+            } else if (!f || e->last_used > f->last_used) {
+                f = e;
             }
         }
 
+        // When retaining frames beyond the current mix, keep incompatible
+        // entries around (for LRU eviction) instead of overwriting them
+        if (f && strict_reuse && params->mixing_cache_size &&
+            !frame_cache_compatible(f, img, target, out_w, out_h, par_info.hash))
+        {
+            f = NULL;
+        }
+
+        if (f) {
+            f->evict = false;
+            f->last_used = rr->frame_counter;
+        }
+
         // Skip frames with negligible contributions. Do this after the loop
         // above to make sure these frames don't get evicted just yet, and
         // also exclude the reference image from this optimization to ensure
@@ -3803,31 +4121,27 @@ retry:
             f = &rr->frames.elem[rr->frames.num++];
             *f = (struct cached_frame) {
                 .signature = sig,
+                .last_used = rr->frame_counter,
             };
         }
 
         // Check to see if we can blindly reuse this cache entry. This is the
         // case if either the params are compatible, or the user doesn't care
         bool can_reuse = f->tex;
-        bool strict_reuse = skip_cache || single_frame ||
-                            !params->preserve_mixing_cache;
-        if (can_reuse && strict_reuse) {
-            can_reuse = f->tex->params.w == out_w &&
-                        f->tex->params.h == out_h &&
-                        pl_rect2d_eq(f->crop, img->crop) &&
-                        f->params_hash == par_info.hash &&
-                        pl_color_space_equal(&f->color, &target->color) &&
-                        pl_icc_profile_equal(&f->profile, &target->profile);
-        }
+        if (can_reuse && strict_reuse)
+            can_reuse = frame_cache_compatible(f, img, target, out_w, out_h, par_info.hash);
 
         if (!can_reuse && skip_cache) {
             PL_TRACE(rr, "Single frame cache entry invalid, bypassing");
             goto fallback;
         }
 
-        if (!can_reuse) {
+        if (can_reuse) {
+            rr->frame_stats.hits++;
+        } else {
             // If we can't reuse the entry, we need to re-render this frame
             PL_TRACE(rr, "  -> Cached texture missing or invalid.. (re)creating");
+            rr->frame_stats.misses++;
             if (!f->tex) {
                 if (PL_ARRAY_POP(rr->frame_fbos, &f->tex))
                     pl_tex_invalidate(rr->gpu, f->tex);
@@ -3929,16 +4243,22 @@ inter_pass_error:
         fidx++;
     }
 
-    // Evict the frames we *don't* need
-    for (int i = 0; i < rr->frames.num; ) {
-        if (rr->frames.elem[i].evict) {
-            PL_TRACE(rr, "Evicting frame with signature %llx from cache",
-                     (unsigned long long) rr->frames.elem[i].signature);
-            PL_ARRAY_APPEND(rr, rr->frame_fbos, rr->frames.elem[i].tex);
-            PL_ARRAY_REMOVE_AT(rr->frames, i);
-            continue;
-        } else {
-            i++;
+    // Evict the frames we *don't* need, or only as many as required to stay
+    // within the configured cache size
+    if (params->mixing_cache_size) {
+        frame_cache_trim(rr, params->mixing_cache_size);
+    } else {
+        for (int i = 0; i < rr->frames.num; ) {
+            if (rr->frames.elem[i].evict) {
+                PL_TRACE(rr, "Evicting frame with signature %llx from cache",
+                         (unsigned long long) rr->frames.elem[i].signature);
+                PL_ARRAY_APPEND(rr, rr->frame_fbos, rr->frames.elem[i].tex);
+                PL_ARRAY_REMOVE_AT(rr->frames, i);
+                rr->frame_stats.evictions++;
+                continue;
+            } else {
+                i++;
+            }
         }
     }
 
@@ -4031,7 +4351,7 @@ fail:
 
 fallback:
     pass_uninit(&pass);
-    return pl_render_image(rr, refimg, ptarget, params);
+    return render_image(rr, refimg, ptarget, params);
 
 error: // for parameter validation failures
     return false;
@@ -4204,6 +4524,41 @@ void pl_frame_clear_rgba(pl_gpu gpu, const struct pl_frame *frame,
     }
 }
 
+struct pl_render_cache_stats pl_renderer_get_cache_stats(pl_renderer rr)
+{
+    struct pl_render_cache_stats stats = rr->frame_stats;
+    stats.num_frames = rr->frames.num;
+    stats.size = frame_cache_size(rr);
+    return stats;
+}
+
+struct pl_render_stats pl_renderer_get_stats(pl_renderer rr)
+{
+    struct pl_render_stats stats = rr->stats;
+    stats.frames = rr->render_counter;
+    return stats;
+}
+
+void pl_renderer_set_timeline(pl_renderer rr, int max_events)
+{
+    pl_dispatch_set_timeline(rr->dp, max_events);
+}
+
+int pl_renderer_get_timeline(pl_renderer rr, struct pl_timeline_event *out,
+                             int max_events)
+{
+    return pl_dispatch_get_timeline(rr->dp, out, max_events);
+}
+
+size_t pl_renderer_save_timeline(pl_renderer rr, uint8_t *out, size_t size)
+{
+    pl_str json = pl_dispatch_save_timeline(rr->dp, NULL);
+    if (out)
+        memcpy(out, json.buf, PL_MIN(json.len, size));
+    pl_free(json.buf);
+    return json.len;
+}
+
 struct pl_render_errors pl_renderer_get_errors(pl_renderer rr)
 {
     return (struct pl_render_errors) {
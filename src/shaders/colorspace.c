@@ -893,7 +893,21 @@ static bool peak_detect_params_eq(const struct pl_peak_detect_params *a,
            a->scene_threshold_low  == b->scene_threshold_low  &&
            a->scene_threshold_high == b->scene_threshold_high &&
            a->percentile           == b->percentile;
-    // don't compare `allow_delayed` because it doesn't change measurement
+    // don't compare `allow_delayed` or `max_delay` because they don't change
+    // the measurement
+}
+
+enum {
+    // Maximum number of frames the peak detection result may be delayed by,
+    // and the corresponding number of in-flight peak detection buffers
+    MAX_PEAK_DELAY  = 3,
+    PEAK_RING_SIZE  = MAX_PEAK_DELAY + 1,
+};
+
+static int peak_delay(const struct pl_peak_detect_params *params)
+{
+    int delay = params->max_delay ? params->max_delay : params->allow_delayed;
+    return PL_CLAMP(delay, 0, MAX_PEAK_DELAY);
 }
 
 enum {
@@ -922,6 +936,11 @@ enum {
 
 
 pl_static_assert(PQ_BITS >= HIST_BITS);
+pl_static_assert(HIST_BINS == PL_HDR_HIST_BINS);
+
+const float pl_hdr_percentiles[PL_HDR_NUM_PERCENTILES] = {
+    1.0f, 5.0f, 10.0f, 25.0f, 50.0f, 75.0f, 90.0f, 95.0f, 99.0f, 99.98f,
+};
 
 struct peak_buf_data {
     unsigned frame_wg_count[SLICES]; // number of work groups processed
@@ -970,7 +989,14 @@ struct sh_color_map_obj {
     // Peak detection state
     struct {
         struct pl_peak_detect_params params;    // currently active parameters
-        pl_buf buf;                             // pending peak detection buffer
+        struct {
+            pl_buf buf;                         // pending peak detection buffer
+            uint64_t frame;                     // frame index of this buffer
+            bool use_histogram;                 // histogram was measured
+        } ring[PEAK_RING_SIZE];
+        int head;                               // index of oldest pending buffer
+        int num_pending;                        // number of pending buffers
+        uint64_t num_frames;                    // total frames submitted
         pl_buf readback;                        // readback buffer (fallback)
         float avg_pq;                           // current (smoothed) values
         float max_pq;
@@ -995,7 +1021,8 @@ static void sh_color_map_uninit(pl_gpu gpu, void *ptr)
     struct sh_color_map_obj *obj = ptr;
     pl_shader_obj_destroy(&obj->tone.lut);
     pl_shader_obj_destroy(&obj->gamut.lut);
-    pl_buf_destroy(gpu, &obj->peak.buf);
+    for (int i = 0; i < PEAK_RING_SIZE; i++)
+        pl_buf_destroy(gpu, &obj->peak.ring[i].buf);
     pl_buf_destroy(gpu, &obj->peak.readback);
     memset(obj, 0, sizeof(*obj));
 }
@@ -1007,19 +1034,38 @@ static inline float iir_coeff(float rate)
     return 1.0f - expf(-1.0f / rate);
 }
 
-static float measure_peak(const struct peak_buf_data *data, float percentile)
+static float measure_max(const struct peak_buf_data *data)
 {
     unsigned frame_max_pq = data->frame_max_pq[0];
     for (int k = 1; k < SLICES; k++)
         frame_max_pq = PL_MAX(frame_max_pq, data->frame_max_pq[k]);
-    const float frame_max = (float) frame_max_pq / PQ_MAX;
-    if (percentile <= 0 || percentile >= 100)
-        return frame_max;
-    unsigned total_pixels = 0;
-    for (int k = 0; k < SLICES; k++) {
+    return (float) frame_max_pq / PQ_MAX;
+}
+
+// Merges all slices into a single histogram. Written as a sum of whole rows so
+// that the compiler can vectorize it.
+static void merge_hist(const struct peak_buf_data *data, unsigned hist[HIST_BINS])
+{
+    memcpy(hist, data->frame_hist[0], sizeof(data->frame_hist[0]));
+    for (int k = 1; k < SLICES; k++) {
         for (int i = 0; i < HIST_BINS; i++)
-            total_pixels += data->frame_hist[k][i];
+            hist[i] += data->frame_hist[k][i];
     }
+}
+
+// Computes the cumulative histogram, returning the total pixel count
+static unsigned hist_cdf(const unsigned hist[HIST_BINS], unsigned cdf[HIST_BINS])
+{
+    unsigned sum = 0;
+    for (int i = 0; i < HIST_BINS; i++)
+        cdf[i] = sum += hist[i];
+    return sum;
+}
+
+static float hist_percentile(const unsigned cdf[HIST_BINS], float frame_max,
+                             float percentile)
+{
+    const unsigned total_pixels = cdf[HIST_BINS - 1];
     if (!total_pixels) // no histogram data available?
         return frame_max;
 
@@ -1027,90 +1073,94 @@ static float measure_peak(const struct peak_buf_data *data, float percentile)
     if (target_pixel >= total_pixels)
         return frame_max;
 
-    unsigned sum = 0;
-    for (int i = 0; i < HIST_BINS; i++) {
-        unsigned next = sum;
-        for (int k = 0; k < SLICES; k++)
-            next += data->frame_hist[k][i];
-        if (next < target_pixel) {
-            sum = next;
-            continue;
+    // Binary search for the first bin reaching `target_pixel`
+    int lo = 0, hi = HIST_BINS - 1;
+    while (lo < hi) {
+        const int mid = (lo + hi) >> 1;
+        if (cdf[mid] < target_pixel) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
         }
-
-        // Upper and lower frequency boundaries of the matching histogram bin
-        const unsigned count_low  = sum;      // last pixel of previous bin
-        const unsigned count_high = next + 1; // first pixel of next bin
-        pl_assert(count_low < target_pixel && target_pixel < count_high);
-
-        // PQ luminance associated with count_low/high respectively
-        const float pq_low  = (float) HIST_PQ(i)     / PQ_MAX;
-        float pq_high       = (float) HIST_PQ(i + 1) / PQ_MAX;
-        if (count_high > total_pixels) // special case for last histogram bin
-            pq_high = frame_max;
-
-        // Position of `target_pixel` inside this bin, assumes pixels are
-        // equidistributed inside a histogram bin
-        const float ratio = (float) (target_pixel - count_low) /
-                                    (count_high - count_low);
-        return PL_MIX(pq_low, pq_high, ratio);
     }
 
-    pl_unreachable();
+    // Upper and lower frequency boundaries of the matching histogram bin
+    const int i = lo;
+    const unsigned count_low  = i ? cdf[i - 1] : 0; // last pixel of previous bin
+    const unsigned count_high = cdf[i] + 1;         // first pixel of next bin
+    pl_assert(count_low < target_pixel && target_pixel < count_high);
+
+    // PQ luminance associated with count_low/high respectively
+    const float pq_low  = (float) HIST_PQ(i)     / PQ_MAX;
+    float pq_high       = (float) HIST_PQ(i + 1) / PQ_MAX;
+    if (count_high > total_pixels) // special case for last histogram bin
+        pq_high = frame_max;
+
+    // Position of `target_pixel` inside this bin, assumes pixels are
+    // equidistributed inside a histogram bin
+    const float ratio = (float) (target_pixel - count_low) /
+                                (count_high - count_low);
+    return PL_MIX(pq_low, pq_high, ratio);
 }
 
-// if `force` is true, ensures the buffer is read, even if `allow_delayed`
-static void update_peak_buf(pl_gpu gpu, struct sh_color_map_obj *obj, bool force)
+static float measure_peak(const struct peak_buf_data *data, float percentile)
 {
-    const struct pl_peak_detect_params *params = &obj->peak.params;
-    if (!obj->peak.buf)
-        return;
+    const float frame_max = measure_max(data);
+    if (percentile <= 0 || percentile >= 100)
+        return frame_max;
 
-    if (!force && params->allow_delayed && pl_buf_poll(gpu, obj->peak.buf, 0))
-        return; // buffer not ready yet
+    unsigned hist[HIST_BINS], cdf[HIST_BINS];
+    merge_hist(data, hist);
+    hist_cdf(hist, cdf);
+    return hist_percentile(cdf, frame_max, percentile);
+}
 
-    bool ok;
-    struct peak_buf_data data = {0};
-    if (obj->peak.readback) {
-        pl_buf_copy(gpu, obj->peak.readback, 0, obj->peak.buf, 0, sizeof(data));
-        ok = pl_buf_read(gpu, obj->peak.readback, 0, &data, sizeof(data));
-    } else {
-        ok = pl_buf_read(gpu, obj->peak.buf, 0, &data, sizeof(data));
-    }
-    if (ok && data.frame_wg_count[0] > 0) {
-        // Peak detection completed successfully
-        pl_buf_destroy(gpu, &obj->peak.buf);
-    } else {
-        // No data read? Possibly this peak obj has not been executed yet
-        if (!ok) {
-            PL_ERR(gpu, "Failed reading peak detection buffer!");
-        } else if (params->allow_delayed) {
-            PL_TRACE(gpu, "Peak detection buffer not yet ready, ignoring..");
-        } else {
-            PL_WARN(gpu, "Peak detection usage error: attempted detecting peak "
-                    "and using detected peak in the same shader program, "
-                    "but `params->allow_delayed` is false! Ignoring, but "
-                    "expect incorrect output.");
-        }
-        if (force || !ok)
-            pl_buf_destroy(gpu, &obj->peak.buf);
+static void export_stats(struct pl_hdr_stats_ring *ring, uint64_t frame,
+                         const struct peak_buf_data *data, float avg_pq,
+                         bool scene_change)
+{
+    if (!ring->frames || ring->size <= 0)
         return;
-    }
 
+    struct pl_hdr_frame_stats *out = &ring->frames[ring->num_frames % ring->size];
+    *out = (struct pl_hdr_frame_stats) {
+        .frame          = frame,
+        .scene_change   = scene_change,
+        .avg_pq         = avg_pq,
+        .max_pq         = measure_max(data),
+    };
+
+    unsigned cdf[HIST_BINS];
+    pl_static_assert(sizeof(out->histogram[0]) == sizeof(unsigned));
+    merge_hist(data, (unsigned *) out->histogram);
+    hist_cdf((unsigned *) out->histogram, cdf);
+    for (int i = 0; i < PL_HDR_NUM_PERCENTILES; i++)
+        out->percentiles[i] = hist_percentile(cdf, out->max_pq, pl_hdr_percentiles[i]);
+
+    ring->num_frames++;
+}
+
+static void update_peak_values(struct sh_color_map_obj *obj, uint64_t frame,
+                               const struct peak_buf_data *data, bool has_hist)
+{
+    const struct pl_peak_detect_params *params = &obj->peak.params;
     uint64_t frame_sum_pq = 0u, frame_wg_count = 0u, frame_wg_active = 0u;
     for (int k = 0; k < SLICES; k++) {
-        frame_sum_pq    += data.frame_sum_pq[k];
-        frame_wg_count  += data.frame_wg_count[k];
-        frame_wg_active += data.frame_wg_active[k];
+        frame_sum_pq    += data->frame_sum_pq[k];
+        frame_wg_count  += data->frame_wg_count[k];
+        frame_wg_active += data->frame_wg_active[k];
     }
     float avg_pq, max_pq;
     if (frame_wg_active) {
         avg_pq = (float) frame_sum_pq / (frame_wg_active * PQ_MAX);
-        max_pq = measure_peak(&data, params->percentile);
+        max_pq = measure_peak(data, params->percentile);
     } else {
         // Solid black frame
         avg_pq = max_pq = PL_COLOR_HDR_BLACK;
     }
 
+    const float frame_avg_pq = avg_pq;
+    bool scene_change = !obj->peak.avg_pq;
     if (!obj->peak.avg_pq) {
         // Set the initial value accordingly if it contains no data
         obj->peak.avg_pq = avg_pq;
@@ -1124,6 +1174,8 @@ static void update_peak_buf(pl_gpu gpu, struct sh_color_map_obj *obj, bool force
             max_pq = obj->peak.max_pq;
     }
 
+    const float prev_avg_pq = obj->peak.avg_pq;
+
     // Use an IIR low-pass filter to smooth out the detected values
     const float coeff = iir_coeff(params->smoothing_period);
     obj->peak.avg_pq += coeff * (avg_pq - obj->peak.avg_pq);
@@ -1139,6 +1191,72 @@ static void update_peak_buf(pl_gpu gpu, struct sh_color_map_obj *obj, bool force
         const float mix_coeff = pl_smoothstep(thresh_low, thresh_high, delta);
         obj->peak.avg_pq = PL_MIX(obj->peak.avg_pq, avg_pq, mix_coeff);
         obj->peak.max_pq = PL_MIX(obj->peak.max_pq, max_pq, mix_coeff);
+        scene_change |= bias * fabsf(avg_pq - prev_avg_pq) >= thresh_high;
+    }
+
+    // Frames measured without the histogram can't be exported
+    if (params->stats && has_hist)
+        export_stats(params->stats, frame, data, frame_avg_pq, scene_change);
+}
+
+static void pop_peak_buf(pl_gpu gpu, struct sh_color_map_obj *obj)
+{
+    pl_buf_destroy(gpu, &obj->peak.ring[obj->peak.head].buf);
+    obj->peak.head = (obj->peak.head + 1) % PEAK_RING_SIZE;
+    obj->peak.num_pending--;
+}
+
+// Consumes all pending peak detection results, in submission order. Results
+// delayed by more than the permitted number of frames are read back even if
+// this blocks; more recent ones only once the GPU is done with them. If
+// `force` is true, stale buffers are discarded even if they contain no data.
+static void update_peak_buf(pl_gpu gpu, struct sh_color_map_obj *obj, bool force)
+{
+    const struct pl_peak_detect_params *params = &obj->peak.params;
+    const int delay = peak_delay(params);
+
+    while (obj->peak.num_pending) {
+        const pl_buf buf = obj->peak.ring[obj->peak.head].buf;
+        const uint64_t frame = obj->peak.ring[obj->peak.head].frame;
+        const bool use_histogram = obj->peak.ring[obj->peak.head].use_histogram;
+        const bool stale = obj->peak.num_pending > delay;
+        if (!stale && pl_buf_poll(gpu, buf, 0))
+            return; // buffer not ready yet, and neither are any later ones
+
+        // Skip reading back the (much larger) histogram if it's unused
+        bool ok;
+        struct peak_buf_data data = {0};
+        size_t size = sizeof(data);
+        if (!use_histogram)
+            size = offsetof(struct peak_buf_data, frame_hist);
+        if (obj->peak.readback) {
+            pl_buf_copy(gpu, obj->peak.readback, 0, buf, 0, size);
+            ok = pl_buf_read(gpu, obj->peak.readback, 0, &data, size);
+        } else {
+            ok = pl_buf_read(gpu, buf, 0, &data, size);
+        }
+
+        if (!ok || !data.frame_wg_count[0]) {
+            // No data read? Possibly this peak obj has not been executed yet
+            if (!ok) {
+                PL_ERR(gpu, "Failed reading peak detection buffer!");
+            } else if (delay) {
+                PL_TRACE(gpu, "Peak detection buffer not yet ready, ignoring..");
+            } else {
+                PL_WARN(gpu, "Peak detection usage error: attempted detecting peak "
+                        "and using detected peak in the same shader program, "
+                        "but `params->allow_delayed` is false! Ignoring, but "
+                        "expect incorrect output.");
+            }
+            if (!(force && stale) && ok)
+                return;
+            pop_peak_buf(gpu, obj);
+            continue;
+        }
+
+        // Peak detection completed successfully
+        pop_peak_buf(gpu, obj);
+        update_peak_values(obj, frame, &data, use_histogram);
     }
 }
 
@@ -1158,7 +1276,8 @@ bool pl_shader_detect_peak(pl_shader sh, struct pl_color_space csp,
         return false;
     }
 
-    const bool use_histogram = params->percentile > 0 && params->percentile < 100;
+    const bool use_histogram = (params->percentile > 0 && params->percentile < 100) ||
+                               params->stats;
     size_t shmem_req = 3 * sizeof(uint32_t);
     if (use_histogram)
         shmem_req += sizeof(uint32_t[HIST_BINS]);
@@ -1177,23 +1296,32 @@ bool pl_shader_detect_peak(pl_shader sh, struct pl_color_space csp,
         return false;
 
     if (peak_detect_params_eq(&obj->peak.params, params)) {
-        update_peak_buf(gpu, obj, true); // prevent over-writing previous frame
+        // Make room for this frame's buffer in the ring, consuming any
+        // results that were delayed for too long. These are exported to the
+        // new `stats` ring, since the old one may no longer be valid
+        obj->peak.params.max_delay = params->max_delay;
+        obj->peak.params.allow_delayed = params->allow_delayed;
+        obj->peak.params.stats = params->stats;
+        update_peak_buf(gpu, obj, true);
     } else {
         pl_reset_detected_peak(*state);
     }
 
-    pl_assert(!obj->peak.buf);
+    pl_assert(obj->peak.num_pending < PEAK_RING_SIZE);
+    const int idx = (obj->peak.head + obj->peak.num_pending) % PEAK_RING_SIZE;
+    pl_buf *buf = &obj->peak.ring[idx].buf;
+    pl_assert(!*buf);
     static const struct peak_buf_data zero = {0};
 
 retry_ssbo:
     if (obj->peak.readback) {
-        obj->peak.buf = pl_buf_create(gpu, pl_buf_params(
+        *buf = pl_buf_create(gpu, pl_buf_params(
             .size           = sizeof(struct peak_buf_data),
             .storable       = true,
             .initial_data   = &zero,
         ));
     } else {
-        obj->peak.buf = pl_buf_create(gpu, pl_buf_params(
+        *buf = pl_buf_create(gpu, pl_buf_params(
             .size           = sizeof(struct peak_buf_data),
             .memory_type    = PL_BUF_MEM_DEVICE,
             .host_readable  = true,
@@ -1202,7 +1330,7 @@ retry_ssbo:
         ));
     }
 
-    if (!obj->peak.buf && !obj->peak.readback) {
+    if (!*buf && !obj->peak.readback) {
         PL_WARN(sh, "Failed creating host-readable peak detection SSBO, "
                 "retrying with fallback buffer");
         obj->peak.readback = pl_buf_create(gpu, pl_buf_params(
@@ -1213,11 +1341,14 @@ retry_ssbo:
             goto retry_ssbo;
     }
 
-    if (!obj->peak.buf) {
+    if (!*buf) {
         SH_FAIL(sh, "Failed creating peak detection SSBO!");
         return false;
     }
 
+    obj->peak.ring[idx].frame = obj->peak.num_frames++;
+    obj->peak.ring[idx].use_histogram = use_histogram;
+    obj->peak.num_pending++;
     obj->peak.params = *params;
 
     sh_desc(sh, (struct pl_shader_desc) {
@@ -1226,7 +1357,7 @@ retry_ssbo:
             .type   = PL_DESC_BUF_STORAGE,
             .access = PL_DESC_ACCESS_READWRITE,
         },
-        .binding.object  = obj->peak.buf,
+        .binding.object  = *buf,
         .buffer_vars     = (struct pl_buffer_var *) peak_buf_vars,
         .num_buffer_vars = PL_ARRAY_SIZE(peak_buf_vars),
     });
@@ -1364,7 +1495,8 @@ void pl_reset_detected_peak(pl_shader_obj state)
 
     struct sh_color_map_obj *obj = state->priv;
     pl_buf readback = obj->peak.readback;
-    pl_buf_destroy(state->gpu, &obj->peak.buf);
+    for (int i = 0; i < PEAK_RING_SIZE; i++)
+        pl_buf_destroy(state->gpu, &obj->peak.ring[i].buf);
     memset(&obj->peak, 0, sizeof(obj->peak));
     obj->peak.readback = readback;
 }
@@ -1598,107 +1730,78 @@ static void fill_gamut_lut(void *data, const struct sh_lut_params *params)
     pl_free(tmp);
 }
 
-void pl_shader_color_map_ex(pl_shader sh, const struct pl_color_map_params *params,
-                            const struct pl_color_map_args *args)
+void pl_color_map_infer(const struct pl_color_map_params *params,
+                        const struct pl_color_space *src,
+                        const struct pl_color_space *dst,
+                        struct pl_tone_map_params *tone,
+                        struct pl_gamut_map_params *gamut)
 {
-    if (!sh_require(sh, PL_SHADER_SIG_COLOR, 0, 0))
-        return;
-
-    struct pl_color_space src = args->src, dst = args->dst;
-    struct sh_color_map_obj *obj = NULL;
-    if (args->state) {
-        pl_get_detected_hdr_metadata(*args->state, &src.hdr);
-        obj = SH_OBJ(sh, args->state, PL_SHADER_OBJ_COLOR_MAP, struct sh_color_map_obj,
-                     sh_color_map_uninit);
-        if (!obj)
-            return;
-    }
-
-    pl_color_space_infer_map(&src, &dst);
-    if (pl_color_space_equal(&src, &dst)) {
-        if (args->prelinearized)
-            pl_shader_delinearize(sh, &dst);
-        return;
-    }
-
-    params = PL_DEF(params, &pl_color_map_default_params);
-    GLSL("// pl_shader_color_map \n"
-         "{                      \n");
-
-    struct pl_tone_map_params tone = {
+    *tone = (struct pl_tone_map_params) {
         .function       = PL_DEF(params->tone_mapping_function, &pl_tone_map_clip),
         .constants      = params->tone_constants,
         .param          = params->tone_mapping_param,
         .input_scaling  = PL_HDR_PQ,
         .output_scaling = PL_HDR_PQ,
         .lut_size       = PL_DEF(params->lut_size, pl_color_map_default_params.lut_size),
-        .hdr            = src.hdr,
+        .hdr            = src->hdr,
     };
 
     pl_color_space_nominal_luma_ex(pl_nominal_luma_params(
-        .color      = &src,
+        .color      = src,
         .metadata   = params->metadata,
-        .scaling    = tone.input_scaling,
-        .out_min    = &tone.input_min,
-        .out_max    = &tone.input_max,
-        .out_avg    = &tone.input_avg,
+        .scaling    = tone->input_scaling,
+        .out_min    = &tone->input_min,
+        .out_max    = &tone->input_max,
+        .out_avg    = &tone->input_avg,
     ));
 
     pl_color_space_nominal_luma_ex(pl_nominal_luma_params(
-        .color      = &dst,
+        .color      = dst,
         .metadata   = PL_HDR_METADATA_HDR10,
-        .scaling    = tone.output_scaling,
-        .out_min    = &tone.output_min,
-        .out_max    = &tone.output_max,
+        .scaling    = tone->output_scaling,
+        .out_min    = &tone->output_min,
+        .out_max    = &tone->output_max,
     ));
 
-    pl_tone_map_params_infer(&tone);
+    pl_tone_map_params_infer(tone);
 
     // Round sufficiently similar values
-    if (fabs(tone.input_max - tone.output_max) < 1e-6)
-        tone.output_max = tone.input_max;
-    if (fabs(tone.input_min - tone.output_min) < 1e-6)
-        tone.output_min = tone.input_min;
+    if (fabs(tone->input_max - tone->output_max) < 1e-6)
+        tone->output_max = tone->input_max;
+    if (fabs(tone->input_min - tone->output_min) < 1e-6)
+        tone->output_min = tone->input_min;
 
     if (!params->inverse_tone_mapping) {
         // Never exceed the source unless requested, but still allow
         // black point adaptation
-        tone.output_max = PL_MIN(tone.output_max, tone.input_max);
+        tone->output_max = PL_MIN(tone->output_max, tone->input_max);
     }
 
     const int *lut3d_size_def = pl_color_map_default_params.lut3d_size;
-    struct pl_gamut_map_params gamut = {
+    *gamut = (struct pl_gamut_map_params) {
         .function        = PL_DEF(params->gamut_mapping, &pl_gamut_map_clip),
         .constants       = params->gamut_constants,
-        .input_gamut     = src.hdr.prim,
-        .output_gamut    = dst.hdr.prim,
+        .input_gamut     = src->hdr.prim,
+        .output_gamut    = dst->hdr.prim,
         .lut_size_I      = PL_DEF(params->lut3d_size[0], lut3d_size_def[0]),
         .lut_size_C      = PL_DEF(params->lut3d_size[1], lut3d_size_def[1]),
         .lut_size_h      = PL_DEF(params->lut3d_size[2], lut3d_size_def[2]),
         .lut_stride      = 3,
     };
 
-    float src_peak_static;
     pl_color_space_nominal_luma_ex(pl_nominal_luma_params(
-        .color      = &src,
+        .color      = dst,
         .metadata   = PL_HDR_METADATA_HDR10,
         .scaling    = PL_HDR_PQ,
-        .out_max    = &src_peak_static,
-    ));
-
-    pl_color_space_nominal_luma_ex(pl_nominal_luma_params(
-        .color      = &dst,
-        .metadata   = PL_HDR_METADATA_HDR10,
-        .scaling    = PL_HDR_PQ,
-        .out_min    = &gamut.min_luma,
-        .out_max    = &gamut.max_luma,
+        .out_min    = &gamut->min_luma,
+        .out_max    = &gamut->max_luma,
     ));
 
     // Clip the gamut mapping output to the input gamut if disabled
-    if (!params->gamut_expansion && gamut.function->bidirectional) {
-        if (pl_primaries_compatible(&gamut.input_gamut, &gamut.output_gamut)) {
-            gamut.output_gamut = pl_primaries_clip(&gamut.output_gamut,
-                                                   &gamut.input_gamut);
+    if (!params->gamut_expansion && gamut->function->bidirectional) {
+        if (pl_primaries_compatible(&gamut->input_gamut, &gamut->output_gamut)) {
+            gamut->output_gamut = pl_primaries_clip(&gamut->output_gamut,
+                                                    &gamut->input_gamut);
         }
     }
 
@@ -1711,25 +1814,57 @@ void pl_shader_color_map_ex(pl_shader sh, const struct pl_color_map_params *para
         case PL_INTENT_RELATIVE_COLORIMETRIC:
             break; // leave default
         case PL_INTENT_SATURATION:
-            gamut.function = &pl_gamut_map_saturation;
+            gamut->function = &pl_gamut_map_saturation;
             break;
         case PL_INTENT_ABSOLUTE_COLORIMETRIC:
-            gamut.function = &pl_gamut_map_absolute;
+            gamut->function = &pl_gamut_map_absolute;
             break;
         }
         break;
     case PL_GAMUT_DARKEN:
-        gamut.function = &pl_gamut_map_darken;
+        gamut->function = &pl_gamut_map_darken;
         break;
     case PL_GAMUT_WARN:
-        gamut.function = &pl_gamut_map_highlight;
+        gamut->function = &pl_gamut_map_highlight;
         break;
     case PL_GAMUT_DESATURATE:
-        gamut.function = &pl_gamut_map_desaturate;
+        gamut->function = &pl_gamut_map_desaturate;
         break;
     case PL_GAMUT_MODE_COUNT:
         pl_unreachable();
     }
+}
+
+void pl_shader_color_map_ex(pl_shader sh, const struct pl_color_map_params *params,
+                            const struct pl_color_map_args *args)
+{
+    if (!sh_require(sh, PL_SHADER_SIG_COLOR, 0, 0))
+        return;
+
+    struct pl_color_space src = args->src, dst = args->dst;
+    struct sh_color_map_obj *obj = NULL;
+    if (args->state) {
+        pl_get_detected_hdr_metadata(*args->state, &src.hdr);
+        obj = SH_OBJ(sh, args->state, PL_SHADER_OBJ_COLOR_MAP, struct sh_color_map_obj,
+                     sh_color_map_uninit);
+        if (!obj)
+            return;
+    }
+
+    pl_color_space_infer_map(&src, &dst);
+    if (pl_color_space_equal(&src, &dst)) {
+        if (args->prelinearized)
+            pl_shader_delinearize(sh, &dst);
+        return;
+    }
+
+    params = PL_DEF(params, &pl_color_map_default_params);
+    GLSL("// pl_shader_color_map \n"
+         "{                      \n");
+
+    struct pl_tone_map_params tone;
+    struct pl_gamut_map_params gamut;
+    pl_color_map_infer(params, &src, &dst, &tone, &gamut);
 
     bool can_fast = !params->force_tone_mapping_lut;
     if (!args->state) {
@@ -317,10 +317,8 @@ void pl_shader_deinterlace(pl_shader sh, const struct pl_deinterlace_source *src
 
 #pragma GLSL /* pl_shader_deinterlace (bwdif) */                                \
         T cur[4];                                                               \
-        cur[0] = GET($cur, 0, -3);                                              \
         cur[1] = GET($cur, 0, -1);                                              \
         cur[2] = GET($cur, 0,  1);                                              \
-        cur[3] = GET($cur, 0,  3);                                              \
                                                                                 \
         @if (!intra_only) {                                                     \
             T prev[2], next[2], prev2[5], next2[5];                             \
@@ -328,21 +326,37 @@ void pl_shader_deinterlace(pl_shader sh, const struct pl_deinterlace_source *src
             prev[1] = GET($prev, 0,  1);                                        \
             next[0] = GET($next, 0, -1);                                        \
             next[1] = GET($next, 0,  1);                                        \
-                                                                                \
-            prev2[0] = GET($prev2, 0, -4);                                      \
-            prev2[1] = GET($prev2, 0, -2);                                      \
             prev2[2] = GET($prev2, 0,  0);                                      \
-            prev2[3] = GET($prev2, 0,  2);                                      \
-            prev2[4] = GET($prev2, 0,  4);                                      \
-                                                                                \
-            next2[0] = GET($next2, 0, -4);                                      \
-            next2[1] = GET($next2, 0, -2);                                      \
             next2[2] = GET($next2, 0,  0);                                      \
-            next2[3] = GET($next2, 0,  2);                                      \
-            next2[4] = GET($next2, 0,  4);                                      \
                                                                                 \
-            res = $process(cur, prev, next, prev2, next2);                      \
+            /* In static areas, the result is always the temporal average, */  \
+            /* so skip the remaining samples and the spatial check */          \
+            T motion = max(abs(prev2[2] - next2[2]),                            \
+                           max(abs(prev[0] - cur[1]) + abs(prev[1] - cur[2]),   \
+                               abs(next[0] - cur[1]) + abs(next[1] - cur[2]))); \
+            @if (num_comps > 1)                                                 \
+            bool is_static = all(equal(motion, T(0.0)));                        \
+            @else                                                               \
+            bool is_static = motion == 0.0;                                     \
+                                                                                \
+            if (is_static) {                                                    \
+                res = (prev2[2] + next2[2]) / 2.0;                              \
+            } else {                                                            \
+                cur[0] = GET($cur, 0, -3);                                      \
+                cur[3] = GET($cur, 0,  3);                                      \
+                prev2[0] = GET($prev2, 0, -4);                                  \
+                prev2[1] = GET($prev2, 0, -2);                                  \
+                prev2[3] = GET($prev2, 0,  2);                                  \
+                prev2[4] = GET($prev2, 0,  4);                                  \
+                next2[0] = GET($next2, 0, -4);                                  \
+                next2[1] = GET($next2, 0, -2);                                  \
+                next2[3] = GET($next2, 0,  2);                                  \
+                next2[4] = GET($next2, 0,  4);                                  \
+                res = $process(cur, prev, next, prev2, next2);                  \
+            }                                                                   \
         @} else {                                                               \
+            cur[0] = GET($cur, 0, -3);                                          \
+            cur[3] = GET($cur, 0,  3);                                          \
             res = $intra(cur);                                                  \
         @}
         break;
@@ -348,23 +348,31 @@ bool pl_shader_error_diffusion(pl_shader sh, const struct pl_error_diffusion_par
     //           X    7/16                X    7/16
     //    3/16  5/16  1/16   ==>    0     0    3/16  5/16  1/16
 
+    // When splitting the image into bands, each work group processes its own
+    // band plus the overlap rows above it, so the effective height of the
+    // shifted rectangle is that of a single (extended) band.
+    const int bands = pl_error_diffusion_bands(params);
+    const int band_height = bands > 1 ? params->band_height : height;
+    const int overlap = bands > 1 ? PL_EDF_BAND_OVERLAP : 0;
+    const int rows = band_height + overlap;
+
     // Figuring out the size of rectangle containing all shifted pixels.
     // The rectangle height is not changed.
-    int shifted_width = width + (height - 1) * kernel->shift;
+    int shifted_width = width + (rows - 1) * kernel->shift;
 
     // We process all pixels from the shifted rectangles column by column, with
-    // a single global work group of size |block_size|.
+    // one work group (per band) of size |block_size|.
     // Figuring out how many block are required to process all pixels. We need
     // this explicitly to make the number of barrier() calls match.
-    int block_size = PL_MIN(glsl.max_group_threads, height);
-    int blocks = PL_DIV_UP(height * shifted_width, block_size);
+    int block_size = PL_MIN(glsl.max_group_threads, rows);
+    int blocks = PL_DIV_UP(rows * shifted_width, block_size);
 
     // If we figure out how many of the next columns will be affected while the
     // current columns is being processed. We can store errors of only a few
     // columns in the shared memory. Using a ring buffer will further save the
     // cost while iterating to next column.
     //
-    int ring_buffer_rows = height + PL_EDF_MAX_DY;
+    int ring_buffer_rows = rows + PL_EDF_MAX_DY;
     int ring_buffer_columns = compute_rightmost_shifted_column(kernel) + 1;
     ident_t ring_buffer_size = sh_const(sh, (struct pl_shader_const) {
         .type = PL_VAR_UINT,
@@ -399,41 +407,52 @@ bool pl_shader_error_diffusion(pl_shader sh, const struct pl_error_diffusion_par
     });
 
     sh->output = PL_SHADER_SIG_NONE;
-    sh_describef(sh, "error diffusion (%s, %d bits)",
-                 kernel->name, params->new_depth);
+    if (bands > 1) {
+        sh_describef(sh, "error diffusion (%s, %d bits, %d bands)",
+                     kernel->name, params->new_depth, bands);
+    } else {
+        sh_describef(sh, "error diffusion (%s, %d bits)",
+                     kernel->name, params->new_depth);
+    }
 
     // Defines the ring buffer in shared memory.
     GLSLH("shared uint err_rgb8["$"]; \n", ring_buffer_size);
     GLSL("// pl_shader_error_diffusion                                          \n"
          // Safeguard against accidental over-execution
-         "if (gl_WorkGroupID != uvec3(0))                                       \n"
+         "if (gl_WorkGroupID.x >= "$" || gl_WorkGroupID.yz != uvec2(0))         \n"
          "    return;                                                           \n"
          // Initialize the ring buffer.
          "for (uint i = gl_LocalInvocationIndex; i < "$"; i+=gl_WorkGroupSize.x)\n"
          "    err_rgb8[i] = 0u;                                                 \n"
+         // First image row of this band, including the overlap
+         "int band_y = int(gl_WorkGroupID.x) * "$" - "$";                       \n"
 
         // Main block loop, add barrier here to have previous block all
         // processed before starting the processing of the next.
          "for (uint block_id = 0; block_id < "$"; block_id++) {                 \n"
          "barrier();                                                            \n"
         // Compute the coordinate of the pixel we are currently processing,
-        // both before and after the shift mapping.
+        // both before and after the shift mapping. `y` is relative to the
+        // band, `img_y` to the image.
          "uint id = block_id * gl_WorkGroupSize.x + gl_LocalInvocationIndex;    \n"
-         "const uint height = "$";                                              \n"
-         "int y = int(id %% height), x_shifted = int(id / height);              \n"
+         "const uint rows = "$";                                                \n"
+         "int y = int(id %% rows), x_shifted = int(id / rows);                  \n"
          "int x = x_shifted - y * %d;                                           \n"
+         "int img_y = band_y + y;                                               \n"
          // Proceed only if we are processing a valid pixel.
-         "if (x >= 0 && x < "$") {                                              \n"
+         "if (x >= 0 && x < "$" && img_y >= 0 && img_y < "$") {                 \n"
          // The index that the current pixel have on the ring buffer.
          "uint idx = uint(x_shifted * "$" + y) %% "$";                          \n"
          // Fetch the current pixel.
-         "vec4 pix_orig = texelFetch("$", ivec2(x, y), 0);                      \n"
+         "vec4 pix_orig = texelFetch("$", ivec2(x, img_y), 0);                  \n"
          "vec3 pix = pix_orig.rgb;                                              \n",
+         SH_UINT(bands),
          ring_buffer_size,
+         SH_INT(band_height), SH_INT(overlap),
          SH_UINT(blocks),
-         SH_UINT(height),
+         SH_UINT(rows),
          kernel->shift,
-         SH_INT(width),
+         SH_INT(width), SH_INT(height),
          SH_INT(ring_buffer_rows),
          ring_buffer_size,
          in_tex);
@@ -472,15 +491,16 @@ bool pl_shader_error_diffusion(pl_shader sh, const struct pl_error_diffusion_par
          "                        int((err_u32 >> %d) & 0xFFu) - 128,           \n"
          "                        int( err_u32        & 0xFFu) - 128) / %d.0;   \n"
          "err_rgb8[idx] = 0u;                                                   \n"
-         // Write the dithered pixel.
+         // Write the dithered pixel, unless it belongs to the overlap
          "vec3 dithered = round(pix);                                           \n"
-         "imageStore("$", ivec2(x, y), vec4(dithered / %d.0, pix_orig.a));      \n"
+         "if (y >= "$")                                                         \n"
+         "    imageStore("$", ivec2(x, img_y), vec4(dithered / %d.0, pix_orig.a));\n"
          // Prepare for error propagation pass
          "vec3 err_divided = (pix - dithered) * %d.0 / %d.0;                    \n"
          "ivec3 tmp;                                                            \n",
          (128u << bitshift_r) | (128u << bitshift_g) | 128u,
          dither_quant, bitshift_r, bitshift_g, uint8_mul,
-         out_img, dither_quant,
+         SH_INT(overlap), out_img, dither_quant,
          uint8_mul, kernel->divisor);
 
     // Group error propagation with same weight factor together, in order to
@@ -40,8 +40,9 @@ static void sh_grain_uninit(pl_gpu gpu, void *ptr)
     pl_shader_obj_destroy(&obj->h274);
 }
 
-bool pl_shader_film_grain(pl_shader sh, pl_shader_obj *grain_state,
-                          const struct pl_film_grain_params *params)
+static bool film_grain(pl_shader sh, pl_shader_obj *grain_state,
+                       const struct pl_film_grain_params *params,
+                       pl_shader input)
 {
     if (!pl_needs_film_grain(params)) {
         // FIXME: Instead of erroring, sample directly
@@ -58,8 +59,22 @@ bool pl_shader_film_grain(pl_shader sh, pl_shader_obj *grain_state,
 
     switch (params->data.type) {
     case PL_FILM_GRAIN_NONE: return false;
-    case PL_FILM_GRAIN_AV1:  return pl_shader_fg_av1(sh, &obj->av1, params);
-    case PL_FILM_GRAIN_H274: return pl_shader_fg_h274(sh, &obj->h274, params);
+    case PL_FILM_GRAIN_AV1:  return pl_shader_fg_av1(sh, &obj->av1, params, input);
+    case PL_FILM_GRAIN_H274: return pl_shader_fg_h274(sh, &obj->h274, params, input);
     default: pl_unreachable();
     }
 }
+
+bool pl_shader_film_grain(pl_shader sh, pl_shader_obj *grain_state,
+                          const struct pl_film_grain_params *params)
+{
+    return film_grain(sh, grain_state, params, NULL);
+}
+
+bool sh_film_grain_fused(pl_shader sh, pl_shader_obj *grain_state,
+                         const struct pl_film_grain_params *params,
+                         pl_shader input)
+{
+    pl_assert(input);
+    return film_grain(sh, grain_state, params, input);
+}
@@ -24,8 +24,21 @@
 bool pl_needs_fg_av1(const struct pl_film_grain_params *);
 bool pl_needs_fg_h274(const struct pl_film_grain_params *);
 
-bool pl_shader_fg_av1(pl_shader, pl_shader_obj *, const struct pl_film_grain_params *);
-bool pl_shader_fg_h274(pl_shader, pl_shader_obj *, const struct pl_film_grain_params *);
+// `input`, if non-NULL, is used as the source of the color values instead of
+// sampling `params->tex` directly. See `sh_film_grain_fused`.
+bool pl_shader_fg_av1(pl_shader, pl_shader_obj *, const struct pl_film_grain_params *,
+                      pl_shader input);
+bool pl_shader_fg_h274(pl_shader, pl_shader_obj *, const struct pl_film_grain_params *,
+                       pl_shader input);
+
+// Like `pl_shader_film_grain`, but fuses the (pointwise) shader `input` into
+// the film grain pass, rather than sampling `params->tex`. `input` must
+// produce exactly one output per pixel of `params->tex`, whose size it must
+// match. `params->tex` itself is then only used for its dimensions. On
+// success, `input` is consumed (via `sh_subpass`).
+bool sh_film_grain_fused(pl_shader sh, pl_shader_obj *grain_state,
+                         const struct pl_film_grain_params *params,
+                         pl_shader input);
 
 // Common helper function
 static inline enum pl_channel channel_map(int i, const struct pl_film_grain_params *params)
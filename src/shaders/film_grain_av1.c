@@ -299,6 +299,61 @@ static struct grain_scale get_grain_scale(const struct pl_film_grain_params *par
     return ret;
 }
 
+// Applies the auto-regressive filter to the grain in `buf`. If `buf_y` is
+// non-NULL, the (subsampled) luma grain is added in as an extra tap. Only the
+// taps in the current row depend on the output of this filter, so the
+// contributions from the previous rows (and luma) are accumulated for the
+// entire row at once, in loops the compiler can vectorize, leaving only
+// `ar_coeff_lag` taps per pixel for the serial pass.
+static void apply_ar_filter(int16_t buf[GRAIN_HEIGHT][GRAIN_WIDTH], int w, int h,
+                            const int8_t *coeffs,
+                            const struct pl_av1_grain_data *data,
+                            const struct grain_scale *scale,
+                            const int16_t buf_y[GRAIN_HEIGHT][GRAIN_WIDTH],
+                            int sub_x, int sub_y)
+{
+    const int ar_pad = 3;
+    const int ar_lag = data->ar_coeff_lag;
+    const int x0 = ar_pad, x1 = w - ar_pad;
+
+    for (int y = ar_pad; y < h; y++) {
+        int sum[GRAIN_WIDTH] = {0};
+        const int8_t *coeff = coeffs;
+        for (int dy = -ar_lag; dy < 0; dy++) {
+            const int16_t *row = buf[y + dy];
+            for (int dx = -ar_lag; dx <= ar_lag; dx++) {
+                const int c = *(coeff++);
+                for (int x = x0; x < x1; x++)
+                    sum[x] += c * row[x + dx];
+            }
+        }
+
+        if (buf_y) {
+            const int c = coeff[ar_lag];
+            const int lumaY = ((y - ar_pad) << sub_y) + ar_pad;
+            for (int x = x0; x < x1; x++) {
+                int luma = 0;
+                int lumaX = ((x - ar_pad) << sub_x) + ar_pad;
+                for (int i = 0; i <= sub_y; i++) {
+                    for (int j = 0; j <= sub_x; j++)
+                        luma += buf_y[lumaY + i][lumaX + j];
+                }
+                sum[x] += round2(luma, sub_x + sub_y) * c;
+            }
+        }
+
+        int16_t *row = buf[y];
+        for (int x = x0; x < x1; x++) {
+            int s = sum[x];
+            for (int dx = -ar_lag; dx < 0; dx++)
+                s += coeff[dx + ar_lag] * row[x + dx];
+
+            int16_t grain = row[x] + round2(s, data->ar_coeff_shift);
+            row[x] = PL_CLAMP(grain, scale->grain_min, scale->grain_max);
+        }
+    }
+}
+
 // Generates the basic grain table (LumaGrain in the spec).
 static void generate_grain_y(float out[GRAIN_HEIGHT_LUT][GRAIN_WIDTH_LUT],
                              int16_t buf[GRAIN_HEIGHT][GRAIN_WIDTH],
@@ -318,26 +373,8 @@ static void generate_grain_y(float out[GRAIN_HEIGHT_LUT][GRAIN_WIDTH_LUT],
         }
     }
 
-    const int ar_pad = 3;
-    int ar_lag = data->ar_coeff_lag;
-
-    for (int y = ar_pad; y < GRAIN_HEIGHT; y++) {
-        for (int x = ar_pad; x < GRAIN_WIDTH - ar_pad; x++) {
-            const int8_t *coeff = data->ar_coeffs_y;
-            int sum = 0;
-            for (int dy = -ar_lag; dy <= 0; dy++) {
-                for (int dx = -ar_lag; dx <= ar_lag; dx++) {
-                    if (!dx && !dy)
-                        break;
-                    sum += *(coeff++) * buf[y + dy][x + dx];
-                }
-            }
-
-            int16_t grain = buf[y][x] + round2(sum, data->ar_coeff_shift);
-            grain = PL_CLAMP(grain, scale.grain_min, scale.grain_max);
-            buf[y][x] = grain;
-        }
-    }
+    apply_ar_filter(buf, GRAIN_WIDTH, GRAIN_HEIGHT, data->ar_coeffs_y, data,
+                    &scale, NULL, 0, 0);
 
     for (int y = 0; y < GRAIN_HEIGHT_LUT; y++) {
         for (int x = 0; x < GRAIN_WIDTH_LUT; x++) {
@@ -380,43 +417,10 @@ static void generate_grain_uv(float *out, int16_t buf[GRAIN_HEIGHT][GRAIN_WIDTH]
         }
     }
 
-    const int ar_pad = 3;
-    int ar_lag = data->ar_coeff_lag;
-
-    for (int y = ar_pad; y < chromaH; y++) {
-        for (int x = ar_pad; x < chromaW - ar_pad; x++) {
-            const int8_t *coeff = coeffs[channel];
-            pl_assert(coeff);
-            int sum = 0;
-            for (int dy = -ar_lag; dy <= 0; dy++) {
-                for (int dx = -ar_lag; dx <= ar_lag; dx++) {
-                    // For the final (current) pixel, we need to add in the
-                    // contribution from the luma grain texture
-                    if (!dx && !dy) {
-                        if (!data->num_points_y)
-                            break;
-                        int luma = 0;
-                        int lumaX = ((x - ar_pad) << sub_x) + ar_pad;
-                        int lumaY = ((y - ar_pad) << sub_y) + ar_pad;
-                        for (int i = 0; i <= sub_y; i++) {
-                            for (int j = 0; j <= sub_x; j++) {
-                                luma += buf_y[lumaY + i][lumaX + j];
-                            }
-                        }
-                        luma = round2(luma, sub_x + sub_y);
-                        sum += luma * (*coeff);
-                        break;
-                    }
-
-                    sum += *(coeff++) * buf[y + dy][x + dx];
-                }
-            }
-
-            int16_t grain = buf[y][x] + round2(sum, data->ar_coeff_shift);
-            grain = PL_CLAMP(grain, scale.grain_min, scale.grain_max);
-            buf[y][x] = grain;
-        }
-    }
+    const bool has_luma = data->num_points_y > 0;
+    pl_assert(coeffs[channel]);
+    apply_ar_filter(buf, chromaW, chromaH, coeffs[channel], data, &scale,
+                    has_luma ? buf_y : NULL, sub_x, sub_y);
 
     int lutW = GRAIN_WIDTH_LUT >> sub_x;
     int lutH = GRAIN_HEIGHT_LUT >> sub_y;
@@ -472,28 +476,31 @@ static void generate_scaling(void *pdata, const struct sh_lut_params *params)
         const struct pl_av1_grain_data *data;
     } *ctx = params->priv;
 
-    float range = 1 << ctx->data->scaling_shift;
+    // The range is a power of two, so multiplying by its inverse is exact
+    const float scale = 1.0f / (1 << ctx->data->scaling_shift);
+    const int num = ctx->num;
 
     // Fill up the preceding entries with the initial value
+    const float first = ctx->points[0][1] * scale;
     for (int i = 0; i < ctx->points[0][0]; i++)
-        data[i] = ctx->points[0][1] / range;
+        data[i] = first;
 
     // Linearly interpolate the values in the middle
-    for (int i = 0; i < ctx->num - 1; i++) {
-        int bx = ctx->points[i][0];
-        int by = ctx->points[i][1];
-        int dx = ctx->points[i + 1][0] - bx;
-        int dy = ctx->points[i + 1][1] - by;
-        int delta = dy * ((0x10000 + (dx >> 1)) / dx);
-        for (int x = 0; x < dx; x++) {
-            int v = by + ((x * delta + 0x8000) >> 16);
-            data[bx + x] = v / range;
-        }
+    for (int i = 0; i < num - 1; i++) {
+        const int bx = ctx->points[i][0];
+        const int by = ctx->points[i][1];
+        const int dx = ctx->points[i + 1][0] - bx;
+        const int dy = ctx->points[i + 1][1] - by;
+        const int delta = dy * ((0x10000 + (dx >> 1)) / dx);
+        float *out = &data[bx];
+        for (int x = 0; x < dx; x++)
+            out[x] = (by + ((x * delta + 0x8000) >> 16)) * scale;
     }
 
     // Fill up the remaining entries with the final value
-    for (int i = ctx->points[ctx->num - 1][0]; i < SCALING_LUT_SIZE; i++)
-        data[i] = ctx->points[ctx->num - 1][1] / range;
+    const float last = ctx->points[num - 1][1] * scale;
+    for (int i = ctx->points[num - 1][0]; i < SCALING_LUT_SIZE; i++)
+        data[i] = last;
 }
 
 static void sample(pl_shader sh, enum offset off, ident_t lut, int idx,
@@ -517,6 +524,23 @@ static void sample(pl_shader sh, enum offset off, ident_t lut, int idx,
          lut, idx >= 0 ? index_strs[idx] : "");
 }
 
+// Previously generated grain tables, kept around so that streams which
+// alternate between a small number of grain presets can skip regenerating them
+struct grain_template {
+    struct pl_film_grain_data data;
+    int bits;
+    int sub_x, sub_y;
+    bool has_y; // affects the chroma grain via the luma AR taps
+    bool has_u, has_v;
+    bool valid;
+    uint64_t last_used;
+
+    float grain_y[GRAIN_HEIGHT_LUT][GRAIN_WIDTH_LUT];
+    float grain_uv[2][GRAIN_HEIGHT_LUT][GRAIN_WIDTH_LUT];
+};
+
+enum { MAX_GRAIN_TEMPLATES = 4 };
+
 struct grain_obj_av1 {
     // LUT objects for the offsets, grain and scaling luts
     pl_shader_obj lut_offsets;
@@ -530,9 +554,12 @@ struct grain_obj_av1 {
     bool fg_has_u;
     bool fg_has_v;
 
+    // Cache of generated grain tables
+    struct grain_template templates[MAX_GRAIN_TEMPLATES];
+    uint64_t template_counter;
+
     // Space to store the temporary arrays, reused
     uint32_t *offsets;
-    float grain[2][GRAIN_HEIGHT_LUT][GRAIN_WIDTH_LUT];
     int16_t grain_tmp_y[GRAIN_HEIGHT][GRAIN_WIDTH];
     int16_t grain_tmp_uv[GRAIN_HEIGHT][GRAIN_WIDTH];
 };
@@ -586,13 +613,70 @@ static inline bool av1_grain_data_eq(const struct pl_film_grain_data *da,
 
 static void fill_grain_lut(void *data, const struct sh_lut_params *params)
 {
-    struct grain_obj_av1 *obj = params->priv;
+    const float *grain = params->priv;
     size_t entries = params->width * params->height * params->comps;
-    memcpy(data, obj->grain, entries * sizeof(float));
+    memcpy(data, grain, entries * sizeof(float));
+}
+
+// Returns the grain tables for the current parameters, (re)generating them
+// into the least recently used slot if not already cached
+static struct grain_template *
+get_grain_template(struct grain_obj_av1 *obj, bool has_u, bool has_v,
+                   int sub_x, int sub_y,
+                   const struct pl_film_grain_params *params)
+{
+    const int bits = bit_depth(params->repr);
+    const bool has_y = params->data.params.av1.num_points_y > 0;
+    struct grain_template *tpl = &obj->templates[0];
+    for (int i = 0; i < MAX_GRAIN_TEMPLATES; i++) {
+        struct grain_template *t = &obj->templates[i];
+        if (t->valid && t->bits == bits && t->sub_x == sub_x &&
+            t->sub_y == sub_y && t->has_y == has_y &&
+            t->has_u == has_u && t->has_v == has_v &&
+            av1_grain_data_eq(&t->data, &params->data))
+        {
+            t->last_used = ++obj->template_counter;
+            return t;
+        }
+
+        if (!t->valid || t->last_used < tpl->last_used)
+            tpl = t;
+    }
+
+    *tpl = (struct grain_template) {
+        .data       = params->data,
+        .bits       = bits,
+        .sub_x      = sub_x,
+        .sub_y      = sub_y,
+        .has_y      = has_y,
+        .has_u      = has_u,
+        .has_v      = has_v,
+        .valid      = true,
+        .last_used  = ++obj->template_counter,
+    };
+
+    // This is needed even for chroma, so statically generate it
+    generate_grain_y(tpl->grain_y, obj->grain_tmp_y, params);
+
+    // Merge the chroma grain into consecutive planes of a single table
+    int chroma_comps = 0;
+    if (has_u) {
+        generate_grain_uv(&tpl->grain_uv[chroma_comps++][0][0],
+                          obj->grain_tmp_uv, obj->grain_tmp_y,
+                          PL_CHANNEL_CB, sub_x, sub_y, params);
+    }
+    if (has_v) {
+        generate_grain_uv(&tpl->grain_uv[chroma_comps++][0][0],
+                          obj->grain_tmp_uv, obj->grain_tmp_y,
+                          PL_CHANNEL_CR, sub_x, sub_y, params);
+    }
+
+    return tpl;
 }
 
 bool pl_shader_fg_av1(pl_shader sh, pl_shader_obj *grain_state,
-                      const struct pl_film_grain_params *params)
+                      const struct pl_film_grain_params *params,
+                      pl_shader input)
 {
     int sub_x = 0, sub_y = 0;
     int tex_w = params->tex->params.w,
@@ -658,10 +742,8 @@ bool pl_shader_fg_av1(pl_shader sh, pl_shader_obj *grain_state,
                         fg_has_u != obj->fg_has_u ||
                         fg_has_v != obj->fg_has_v;
 
-    if (needs_update) {
-        // This is needed even for chroma, so statically generate it
-        generate_grain_y(obj->grain[0], obj->grain_tmp_y, params);
-    }
+    const struct grain_template *tpl;
+    tpl = get_grain_template(obj, fg_has_u, fg_has_v, sub_x, sub_y, params);
 
     ident_t lut[3];
     int idx[3] = {-1};
@@ -677,7 +759,7 @@ bool pl_shader_fg_av1(pl_shader sh, pl_shader_obj *grain_state,
             .update     = needs_update,
             .dynamic    = true,
             .fill       = fill_grain_lut,
-            .priv       = obj,
+            .priv       = (void *) tpl->grain_y,
         ));
 
         if (!lut[0]) {
@@ -688,18 +770,10 @@ bool pl_shader_fg_av1(pl_shader sh, pl_shader_obj *grain_state,
 
     // Try merging the chroma LUTs into a single texture
     int chroma_comps = 0;
-    if (fg_has_u) {
-        generate_grain_uv(&obj->grain[chroma_comps][0][0], obj->grain_tmp_uv,
-                          obj->grain_tmp_y, PL_CHANNEL_CB, sub_x, sub_y,
-                          params);
+    if (fg_has_u)
         idx[1] = chroma_comps++;
-    }
-    if (fg_has_v) {
-        generate_grain_uv(&obj->grain[chroma_comps][0][0], obj->grain_tmp_uv,
-                          obj->grain_tmp_y, PL_CHANNEL_CR, sub_x, sub_y,
-                          params);
+    if (fg_has_v)
         idx[2] = chroma_comps++;
-    }
 
     if (chroma_comps > 0) {
         lut[1] = lut[2] = sh_lut(sh, sh_lut_params(
@@ -712,7 +786,7 @@ bool pl_shader_fg_av1(pl_shader sh, pl_shader_obj *grain_state,
             .update     = needs_update,
             .dynamic    = true,
             .fill       = fill_grain_lut,
-            .priv       = obj,
+            .priv       = (void *) tpl->grain_uv,
         ));
 
         if (!lut[1]) {
@@ -865,18 +939,27 @@ bool pl_shader_fg_av1(pl_shader sh, pl_shader_obj *grain_state,
         maxChroma = SH_FLOAT(1.0);
     }
 
-    // Load the color value of the tex itself
-    ident_t tex = sh_desc(sh, (struct pl_shader_desc) {
-        .binding.object = params->tex,
-        .desc = (struct pl_desc) {
-            .name = "tex",
-            .type = PL_DESC_SAMPLED_TEX,
-        },
-    });
-
+    // Load the color value of the tex itself, or of the fused input shader
     ident_t tex_scale = SH_FLOAT(scale.texture_scale);
-    GLSL("color = vec4("$") * texelFetch("$", ivec2(global_id), 0); \n",
-         tex_scale, tex);
+    if (input) {
+        ident_t src = sh_subpass(sh, input);
+        if (!src) {
+            SH_FAIL(sh, "Failed fusing film grain input shader!");
+            return false;
+        }
+        GLSL("color = vec4("$") * "$"(); \n", tex_scale, src);
+    } else {
+        ident_t tex = sh_desc(sh, (struct pl_shader_desc) {
+            .binding.object = params->tex,
+            .desc = (struct pl_desc) {
+                .name = "tex",
+                .type = PL_DESC_SAMPLED_TEX,
+            },
+        });
+
+        GLSL("color = vec4("$") * texelFetch("$", ivec2(global_id), 0); \n",
+             tex_scale, tex);
+    }
 
     // If we need access to the external luma plane, load it now
     if (tex_is_cb || tex_is_cr) {
@@ -17,6 +17,7 @@
 
 #include "shaders.h"
 #include "shaders/film_grain.h"
+#include "pl_thread.h"
 
 static const int8_t Gaussian_LUT[2048+4];
 static const uint32_t Seed_LUT[256];
@@ -32,7 +33,8 @@ static void prng_shift(uint32_t *state)
 
 
 static void generate_slice(float *out, size_t out_width, uint8_t h, uint8_t v,
-                           int8_t grain[64][64], int16_t tmp[64][64])
+                           const int8_t r64[64][64], int8_t grain[64][64],
+                           int16_t tmp[64][64])
 {
     const uint8_t freq_h = ((h + 3) << 2) - 1;
     const uint8_t freq_v = ((v + 3) << 2) - 1;
@@ -40,39 +42,44 @@ static void generate_slice(float *out, size_t out_width, uint8_t h, uint8_t v,
 
     // Initialize with random gaussian values, using the output array as a
     // temporary buffer for these intermediate values.
-    //
-    // Note: To make the subsequent matrix multiplication cache friendlier, we
-    // store each *column* of the starting image in a *row* of `grain`
     for (int y = 0; y <= freq_v; y++) {
         for (int x = 0; x <= freq_h; x += 4) {
             uint16_t offset = seed % 2048;
-            grain[x + 0][y] = Gaussian_LUT[offset + 0];
-            grain[x + 1][y] = Gaussian_LUT[offset + 1];
-            grain[x + 2][y] = Gaussian_LUT[offset + 2];
-            grain[x + 3][y] = Gaussian_LUT[offset + 3];
+            grain[y][x + 0] = Gaussian_LUT[offset + 0];
+            grain[y][x + 1] = Gaussian_LUT[offset + 1];
+            grain[y][x + 2] = Gaussian_LUT[offset + 2];
+            grain[y][x + 3] = Gaussian_LUT[offset + 3];
             prng_shift(&seed);
         }
     }
 
     grain[0][0] = 0;
 
-    // 64x64 inverse integer transform
+    // 64x64 inverse integer transform. Both passes are written as a sum of
+    // scaled rows (rather than as dot products), so that the inner loops run
+    // over contiguous memory and vectorize without horizontal reductions.
+    int32_t sum[64];
     for (int y = 0; y < 64; y++) {
-        for (int x = 0; x <= freq_h; x++) {
-            int32_t sum = 0;
-            for (int p = 0; p <= freq_v; p++)
-                sum += R64T[y][p] * grain[x][p];
-            tmp[y][x] = (sum + 128) >> 8;
+        memset(sum, 0, sizeof(sum));
+        for (int p = 0; p <= freq_v; p++) {
+            const int32_t c = R64T[y][p];
+            for (int x = 0; x <= freq_h; x++)
+                sum[x] += c * grain[p][x];
         }
+        for (int x = 0; x <= freq_h; x++)
+            tmp[y][x] = (sum[x] + 128) >> 8;
     }
 
     for (int y = 0; y < 64; y++) {
+        memset(sum, 0, sizeof(sum));
+        for (int p = 0; p <= freq_h; p++) {
+            const int32_t c = tmp[y][p];
+            for (int x = 0; x < 64; x++)
+                sum[x] += c * r64[p][x]; // R64T^T = R64
+        }
         for (int x = 0; x < 64; x++) {
-            int32_t sum = 0;
-            for (int p = 0; p <= freq_h; p++)
-                sum += tmp[y][p] * R64T[x][p]; // R64T^T = R64
-            sum = (sum + 128) >> 8;
-            grain[y][x] = PL_CLAMP(sum, -127, 127);
+            int32_t val = (sum[x] + 128) >> 8;
+            grain[y][x] = PL_CLAMP(val, -127, 127);
         }
     }
 
@@ -105,24 +112,70 @@ static void generate_slice(float *out, size_t out_width, uint8_t h, uint8_t v,
     }
 }
 
-static void fill_grain_lut(void *data, const struct sh_lut_params *params)
+struct slice_args {
+    float *out;
+    size_t out_width;
+    const int8_t (*r64)[64];
+    int start, end; // range of slice indices
+};
+
+static PL_THREAD_VOID generate_slices(void *priv)
 {
+    const struct slice_args *args = priv;
     struct {
         int8_t grain[64][64];
         int16_t tmp[64][64];
     } *tmp = pl_alloc_ptr(NULL, tmp);
 
-    float *out = data;
+    for (int i = args->start; i < args->end; i++) {
+        const int h = i / 13, v = i % 13;
+        float *slice = args->out + (h * 64) * args->out_width + (v * 64);
+        generate_slice(slice, args->out_width, h, v, args->r64,
+                       tmp->grain, tmp->tmp);
+    }
+
+    pl_free(tmp);
+    PL_THREAD_RETURN();
+}
+
+static void fill_grain_lut(void *data, const struct sh_lut_params *params)
+{
     assert(params->var_type == PL_VAR_FLOAT);
 
-    for (int h = 0; h < 13; h++) {
-        for (int v = 0; v < 13; v++) {
-            float *slice = out + (h * 64) * params->width + (v * 64);
-            generate_slice(slice, params->width, h, v, tmp->grain, tmp->tmp);
-        }
+    // Transposed copy of R64T, for the second pass of the inverse transform
+    int8_t r64[64][64];
+    for (int y = 0; y < 64; y++) {
+        for (int x = 0; x < 64; x++)
+            r64[y][x] = R64T[x][y];
     }
 
-    pl_free(tmp);
+    enum { NUM_SLICES = 13 * 13, MAX_WORKERS = 13 };
+    struct slice_args args[MAX_WORKERS];
+
+    const int num_per_worker = PL_DIV_UP(NUM_SLICES, MAX_WORKERS);
+    const int num_workers = PL_DIV_UP(NUM_SLICES, num_per_worker);
+    for (int i = 0; i < num_workers; i++) {
+        args[i] = (struct slice_args) {
+            .out        = data,
+            .out_width  = params->width,
+            .r64        = (const int8_t (*)[64]) r64,
+            .start      = i * num_per_worker,
+            .end        = PL_MIN((i + 1) * num_per_worker, NUM_SLICES),
+        };
+    }
+
+    pl_thread workers[MAX_WORKERS] = {0};
+    for (int i = 0; i < num_workers; i++) {
+        if (pl_thread_create(&workers[i], generate_slices, &args[i]) != 0)
+            generate_slices(&args[i]); // fallback
+    }
+
+    for (int i = 0; i < num_workers; i++) {
+        if (!workers[i])
+            continue;
+        if (pl_thread_join(workers[i]) != 0)
+            generate_slices(&args[i]); // fallback
+    }
 }
 
 bool pl_needs_fg_h274(const struct pl_film_grain_params *params)
@@ -143,7 +196,8 @@ bool pl_needs_fg_h274(const struct pl_film_grain_params *params)
 }
 
 bool pl_shader_fg_h274(pl_shader sh, pl_shader_obj *grain_state,
-                       const struct pl_film_grain_params *params)
+                       const struct pl_film_grain_params *params,
+                       pl_shader input)
 {
     if (!sh_require(sh, PL_SHADER_SIG_NONE, params->tex->params.w, params->tex->params.h))
         return false;
@@ -181,18 +235,27 @@ bool pl_shader_fg_h274(pl_shader sh, pl_shader_obj *grain_state,
          "// pl_shader_film_grain (H.274)   \n"
          "{                                 \n");
 
-    // Load the color value of the tex itself
-    ident_t tex = sh_desc(sh, (struct pl_shader_desc) {
-        .binding.object = params->tex,
-        .desc = (struct pl_desc) {
-            .name = "tex",
-            .type = PL_DESC_SAMPLED_TEX,
-        },
-    });
-
-    GLSL("ivec2 pos = ivec2(gl_GlobalInvocationID);     \n"
-         "color = vec4("$") * texelFetch("$", pos, 0);  \n",
-         SH_FLOAT(pl_color_repr_normalize(params->repr)), tex);
+    // Load the color value of the tex itself, or of the fused input shader
+    ident_t tex_scale = SH_FLOAT(pl_color_repr_normalize(params->repr));
+    GLSL("ivec2 pos = ivec2(gl_GlobalInvocationID); \n");
+    if (input) {
+        ident_t src = sh_subpass(sh, input);
+        if (!src) {
+            SH_FAIL(sh, "Failed fusing film grain input shader!");
+            return false;
+        }
+        GLSL("color = vec4("$") * "$"(); \n", tex_scale, src);
+    } else {
+        ident_t tex = sh_desc(sh, (struct pl_shader_desc) {
+            .binding.object = params->tex,
+            .desc = (struct pl_desc) {
+                .name = "tex",
+                .type = PL_DESC_SAMPLED_TEX,
+            },
+        });
+
+        GLSL("color = vec4("$") * texelFetch("$", pos, 0); \n", tex_scale, tex);
+    }
 
     const struct pl_h274_grain_data *data = &params->data.params.h274;
     ident_t scale_factor = sh_var(sh, (struct pl_shader_var) {
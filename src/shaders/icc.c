@@ -17,6 +17,7 @@
 
 #include <math.h>
 #include "shaders.h"
+#include "pl_thread.h"
 
 #include <libplacebo/tone_mapping.h>
 #include <libplacebo/shaders/icc.h>
@@ -38,8 +39,37 @@ struct icc_priv {
     cmsCIEXYZ *white, black;
     float gamma_stddev;
     uint64_t lut_sig;
+
+    // Background 3DLUT generation (for `pl_icc_params.prebuild_luts`)
+    pl_thread prebuild;
+    bool prebuilding;
+    uint16_t *prebuilt[2]; // decode, encode
+    bool prebuild_skip[2]; // already present in the cache
+};
+
+enum {
+    LUT_DECODE,
+    LUT_ENCODE,
 };
 
+static void prebuild_join(struct icc_priv *p)
+{
+    if (p->prebuilding) {
+        pl_thread_join(p->prebuild);
+        p->prebuilding = false;
+    }
+}
+
+static void prebuild_free(struct icc_priv *p)
+{
+    prebuild_join(p);
+    pl_free(p->prebuilt[LUT_DECODE]);
+    pl_free(p->prebuilt[LUT_ENCODE]);
+    p->prebuilt[LUT_DECODE] = p->prebuilt[LUT_ENCODE] = NULL;
+}
+
+static void prebuild_start(pl_icc_object icc);
+
 static void error_callback(cmsContext cms, cmsUInt32Number code,
                            const char *msg)
 {
@@ -80,6 +110,7 @@ void pl_icc_close(pl_icc_object *picc)
         return;
 
     struct icc_priv *p = PL_PRIV(icc);
+    prebuild_free(p);
     cmsCloseProfile(p->approx);
     cmsCloseProfile(p->profile);
     cmsDeleteContext(p->cms);
@@ -517,6 +548,7 @@ static bool icc_init(struct pl_icc_object_t *icc)
                 p->gamma_stddev > 0.5 ? ", inaccurate!" : "");
     }
 
+    prebuild_start(icc);
     return true;
 }
 
@@ -564,6 +596,7 @@ static bool icc_reopen(pl_icc_object kicc, const struct pl_icc_params *params)
 {
     struct pl_icc_object_t *icc = (struct pl_icc_object_t *) kicc;
     struct icc_priv *p = PL_PRIV(icc);
+    prebuild_free(p);
     cmsCloseProfile(p->approx);
     pl_cache_destroy(&p->cache);
 
@@ -621,28 +654,23 @@ bool pl_icc_update(pl_log log, pl_icc_object *out_icc,
     return true;
 }
 
-static void fill_lut(void *datap, const struct sh_lut_params *params, bool decode)
-{
-    pl_icc_object icc = params->priv;
-    struct icc_priv *p = PL_PRIV(icc);
-    cmsHPROFILE srcp = decode ? p->profile : p->approx;
-    cmsHPROFILE dstp = decode ? p->approx  : p->profile;
-    int s_r = params->width, s_g = params->height, s_b = params->depth;
-
-    pl_clock_t start = pl_clock_now();
-    cmsHTRANSFORM tf = cmsCreateTransformTHR(p->cms, srcp, TYPE_RGB_16,
-                                             dstp, TYPE_RGBA_16,
-                                             icc->params.intent,
-                                             cmsFLAGS_BLACKPOINTCOMPENSATION |
-                                             cmsFLAGS_NOCACHE | cmsFLAGS_NOOPTIMIZE);
-    if (!tf)
-        return;
+struct slab_args {
+    pl_icc_object icc;
+    cmsHTRANSFORM tf;
+    uint16_t *data;
+    int start;
+    int count;
+};
 
-    pl_clock_t after_transform = pl_clock_now();
-    pl_log_cpu_time(p->log, start, after_transform, "creating ICC transform");
+static PL_THREAD_VOID fill_slab(void *priv)
+{
+    const struct slab_args *args = priv;
+    pl_icc_object icc = args->icc;
+    int s_r = icc->params.size_r, s_g = icc->params.size_g, s_b = icc->params.size_b;
 
     uint16_t *tmp = pl_alloc(NULL, s_r * 3 * sizeof(tmp[0]));
-    for (int b = 0; b < s_b; b++) {
+    const int end = args->start + args->count;
+    for (int b = args->start; b < end; b++) {
         for (int g = 0; g < s_g; g++) {
             // Transform a single line of the output buffer
             for (int r = 0; r < s_r; r++) {
@@ -652,8 +680,8 @@ static void fill_lut(void *datap, const struct sh_lut_params *params, bool decod
             }
 
             size_t offset = (b * s_g + g) * s_r * 4;
-            uint16_t *data = ((uint16_t *) datap) + offset;
-            cmsDoTransform(tf, tmp, data, s_r);
+            uint16_t *data = args->data + offset;
+            cmsDoTransform(args->tf, tmp, data, s_r);
 
             if (!icc->params.force_bpc)
                 continue;
@@ -674,9 +702,135 @@ static void fill_lut(void *datap, const struct sh_lut_params *params, bool decod
         }
     }
 
+    pl_free(tmp);
+    PL_THREAD_RETURN();
+}
+
+static bool generate_lut(pl_icc_object icc, uint16_t *datap, bool decode)
+{
+    struct icc_priv *p = PL_PRIV(icc);
+    cmsHPROFILE srcp = decode ? p->profile : p->approx;
+    cmsHPROFILE dstp = decode ? p->approx  : p->profile;
+
+    // Since the transform is created with cmsFLAGS_NOCACHE, it can be shared
+    // between multiple threads calling cmsDoTransform concurrently
+    pl_clock_t start = pl_clock_now();
+    cmsHTRANSFORM tf = cmsCreateTransformTHR(p->cms, srcp, TYPE_RGB_16,
+                                             dstp, TYPE_RGBA_16,
+                                             icc->params.intent,
+                                             cmsFLAGS_BLACKPOINTCOMPENSATION |
+                                             cmsFLAGS_NOCACHE | cmsFLAGS_NOOPTIMIZE);
+    if (!tf)
+        return false;
+
+    pl_clock_t after_transform = pl_clock_now();
+    pl_log_cpu_time(p->log, start, after_transform, "creating ICC transform");
+
+    // Split the LUT up into slabs along the B axis, one per worker
+    enum { MAX_WORKERS = 32 };
+    struct slab_args args[MAX_WORKERS];
+    const int s_b = icc->params.size_b;
+    const int num_per_worker = PL_DIV_UP(s_b, MAX_WORKERS);
+    const int num_workers = PL_DIV_UP(s_b, num_per_worker);
+    for (int i = 0; i < num_workers; i++) {
+        const int start_b = i * num_per_worker;
+        args[i] = (struct slab_args) {
+            .icc   = icc,
+            .tf    = tf,
+            .data  = datap,
+            .start = start_b,
+            .count = PL_MIN(num_per_worker, s_b - start_b),
+        };
+    }
+
+    pl_thread workers[MAX_WORKERS] = {0};
+    for (int i = 0; i < num_workers; i++) {
+        if (pl_thread_create(&workers[i], fill_slab, &args[i]) != 0)
+            fill_slab(&args[i]); // fallback
+    }
+
+    for (int i = 0; i < num_workers; i++) {
+        if (!workers[i])
+            continue;
+        if (pl_thread_join(workers[i]) != 0)
+            fill_slab(&args[i]); // fallback
+    }
+
     pl_log_cpu_time(p->log, after_transform, pl_clock_now(), "generating ICC 3DLUT");
     cmsDeleteTransform(tf);
-    pl_free(tmp);
+    return true;
+}
+
+static size_t lut_size(pl_icc_object icc)
+{
+    return (size_t) icc->params.size_r * icc->params.size_g *
+           icc->params.size_b * sizeof(uint16_t[4]);
+}
+
+static PL_THREAD_VOID prebuild_luts(void *priv)
+{
+    pl_icc_object icc = priv;
+    struct icc_priv *p = PL_PRIV(icc);
+    for (int i = 0; i < PL_ARRAY_SIZE(p->prebuilt); i++) {
+        if (p->prebuild_skip[i])
+            continue;
+        p->prebuilt[i] = pl_alloc(NULL, lut_size(icc));
+        if (!generate_lut(icc, p->prebuilt[i], i == LUT_DECODE))
+            pl_free_ptr(&p->prebuilt[i]);
+    }
+
+    PL_THREAD_RETURN();
+}
+
+static void prebuild_start(pl_icc_object icc)
+{
+    struct icc_priv *p = PL_PRIV(icc);
+    if (!icc->params.prebuild_luts)
+        return;
+
+    // Skip generation if the LUTs are already present in the external cache
+    pl_cache cache = PL_DEF(icc->params.cache, p->cache);
+    const uint64_t keys[] = {
+        [LUT_DECODE] = CACHE_KEY_SH_LUT ^ p->lut_sig,
+        [LUT_ENCODE] = CACHE_KEY_SH_LUT ^ ~p->lut_sig,
+    };
+
+    int missing = 0;
+    for (int i = 0; i < PL_ARRAY_SIZE(keys); i++) {
+        pl_cache_obj obj = { .key = keys[i] };
+        p->prebuild_skip[i] = pl_cache_get(cache, &obj);
+        if (p->prebuild_skip[i]) {
+            pl_cache_set(cache, &obj);
+        } else {
+            missing++;
+        }
+    }
+
+    if (!missing)
+        return;
+
+    PL_DEBUG(p, "Generating ICC 3DLUTs in the background");
+    p->prebuilding = pl_thread_create(&p->prebuild, prebuild_luts, (void *) icc) == 0;
+}
+
+static void fill_lut(void *datap, const struct sh_lut_params *params, bool decode)
+{
+    pl_icc_object icc = params->priv;
+    struct icc_priv *p = PL_PRIV(icc);
+    pl_assert(params->width  == icc->params.size_r &&
+              params->height == icc->params.size_g &&
+              params->depth  == icc->params.size_b);
+
+    // Consume the result of background generation, waiting for it if needed
+    prebuild_join(p);
+    uint16_t **prebuilt = &p->prebuilt[decode ? LUT_DECODE : LUT_ENCODE];
+    if (*prebuilt) {
+        memcpy(datap, *prebuilt, lut_size(icc));
+        pl_free_ptr(prebuilt);
+        return;
+    }
+
+    generate_lut(icc, datap, decode);
 }
 
 static void fill_decode(void *datap, const struct sh_lut_params *params)
@@ -19,6 +19,7 @@
 #include <ctype.h>
 
 #include "shaders.h"
+#include "pl_thread.h"
 
 #include <libplacebo/shaders/lut.h>
 
@@ -32,10 +33,158 @@ void pl_lut_free(struct pl_custom_lut **lut)
     pl_free_ptr(lut);
 }
 
-struct pl_custom_lut *pl_lut_parse_cube(pl_log log, const char *cstr, size_t cstr_len)
+enum {
+    CUBE_INVALID = 0,
+    CUBE_DIGIT,
+    CUBE_SPACE,
+};
+
+// Character classes for the LUT body, so that tokenizing is a single table
+// lookup per byte (instead of scanning the set of valid characters)
+static const uint8_t cube_chars[256] = {
+    ['0'] = CUBE_DIGIT, ['1'] = CUBE_DIGIT, ['2'] = CUBE_DIGIT,
+    ['3'] = CUBE_DIGIT, ['4'] = CUBE_DIGIT, ['5'] = CUBE_DIGIT,
+    ['6'] = CUBE_DIGIT, ['7'] = CUBE_DIGIT, ['8'] = CUBE_DIGIT,
+    ['9'] = CUBE_DIGIT, ['.'] = CUBE_DIGIT, ['-'] = CUBE_DIGIT,
+    ['+'] = CUBE_DIGIT, ['e'] = CUBE_DIGIT,
+    [' '] = CUBE_SPACE, ['\n'] = CUBE_SPACE, ['\r'] = CUBE_SPACE,
+    ['\t'] = CUBE_SPACE, ['\v'] = CUBE_SPACE, ['\f'] = CUBE_SPACE,
+};
+
+struct cube_chunk {
+    pl_str str;
+    float *data;    // parsed values, allocated by `parse_cube_chunk`
+    size_t num;     // number of values successfully parsed
+    pl_str error;   // set to the offending token (or character) on failure
+};
+
+static PL_THREAD_VOID parse_cube_chunk(void *priv)
+{
+    struct cube_chunk *chunk = priv;
+    const pl_str str = chunk->str;
+
+    // Every value takes up at least one digit plus one separator
+    chunk->data = pl_alloc(NULL, (str.len / 2 + 1) * sizeof(float));
+    chunk->num = 0;
+
+    size_t pos = 0;
+    while (pos < str.len) {
+        switch (cube_chars[str.buf[pos]]) {
+        case CUBE_SPACE:
+            pos++;
+            continue;
+        case CUBE_INVALID:
+            chunk->error = (pl_str) { &str.buf[pos], 1 };
+            PL_THREAD_RETURN();
+        }
+
+        size_t end = pos + 1;
+        while (end < str.len && cube_chars[str.buf[end]] == CUBE_DIGIT)
+            end++;
+
+        pl_str entry = { &str.buf[pos], end - pos };
+        if (!pl_str_parse_float(entry, &chunk->data[chunk->num])) {
+            chunk->error = entry;
+            PL_THREAD_RETURN();
+        }
+
+        chunk->num++;
+        pos = end;
+    }
+
+    PL_THREAD_RETURN();
+}
+
+// Parses exactly `num` values from `str` into `out`, rescaled to the range
+// [0,1]. Large LUTs are split up at whitespace boundaries and parsed by
+// multiple threads in parallel.
+static bool parse_cube_body(pl_log log, pl_str str, float *out, size_t num,
+                            const float min[3], const float max[3])
+{
+    enum {
+        MAX_WORKERS = 16,
+        MIN_CHUNK_SIZE = 1 << 18, // don't bother splitting up small LUTs
+    };
+
+    struct cube_chunk chunks[MAX_WORKERS] = {0};
+    const int num_chunks = PL_CLAMP(str.len / MIN_CHUNK_SIZE, 1, MAX_WORKERS);
+    const size_t chunk_size = str.len / num_chunks;
+    for (int i = 0; i < num_chunks; i++) {
+        size_t len = str.len;
+        if (i + 1 < num_chunks) {
+            len = PL_MIN(chunk_size, str.len);
+            while (len < str.len && cube_chars[str.buf[len]] != CUBE_SPACE)
+                len++;
+        }
+        chunks[i].str = pl_str_take(str, len);
+        str = pl_str_drop(str, len);
+    }
+
+    pl_thread workers[MAX_WORKERS] = {0};
+    for (int i = 1; i < num_chunks; i++) {
+        if (pl_thread_create(&workers[i], parse_cube_chunk, &chunks[i]) != 0)
+            parse_cube_chunk(&chunks[i]); // fallback
+    }
+
+    parse_cube_chunk(&chunks[0]);
+    for (int i = 1; i < num_chunks; i++) {
+        if (!workers[i])
+            continue;
+        if (pl_thread_join(workers[i]) != 0) {
+            pl_free_ptr(&chunks[i].data);
+            chunks[i].error = (pl_str) {0};
+            parse_cube_chunk(&chunks[i]); // fallback
+        }
+    }
+
+    // Merge the chunks in order, stopping once we have all the values we need
+    bool ok = true;
+    size_t idx = 0;
+    const float range[3] = { max[0] - min[0], max[1] - min[1], max[2] - min[2] };
+    for (int i = 0; i < num_chunks; i++) {
+        const struct cube_chunk *chunk = &chunks[i];
+        const size_t count = PL_MIN(chunk->num, num - idx);
+        for (size_t n = 0; n < count; n++, idx++) {
+            const int c = idx % 3;
+            out[idx] = (chunk->data[n] - min[c]) / range[c];
+        }
+
+        if (idx == num) {
+            bool extra = chunk->num > count || chunk->error.len;
+            for (int j = i + 1; !extra && j < num_chunks; j++)
+                extra = pl_str_strip(chunks[j].str).len;
+            if (extra)
+                pl_warn(log, "Extra data after LUT?... ignoring");
+            break;
+        }
+
+        if (chunk->error.len) {
+            if (chunk->error.len == 1 && cube_chars[chunk->error.buf[0]] != CUBE_DIGIT) {
+                pl_err(log, "Failed parsing LUT: Unexpected '%c', expected "
+                       "digit", chunk->error.buf[0]);
+            } else {
+                pl_err(log, "Failed parsing float value '%.*s'",
+                       PL_STR_FMT(chunk->error));
+            }
+            ok = false;
+            break;
+        }
+    }
+
+    if (ok && idx < num) {
+        pl_err(log, "Failed parsing LUT: Unexpected EOF, expected %zu entries, "
+               "got %zu", num, idx);
+        ok = false;
+    }
+
+    for (int i = 0; i < num_chunks; i++)
+        pl_free(chunks[i].data);
+    return ok;
+}
+
+static struct pl_custom_lut *parse_cube(pl_log log, pl_str str)
 {
     struct pl_custom_lut *lut = pl_zalloc_ptr(NULL, lut);
-    pl_str str = (pl_str) { (uint8_t *) cstr, cstr_len };
     lut->signature = pl_str_hash(str);
     int entries = 0;
 
@@ -138,51 +287,68 @@ struct pl_custom_lut *pl_lut_parse_cube(pl_log log, const char *cstr, size_t cst
 
     // Parse LUT body
     pl_clock_t start = pl_clock_now();
-    for (int n = 0; n < entries; n++) {
-        for (int c = 0; c < 3; c++) {
-            static const char * const digits = "0123456789.-+e";
-
-            // Extract valid digit sequence
-            size_t len = pl_strspn(str, digits);
-            pl_str entry = (pl_str) { str.buf, len };
-            str.buf += len;
-            str.len -= len;
-
-            if (!entry.len) {
-                if (!str.len) {
-                    pl_err(log, "Failed parsing LUT: Unexpected EOF, expected "
-                           "%d entries, got %d", entries * 3, n * 3 + c + 1);
-                } else {
-                    pl_err(log, "Failed parsing LUT: Unexpected '%c', expected "
-                           "digit", str.buf[0]);
-                }
-                goto error;
-            }
+    if (!parse_cube_body(log, str, data, entries * 3, min, max))
+        goto error;
 
-            float num;
-            if (!pl_str_parse_float(entry, &num)) {
-                pl_err(log, "Failed parsing float value '%.*s'", PL_STR_FMT(entry));
-                goto error;
-            }
+    pl_log_cpu_time(log, start, pl_clock_now(), "parsing .cube LUT");
+    return lut;
 
-            // Rescale to range 0.0 - 1.0
-            *data++ = (num - min[c]) / (max[c] - min[c]);
+error:
+    pl_free(lut);
+    return NULL;
+}
+
+struct pl_custom_lut *pl_lut_parse_cube(pl_log log, const char *str, size_t str_len)
+{
+    return pl_lut_parse_cube_cached(log, NULL, str, str_len);
+}
+
+struct cube_cache_header {
+    int32_t size[3];
+};
 
-            // Skip whitespace between digits
-            str = pl_str_strip(str);
+struct pl_custom_lut *pl_lut_parse_cube_cached(pl_log log, pl_cache cache,
+                                               const char *cstr, size_t cstr_len)
+{
+    pl_str str = (pl_str) { (uint8_t *) cstr, cstr_len };
+    const uint64_t signature = pl_str_hash(str);
+    pl_cache_obj obj = { .key = CACHE_KEY_CUBE_LUT ^ signature };
+
+    if (pl_cache_get(cache, &obj)) {
+        const struct cube_cache_header *hdr = obj.data;
+        if (obj.size >= sizeof(*hdr)) {
+            size_t entries = (size_t) hdr->size[0] * PL_DEF(hdr->size[1], 1) *
+                             PL_DEF(hdr->size[2], 1);
+            if (obj.size == sizeof(*hdr) + entries * sizeof(float[3])) {
+                pl_debug(log, "Re-using cached .cube LUT (0x%"PRIx64")", obj.key);
+                struct pl_custom_lut *lut = pl_zalloc_ptr(NULL, lut);
+                lut->signature = signature;
+                for (int i = 0; i < 3; i++)
+                    lut->size[i] = hdr->size[i];
+                lut->data = pl_memdup(lut, (const uint8_t *) obj.data + sizeof(*hdr),
+                                      entries * sizeof(float[3]));
+                pl_cache_set(cache, &obj);
+                return lut;
+            }
         }
+        pl_cache_obj_free(&obj);
     }
 
-    str = pl_str_strip(str);
-    if (str.len)
-        pl_warn(log, "Extra data after LUT?... ignoring '%c'", str.buf[0]);
+    struct pl_custom_lut *lut = parse_cube(log, str);
+    if (!lut || !cache)
+        return lut;
 
-    pl_log_cpu_time(log, start, pl_clock_now(), "parsing .cube LUT");
+    // Store the parsed LUT for future loads of the same file
+    const struct cube_cache_header hdr = {
+        .size = { lut->size[0], lut->size[1], lut->size[2] },
+    };
+    size_t data_size = (size_t) lut->size[0] * PL_DEF(lut->size[1], 1) *
+                       PL_DEF(lut->size[2], 1) * sizeof(float[3]);
+    pl_cache_obj_resize(NULL, &obj, sizeof(hdr) + data_size);
+    memcpy(obj.data, &hdr, sizeof(hdr));
+    memcpy((uint8_t *) obj.data + sizeof(hdr), lut->data, data_size);
+    pl_cache_set(cache, &obj);
     return lut;
-
-error:
-    pl_free(lut);
-    return NULL;
 }
 
 static void fill_lut(void *datap, const struct sh_lut_params *params)
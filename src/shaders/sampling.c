@@ -496,6 +496,16 @@ static void describe_filter(pl_shader sh, const struct pl_filter_config *cfg,
     }
 }
 
+// Minimum possible distance between the texel at offset (x, y) and the
+// sampled position. Since we can't know the subpixel position in advance,
+// this assumes a worst case scenario
+static inline float polar_dmin(int x, int y)
+{
+    int yy = y > 0 ? y-1 : y;
+    int xx = x > 0 ? x-1 : x;
+    return sqrtf(xx*xx + yy*yy);
+}
+
 // Subroutine for computing and adding an individual texel contribution
 // If `in` is NULL, samples directly
 // If `in` is set, takes the pixel from inX[idx] where X is the component,
@@ -505,12 +515,8 @@ static void polar_sample(pl_shader sh, pl_filter filter,
                          int x, int y, uint8_t comp_mask, ident_t in,
                          bool use_ar, ident_t scale)
 {
-    // Since we can't know the subpixel position in advance, assume a
-    // worst case scenario
-    int yy = y > 0 ? y-1 : y;
-    int xx = x > 0 ? x-1 : x;
-    float dmin = sqrt(xx*xx + yy*yy);
     // Skip samples definitely outside the radius
+    const float dmin = polar_dmin(x, y);
     if (dmin >= filter->radius)
         return;
 
@@ -665,12 +671,18 @@ bool pl_shader_sample_polar(pl_shader sh, const struct pl_sample_src *src,
     // Determined experimentally on modern AMD and Nvidia hardware. 32 is a
     // good tradeoff for the horizontal work group size. Apart from that,
     // just use as many threads as possible.
-    int bw = 32, bh = sh_glsl(sh).max_group_threads / bw;
+    const struct pl_glsl_version glsl = sh_glsl(sh);
+    int bw = 32, bh = glsl.max_group_threads / bw;
+    if (params->tile_size[0] > 0 && params->tile_size[1] > 0) {
+        bw = PL_MIN(params->tile_size[0], PL_MAX(glsl.max_group_size[0], 1));
+        bh = PL_MIN(params->tile_size[1], PL_MAX(glsl.max_group_size[1], 1));
+        bh = PL_MAX(PL_MIN(bh, glsl.max_group_threads / bw), 1);
+    }
     int sizew, sizeh, iw, ih;
 
     // Disable compute shaders after a (hard-coded) radius of 6, since the
     // gather kernel generally pulls ahead here.
-    bool is_compute = !params->no_compute && sh_glsl(sh).compute;
+    bool is_compute = !params->no_compute && glsl.compute;
     is_compute &= obj->filter->radius < 6.0;
 
     while (is_compute) {
@@ -687,8 +699,10 @@ bool pl_shader_sample_polar(pl_shader sh, const struct pl_sample_src *src,
             sizeh = PL_ALIGN2(sizeh, 8);
         }
 
-        const int shmem_req = (sizew * sizeh * num_comps + 2) * sizeof(float);
-        if (shmem_req > sh_glsl(sh).max_shmem_size && bh > 1) {
+        // Texel block, filter LUT and base position
+        const int shmem_req = (sizew * sizeh * num_comps + SCALER_LUT_SIZE + 2) *
+                              sizeof(float);
+        if (shmem_req > glsl.max_shmem_size && bh > 1) {
             // Try again with smaller work group size
             bh >>= 1;
             continue;
@@ -769,15 +783,35 @@ bool pl_shader_sample_polar(pl_shader sh, const struct pl_sample_src *src,
             comps &= ~(1 << c);
         }
 
-        GLSL("}}                     \n"
-             "barrier();             \n");
-
-        // Dispatch the actual samples
+        GLSL("}} \n");
+
+        // Also load the filter LUT into shmem, to avoid a dependent texture
+        // fetch for every tap
+        ident_t lut_sh = sh_fresh(sh, "lut_sh"), lut_fn = sh_fresh(sh, "lut_shmem");
+        GLSLH("shared float "$"[%d];                            \n"
+              "float "$"(float x) {                             \n"
+              "    x *= %d.0;                                   \n"
+              "    int i = clamp(int(x), 0, %d);                \n"
+              "    return mix("$"[i], "$"[i + 1], x - float(i)); \n"
+              "}                                                \n",
+              lut_sh, SCALER_LUT_SIZE, lut_fn, SCALER_LUT_SIZE - 1,
+              SCALER_LUT_SIZE - 2, lut_sh, lut_sh);
+
+        GLSL("for (uint i = gl_LocalInvocationIndex; i < %du;          \n"
+             "     i += gl_WorkGroupSize.x * gl_WorkGroupSize.y)        \n"
+             "    "$"[i] = "$"(float(i) / %d.0);                        \n"
+             "barrier();                                                \n",
+             SCALER_LUT_SIZE, lut_sh, lut, SCALER_LUT_SIZE - 1);
+
+        // Dispatch the actual samples. Taps that can never fall inside the
+        // filter radius are culled at shader generation time.
         for (int y = 1 - bound; y <= bound; y++) {
             for (int x = 1 - bound; x <= bound; x++) {
+                if (polar_dmin(x, y) >= obj->filter->radius)
+                    continue;
                 GLSL("idx = "$" * rel.y + rel.x + "$" * %d + %d; \n",
                      sizew_c, sizew_c, y + offset, x + offset);
-                polar_sample(sh, obj->filter, src_tex, lut, radius_c,
+                polar_sample(sh, obj->filter, src_tex, lut_fn, radius_c,
                              x, y, cmask, in, use_ar, scale);
             }
         }
@@ -1,8 +1,10 @@
 #include "utils.h"
 
 #include <libplacebo/dispatch.h>
+#include <libplacebo/dummy.h>
 #include <libplacebo/vulkan.h>
 #include <libplacebo/shaders/colorspace.h>
+#include <libplacebo/shaders/custom.h>
 #include <libplacebo/shaders/deinterlacing.h>
 #include <libplacebo/shaders/sampling.h>
 
@@ -11,6 +13,10 @@ enum {
     NUM_TEX     = 16,
     WIDTH       = 1920,
     HEIGHT      = 1080,
+    WIDTH_4K    = 3840,
+    HEIGHT_4K   = 2160,
+    WIDTH_8K    = 7680,
+    HEIGHT_8K   = 4320,
     DEPTH       = 16,
     COMPS       = 4,
 
@@ -24,7 +30,7 @@ enum {
     WARMUP_MS   = 500,
 };
 
-static pl_tex create_test_img(pl_gpu gpu)
+static pl_tex create_test_img(pl_gpu gpu, float phase)
 {
     pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_FLOAT, COMPS, DEPTH, 32, PL_FMT_CAP_LINEAR);
     REQUIRE(fmt);
@@ -44,9 +50,9 @@ static pl_tex create_test_img(pl_gpu gpu)
             float r2 = xx * xx + yy * yy;
             switch (COMPS) {
             case 4: color[3] = 1.0;
-            case 3: color[2] = 0.5f * sinf(freqB * r2) + 0.5f;;
-            case 2: color[1] = 0.5f * sinf(freqG * r2) + 0.5f;;
-            case 1: color[0] = 0.5f * sinf(freqR * r2) + 0.5f;;
+            case 3: color[2] = 0.5f * sinf(freqB * r2 + phase) + 0.5f;;
+            case 2: color[1] = 0.5f * sinf(freqG * r2 + phase) + 0.5f;;
+            case 1: color[0] = 0.5f * sinf(freqR * r2 + phase) + 0.5f;;
             }
         }
     }
@@ -69,6 +75,9 @@ struct bench {
                    pl_tex src);
 
     void (*run_tex)(pl_gpu gpu, pl_tex tex);
+
+    // Size of the target textures, defaults to WIDTH x HEIGHT
+    int w, h;
 };
 
 static void run_bench(pl_gpu gpu, pl_dispatch dp,
@@ -98,7 +107,7 @@ static void benchmark(pl_gpu gpu, const char *name,
     pl_dispatch dp = pl_dispatch_create(gpu->log, gpu);
     REQUIRE(dp);
     pl_shader_obj state = NULL;
-    pl_tex src = create_test_img(gpu);
+    pl_tex src = create_test_img(gpu, 0.0f);
 
     // Create the FBOs
     pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_FLOAT, COMPS, DEPTH, 32,
@@ -109,8 +118,8 @@ static void benchmark(pl_gpu gpu, const char *name,
     for (int i = 0; i < NUM_TEX; i++) {
         fbos[i] = pl_tex_create(gpu, pl_tex_params(
             .format         = fmt,
-            .w              = WIDTH,
-            .h              = HEIGHT,
+            .w              = PL_DEF(bench->w, WIDTH),
+            .h              = PL_DEF(bench->h, HEIGHT),
             .renderable     = true,
             .blit_dst       = true,
             .host_writable  = true,
@@ -186,6 +195,187 @@ static void benchmark(pl_gpu gpu, const char *name,
         pl_tex_destroy(gpu, &fbos[i]);
 }
 
+// Measures the per-submission overhead of frames consisting of many small
+// passes, e.g. a renderer drawing lots of overlays or individual planes
+static void benchmark_small_passes(pl_gpu gpu, int num_passes)
+{
+    enum { SIZE = 64, FRAMES = 200 };
+    pl_dispatch dp = pl_dispatch_create(gpu->log, gpu);
+    pl_tex src = create_test_img(gpu, 0.0f);
+    pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_UNORM, 4, 8, 8, PL_FMT_CAP_RENDERABLE);
+    REQUIRE(dp && fmt);
+    pl_tex fbo = pl_tex_create(gpu, pl_tex_params(
+        .format     = fmt,
+        .w          = SIZE,
+        .h          = SIZE,
+        .renderable = true,
+    ));
+    REQUIRE(fbo);
+
+    struct pl_vulkan_submit_stats before = {0};
+    pl_clock_t start = 0;
+    for (int f = -1; f < FRAMES; f++) { // first frame is for warmup
+        if (f == 0) {
+            pl_gpu_finish(gpu);
+            before = pl_vulkan_submit_stats(gpu);
+            start = pl_clock_now();
+        }
+
+        for (int i = 0; i < num_passes; i++) {
+            pl_shader sh = pl_dispatch_begin(dp);
+            REQUIRE(pl_shader_sample_direct(sh, pl_sample_src(
+                .tex    = src,
+                .new_w  = SIZE,
+                .new_h  = SIZE,
+            )));
+            REQUIRE(pl_dispatch_finish(dp, pl_dispatch_params(
+                .shader = &sh,
+                .target = fbo,
+            )));
+        }
+        pl_gpu_flush(gpu);
+    }
+
+    pl_gpu_finish(gpu);
+    double secs = pl_clock_diff(pl_clock_now(), start);
+    struct pl_vulkan_submit_stats after = pl_vulkan_submit_stats(gpu);
+    printf("'small_passes x%d':\t%4d frames in %1.6f seconds => %2.6f ms/frame, "
+           "%.1f submissions/frame\n", num_passes, FRAMES, secs,
+           1000 * secs / FRAMES,
+           (double) (after.submissions - before.submissions) / FRAMES);
+
+    pl_tex_destroy(gpu, &fbo);
+    pl_tex_destroy(gpu, &src);
+    pl_dispatch_destroy(&dp);
+}
+
+// Measures the latency of the very first frame, which includes one-time costs
+// such as LUT generation and shader compilation, with both a cold and a warm
+// pl_cache attached to the GPU
+static void benchmark_first_use(pl_gpu gpu, const char *name,
+                                const struct bench *bench)
+{
+    pl_tex src = create_test_img(gpu, 0.0f);
+    pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_FLOAT, COMPS, DEPTH, 32,
+                             PL_FMT_CAP_RENDERABLE);
+    REQUIRE(fmt);
+
+    pl_tex fbo = pl_tex_create(gpu, pl_tex_params(
+        .format         = fmt,
+        .w              = WIDTH,
+        .h              = HEIGHT,
+        .renderable     = true,
+        .storable       = !!(fmt->caps & PL_FMT_CAP_STORABLE),
+    ));
+    REQUIRE(fbo);
+
+    pl_cache cache = pl_cache_create(pl_cache_params( .log = gpu->log ));
+    pl_gpu_set_cache(gpu, cache);
+
+    double secs[2];
+    for (int i = 0; i < PL_ARRAY_SIZE(secs); i++) {
+        // Use a fresh dispatch and state object so that nothing is re-used,
+        // except via the cache
+        pl_dispatch dp = pl_dispatch_create(gpu->log, gpu);
+        REQUIRE(dp);
+        pl_shader_obj state = NULL;
+
+        pl_clock_t start = pl_clock_now();
+        run_bench(gpu, dp, &state, src, fbo, NULL, bench);
+        pl_gpu_finish(gpu);
+        secs[i] = pl_clock_diff(pl_clock_now(), start);
+
+        pl_shader_obj_destroy(&state);
+        pl_dispatch_destroy(&dp);
+    }
+
+    printf("'%s' first use:\t%2.6f ms (cold cache), %2.6f ms (warm cache)\n",
+           name, 1000 * secs[0], 1000 * secs[1]);
+
+    pl_gpu_set_cache(gpu, NULL);
+    pl_cache_destroy(&cache);
+    pl_tex_destroy(gpu, &fbo);
+    pl_tex_destroy(gpu, &src);
+}
+
+// Measures the startup cost of creating many distinct passes, with both a cold
+// and a warm pl_cache attached to the GPU, both one at a time and batched
+static void benchmark_pass_create(pl_gpu gpu, int num_passes)
+{
+    pl_fmt fmt = pl_find_fmt(gpu, PL_FMT_UNORM, 4, 8, 8, PL_FMT_CAP_RENDERABLE);
+    REQUIRE(fmt);
+
+    struct pl_vertex_attrib attrib = {
+        .name     = "pos",
+        .fmt      = pl_find_vertex_fmt(gpu, PL_FMT_FLOAT, 2),
+        .location = 0,
+    };
+    REQUIRE(attrib.fmt);
+
+    static const char *vert_shader =
+        "#version 450                                   \n"
+        "layout(location=0) in vec2 pos;                \n"
+        "void main() {                                  \n"
+        "    gl_Position = vec4(pos, 0.0, 1.0);         \n"
+        "}";
+
+    char (*frag_shaders)[128] = calloc(num_passes, sizeof(*frag_shaders));
+    struct pl_pass_params *params = calloc(num_passes, sizeof(*params));
+    pl_pass *passes = calloc(num_passes, sizeof(*passes));
+    REQUIRE(frag_shaders && params && passes);
+    for (int n = 0; n < num_passes; n++) {
+        snprintf(frag_shaders[n], sizeof(frag_shaders[n]),
+            "#version 450                               \n"
+            "layout(location=0) out vec4 out_color;     \n"
+            "void main() {                              \n"
+            "    out_color = vec4(%d.0 / %d.0);         \n"
+            "}", n, num_passes);
+
+        params[n] = (struct pl_pass_params) {
+            .type               = PL_PASS_RASTER,
+            .target_format      = fmt,
+            .vertex_shader      = vert_shader,
+            .glsl_shader        = frag_shaders[n],
+            .vertex_type        = PL_PRIM_TRIANGLE_STRIP,
+            .vertex_stride      = PL_ALIGN(attrib.fmt->texel_size,
+                                           gpu->limits.align_vertex_stride),
+            .num_vertex_attribs = 1,
+            .vertex_attribs     = &attrib,
+        };
+    }
+
+    for (int batched = 0; batched <= 1; batched++) {
+        pl_cache cache = pl_cache_create(pl_cache_params( .log = gpu->log ));
+        pl_gpu_set_cache(gpu, cache);
+
+        double secs[2];
+        for (int i = 0; i < PL_ARRAY_SIZE(secs); i++) {
+            pl_clock_t start = pl_clock_now();
+            if (batched) {
+                int num = pl_pass_create_batch(gpu, params, num_passes, passes);
+                REQUIRE_CMP(num, ==, num_passes, "d");
+            } else {
+                for (int n = 0; n < num_passes; n++)
+                    REQUIRE((passes[n] = pl_pass_create(gpu, &params[n])));
+            }
+            secs[i] = pl_clock_diff(pl_clock_now(), start);
+
+            for (int n = 0; n < num_passes; n++)
+                pl_pass_destroy(gpu, &passes[n]);
+        }
+
+        printf("'pass_create%s x%d':\t%2.6f ms (cold cache), %2.6f ms (warm cache)\n",
+               batched ? "_batch" : "", num_passes, 1000 * secs[0], 1000 * secs[1]);
+
+        pl_gpu_set_cache(gpu, NULL);
+        pl_cache_destroy(&cache);
+    }
+
+    free(frag_shaders);
+    free(params);
+    free(passes);
+}
+
 // List of benchmarks
 static void bench_deband(pl_shader sh, pl_shader_obj *state, pl_tex src)
 {
@@ -267,6 +457,42 @@ static void bench_polar_nocompute(pl_shader sh, pl_shader_obj *state, pl_tex src
     REQUIRE(pl_shader_sample_polar(sh, pl_sample_src( .tex = src ), &params));
 }
 
+static void bench_polar_scaled(pl_shader sh, pl_shader_obj *state, pl_tex src,
+                               const struct pl_filter_config *filter, int scale)
+{
+    struct pl_sample_filter_params params = {
+        .filter = *filter,
+        .lut = state,
+    };
+
+    REQUIRE(pl_shader_sample_polar(sh, pl_sample_src(
+        .tex    = src,
+        .rect   = { 0, 0, WIDTH / scale, HEIGHT / scale },
+        .new_w  = WIDTH,
+        .new_h  = HEIGHT,
+    ), &params));
+}
+
+static void bench_ewa_lanczos_2x(pl_shader sh, pl_shader_obj *state, pl_tex src)
+{
+    bench_polar_scaled(sh, state, src, &pl_filter_ewa_lanczos, 2);
+}
+
+static void bench_ewa_lanczos_4x(pl_shader sh, pl_shader_obj *state, pl_tex src)
+{
+    bench_polar_scaled(sh, state, src, &pl_filter_ewa_lanczos, 4);
+}
+
+static void bench_ewa_lanczossharp_2x(pl_shader sh, pl_shader_obj *state, pl_tex src)
+{
+    bench_polar_scaled(sh, state, src, &pl_filter_ewa_lanczossharp, 2);
+}
+
+static void bench_ewa_lanczossharp_4x(pl_shader sh, pl_shader_obj *state, pl_tex src)
+{
+    bench_polar_scaled(sh, state, src, &pl_filter_ewa_lanczossharp, 4);
+}
+
 static void bench_hdr_peak(pl_shader sh, pl_shader_obj *state, pl_tex src)
 {
     REQUIRE(pl_shader_sample_direct(sh, pl_sample_src( .tex = src )));
@@ -349,6 +575,52 @@ static void bench_yadif(pl_shader sh, pl_shader_obj *state, pl_tex src)
     ));
 }
 
+static void bench_bwdif(pl_shader sh, pl_shader_obj *state, pl_tex src)
+{
+    struct pl_deinterlace_source dsrc = {
+        .prev = pl_field_pair(src),
+        .cur = pl_field_pair(src),
+        .next = pl_field_pair(src),
+        .field = PL_FIELD_TOP,
+    };
+
+    pl_shader_deinterlace(sh, &dsrc, pl_deinterlace_params(
+        .algo = PL_DEINTERLACE_BWDIF,
+    ));
+}
+
+// Phase-shifted copy of the test image, used as the neighbouring frames to
+// simulate full-frame motion (i.e. no static areas)
+static pl_tex motion_ref;
+
+static void bench_yadif_motion(pl_shader sh, pl_shader_obj *state, pl_tex src)
+{
+    struct pl_deinterlace_source dsrc = {
+        .prev = pl_field_pair(motion_ref),
+        .cur = pl_field_pair(src),
+        .next = pl_field_pair(motion_ref),
+        .field = PL_FIELD_TOP,
+    };
+
+    pl_shader_deinterlace(sh, &dsrc, pl_deinterlace_params(
+        .algo = PL_DEINTERLACE_YADIF,
+    ));
+}
+
+static void bench_bwdif_motion(pl_shader sh, pl_shader_obj *state, pl_tex src)
+{
+    struct pl_deinterlace_source dsrc = {
+        .prev = pl_field_pair(motion_ref),
+        .cur = pl_field_pair(src),
+        .next = pl_field_pair(motion_ref),
+        .field = PL_FIELD_TOP,
+    };
+
+    pl_shader_deinterlace(sh, &dsrc, pl_deinterlace_params(
+        .algo = PL_DEINTERLACE_BWDIF,
+    ));
+}
+
 static void bench_av1_grain(pl_shader sh, pl_shader_obj *state, pl_tex src)
 {
     struct pl_film_grain_params params = {
@@ -439,7 +711,7 @@ static void bench_reshape_mmr(pl_shader sh, pl_shader_obj *state, pl_tex src)
     pl_shader_dovi_reshape(sh, &dovi_meta); // this includes MMR
 }
 
-static float data[WIDTH * HEIGHT * COMPS + 8192];
+static float data[WIDTH_4K * HEIGHT_4K * COMPS + 8192];
 
 static void bench_download(pl_gpu gpu, pl_tex tex)
 {
@@ -457,8 +729,28 @@ static void bench_upload(pl_gpu gpu, pl_tex tex)
     )));
 }
 
+// Forces the use of (pooled) staging buffers, rather than host pointer import
+static void bench_download_staging(pl_gpu gpu, pl_tex tex)
+{
+    REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+        .tex = tex,
+        .ptr = data,
+        .no_import = true,
+    )));
+}
+
 static void dummy_cb(void *arg) {}
 
+static void bench_download_staging_async(pl_gpu gpu, pl_tex tex)
+{
+    REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+        .tex = tex,
+        .ptr = data,
+        .no_import = true,
+        .callback = dummy_cb,
+    )));
+}
+
 static void bench_download_async(pl_gpu gpu, pl_tex tex)
 {
     REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
@@ -477,6 +769,85 @@ static void bench_upload_async(pl_gpu gpu, pl_tex tex)
     )));
 }
 
+// Measures the throughput of host transfers for an 8K rgba8 plane on a dummy
+// GPU with a (small) forced `max_buf_size`, which requires splitting every
+// transfer into multiple slices
+static void benchmark_sliced(pl_log log, size_t max_buf_size)
+{
+    struct pl_gpu_dummy_params params = pl_gpu_dummy_default_params;
+    struct pl_gpu_limits *limits = &params.limits;
+    limits->max_buf_size = limits->max_ubo_size = limits->max_ssbo_size =
+    limits->max_vbo_size = limits->max_mapped_size = max_buf_size;
+    pl_gpu gpu = pl_gpu_dummy_create(log, &params);
+    REQUIRE(gpu);
+
+    pl_tex tex = pl_tex_create(gpu, pl_tex_params(
+        .w              = WIDTH_8K,
+        .h              = HEIGHT_8K,
+        .format         = pl_find_named_fmt(gpu, "rgba8"),
+        .host_writable  = true,
+        .host_readable  = true,
+    ));
+    REQUIRE(tex);
+
+    const double size_mb = WIDTH_8K * HEIGHT_8K * 4 / 1e6;
+    static const char *names[] = { "upload", "download" };
+    for (int i = 0; i < PL_ARRAY_SIZE(names); i++) {
+        const struct pl_tex_transfer_params xfer = {
+            .tex = tex,
+            .ptr = data,
+        };
+
+        unsigned long frames = 0;
+        pl_clock_t start = pl_clock_now();
+        double secs;
+        do {
+            REQUIRE(i ? pl_tex_download(gpu, &xfer) : pl_tex_upload(gpu, &xfer));
+            frames++;
+            secs = pl_clock_diff(pl_clock_now(), start);
+        } while (secs < TEST_MS * 1e-3);
+
+        printf("'sliced %s 8K (%zu KiB)':\t%4lu frames in %1.6f seconds => "
+               "%2.6f ms/frame (%5.2f MB/s)\n", names[i], max_buf_size >> 10,
+               frames, secs, 1000 * secs / frames, frames * size_mb / secs);
+    }
+
+    pl_tex_destroy(gpu, &tex);
+    pl_gpu_dummy_destroy(&gpu);
+}
+
+// Simulates a mixed allocation workload, e.g. a renderer creating FBOs, LUTs
+// and overlay textures of differing sizes
+static void bench_alloc_mixed(pl_gpu gpu, pl_tex unused)
+{
+    static const int sizes[][2] = {
+        {1920, 1080}, {960, 540}, {256, 16}, {64, 64}, {333, 77},
+        {4096, 1}, {1280, 720}, {17, 17}, {640, 360}, {128, 1024},
+    };
+
+    pl_fmt fmt = pl_find_named_fmt(gpu, "rgba8");
+    pl_tex texs[PL_ARRAY_SIZE(sizes)];
+    pl_buf bufs[PL_ARRAY_SIZE(sizes)];
+    for (int i = 0; i < PL_ARRAY_SIZE(sizes); i++) {
+        texs[i] = pl_tex_create(gpu, pl_tex_params(
+            .w          = sizes[i][0],
+            .h          = sizes[i][1],
+            .format     = fmt,
+            .sampleable = true,
+        ));
+        bufs[i] = pl_buf_create(gpu, pl_buf_params(
+            .size       = sizes[i][0] * sizes[i][1],
+            .uniform    = true,
+        ));
+        REQUIRE(texs[i] && bufs[i]);
+    }
+
+    for (int i = 0; i < PL_ARRAY_SIZE(sizes); i++) {
+        pl_tex_destroy(gpu, &texs[i]);
+        pl_buf_destroy(gpu, &bufs[i]);
+    }
+}
+
 int main()
 {
     setbuf(stdout, NULL);
@@ -487,6 +858,10 @@ int main()
         .log_level  = PL_LOG_WARN,
     ));
 
+    // Host transfers, which don't need a real GPU
+    benchmark_sliced(log, 1 << 20);
+    benchmark_sliced(log, 16 << 20);
+
     pl_vulkan vk = pl_vulkan_create(log, pl_vulkan_params(
         .allow_software = true,
         .async_transfer = ASYNC_TX,
@@ -499,12 +874,17 @@ int main()
 
 #define BENCH_SH(fn)  &(struct bench) { .run_sh = fn }
 #define BENCH_TEX(fn) &(struct bench) { .run_tex = fn }
+#define BENCH_TEX_4K(fn) &(struct bench) { .run_tex = fn, .w = WIDTH_4K, .h = HEIGHT_4K }
 
     printf("= Running benchmarks =\n");
     benchmark(vk->gpu, "tex_download ptr", BENCH_TEX(bench_download));
     benchmark(vk->gpu, "tex_download ptr async", BENCH_TEX(bench_download_async));
     benchmark(vk->gpu, "tex_upload ptr", BENCH_TEX(bench_upload));
     benchmark(vk->gpu, "tex_upload ptr async", BENCH_TEX(bench_upload_async));
+    benchmark(vk->gpu, "tex_download staging", BENCH_TEX(bench_download_staging));
+    benchmark(vk->gpu, "tex_download staging async", BENCH_TEX(bench_download_staging_async));
+    benchmark(vk->gpu, "tex_download staging 4K", BENCH_TEX_4K(bench_download_staging));
+    benchmark(vk->gpu, "tex_download staging 4K async", BENCH_TEX_4K(bench_download_staging_async));
     benchmark(vk->gpu, "bilinear", BENCH_SH(bench_bilinear));
     benchmark(vk->gpu, "bicubic", BENCH_SH(bench_bicubic));
     benchmark(vk->gpu, "hermite", BENCH_SH(bench_hermite));
@@ -516,11 +896,20 @@ int main()
     benchmark(vk->gpu, "weave", BENCH_SH(bench_weave));
     benchmark(vk->gpu, "bob", BENCH_SH(bench_bob));
     benchmark(vk->gpu, "yadif", BENCH_SH(bench_yadif));
+    benchmark(vk->gpu, "bwdif", BENCH_SH(bench_bwdif));
+    motion_ref = create_test_img(vk->gpu, 1.0f);
+    benchmark(vk->gpu, "yadif motion", BENCH_SH(bench_yadif_motion));
+    benchmark(vk->gpu, "bwdif motion", BENCH_SH(bench_bwdif_motion));
+    pl_tex_destroy(vk->gpu, &motion_ref);
 
     // Polar sampling
     benchmark(vk->gpu, "polar", BENCH_SH(bench_polar));
     if (vk->gpu->glsl.compute)
         benchmark(vk->gpu, "polar_nocompute", BENCH_SH(bench_polar_nocompute));
+    benchmark(vk->gpu, "ewa_lanczos 2x", BENCH_SH(bench_ewa_lanczos_2x));
+    benchmark(vk->gpu, "ewa_lanczos 4x", BENCH_SH(bench_ewa_lanczos_4x));
+    benchmark(vk->gpu, "ewa_lanczossharp 2x", BENCH_SH(bench_ewa_lanczossharp_2x));
+    benchmark(vk->gpu, "ewa_lanczossharp 4x", BENCH_SH(bench_ewa_lanczossharp_4x));
 
     // Dithering algorithms
     benchmark(vk->gpu, "dither_blue", BENCH_SH(bench_dither_blue));
@@ -544,6 +933,27 @@ int main()
     benchmark(vk->gpu, "reshape_poly", BENCH_SH(bench_reshape_poly));
     benchmark(vk->gpu, "reshape_mmr", BENCH_SH(bench_reshape_mmr));
 
+    // Submission overhead
+    benchmark_small_passes(vk->gpu, 16);
+    benchmark_small_passes(vk->gpu, 256);
+
+    // First-use latency
+    benchmark_first_use(vk->gpu, "h274_grain", BENCH_SH(bench_h274_grain));
+    benchmark_pass_create(vk->gpu, 64);
+
+    // Memory allocation, with both sub-allocators
+    benchmark(vk->gpu, "alloc_mixed", BENCH_TEX(bench_alloc_mixed));
+    pl_vulkan_destroy(&vk);
+
+    vk = pl_vulkan_create(log, pl_vulkan_params(
+        .allow_software = true,
+        .async_transfer = ASYNC_TX,
+        .async_compute  = ASYNC_COMP,
+        .queue_count    = NUM_QUEUES,
+        .malloc_tlsf    = true,
+    ));
+    REQUIRE(vk);
+    benchmark(vk->gpu, "alloc_mixed tlsf", BENCH_TEX(bench_alloc_mixed));
     pl_vulkan_destroy(&vk);
     pl_log_destroy(&log);
     return 0;
@@ -0,0 +1,159 @@
+#include "utils.h"
+
+#include <libplacebo/color_pipeline.h>
+
+#define NUM_PIXELS (1 << 16)
+
+int main()
+{
+    pl_log log = pl_test_logger();
+
+    // Test that a pure transfer conversion matches `pl_color_linearize`
+    static float planes[3][NUM_PIXELS];
+    for (int i = 0; i < NUM_PIXELS; i++) {
+        planes[0][i] = (float) i / (NUM_PIXELS - 1);
+        planes[1][i] = (float) (i % 256) / 255;
+        planes[2][i] = 1.0f - planes[0][i];
+    }
+
+    pl_color_pipeline pipe = pl_color_pipeline_create(log, pl_color_pipeline_params(
+        .src_csp = pl_color_space_srgb,
+        .dst_csp = {
+            .primaries = PL_COLOR_PRIM_BT_709,
+            .transfer  = PL_COLOR_TRC_LINEAR,
+        },
+    ));
+    REQUIRE(pipe);
+
+    const struct pl_color_buf planar = {
+        .type = PL_COLOR_BUF_FLOAT,
+        .data = { planes[0], planes[1], planes[2] },
+    };
+
+    static float lin[3][NUM_PIXELS];
+    const struct pl_color_buf planar_lin = {
+        .type = PL_COLOR_BUF_FLOAT,
+        .data = { lin[0], lin[1], lin[2] },
+    };
+
+    pl_color_pipeline_apply(pipe, &planar, &planar_lin, NUM_PIXELS);
+    for (int i = 0; i < NUM_PIXELS; i += 97) {
+        float ref[3] = { planes[0][i], planes[1][i], planes[2][i] };
+        pl_color_linearize(&pl_color_space_srgb, ref);
+        for (int c = 0; c < 3; c++)
+            REQUIRE_FEQ(lin[c][i], ref[c], 1e-4);
+    }
+    pl_color_pipeline_destroy(&pipe);
+    REQUIRE(!pipe);
+
+    // Test YCbCr decoding from interleaved 10-bit samples, against the matrix
+    struct pl_color_repr repr = pl_color_repr_hdtv;
+    repr.bits = (struct pl_bit_encoding) { .sample_depth = 16, .color_depth = 10 };
+    pipe = pl_color_pipeline_create(log, pl_color_pipeline_params(
+        .src_repr = repr,
+        .src_csp  = pl_color_space_bt709,
+        .dst_repr = pl_color_repr_rgb,
+        .dst_csp  = pl_color_space_bt709,
+    ));
+    REQUIRE(pipe);
+
+    static const uint16_t yuv[][4] = {
+        {  64, 512, 512, 1 },
+        { 940, 512, 512, 2 },
+        { 502, 300, 700, 3 },
+    };
+    static float rgb[PL_ARRAY_SIZE(yuv)][4];
+    pl_color_pipeline_apply(pipe, &(struct pl_color_buf) {
+        .type = PL_COLOR_BUF_UINT16,
+        .data = { (void *) &yuv[0][0], (void *) &yuv[0][1], (void *) &yuv[0][2] },
+        .pixel_stride = sizeof(yuv[0]),
+    }, &(struct pl_color_buf) {
+        .type = PL_COLOR_BUF_FLOAT,
+        .data = { &rgb[0][0], &rgb[0][1], &rgb[0][2] },
+        .pixel_stride = sizeof(rgb[0]),
+    }, PL_ARRAY_SIZE(yuv));
+
+    struct pl_color_repr copy = repr;
+    pl_transform3x3 tr = pl_color_repr_decode(&copy, NULL);
+    for (int i = 0; i < PL_ARRAY_SIZE(yuv); i++) {
+        float ref[3] = { yuv[i][0] / 65535.0f, yuv[i][1] / 65535.0f, yuv[i][2] / 65535.0f };
+        pl_transform3x3_apply(&tr, ref);
+        for (int c = 0; c < 3; c++)
+            REQUIRE_FEQ(rgb[i][c], ref[c], 1e-5);
+        REQUIRE_FEQ(rgb[i][3], 0.0f, 1e-9); // untouched
+    }
+    REQUIRE_FEQ(rgb[0][0], 0.0f, 1e-5);
+    REQUIRE_FEQ(rgb[1][0], 1.0f, 1e-5);
+    pl_color_pipeline_destroy(&pipe);
+
+    // Test HDR tone and gamut mapping on packed 16-bit samples
+    static uint16_t hdr[NUM_PIXELS][4];
+    for (int i = 0; i < NUM_PIXELS; i++) {
+        hdr[i][0] = i;
+        hdr[i][1] = (i * 7) & 0xFFFF;
+        hdr[i][2] = (i * 13) & 0xFFFF;
+        hdr[i][3] = 0xABCD;
+    }
+
+    const struct pl_color_buf packed = {
+        .type = PL_COLOR_BUF_UINT16,
+        .data = { &hdr[0][0], &hdr[0][1], &hdr[0][2] },
+        .pixel_stride = sizeof(hdr[0]),
+    };
+
+    for (int i = 0; i < pl_num_tone_map_functions; i++) {
+        const struct pl_tone_map_function *fun = pl_tone_map_functions[i];
+        printf("Testing CPU color pipeline with tone mapping function: %s\n",
+               fun->name);
+
+        struct pl_color_map_params map = pl_color_map_default_params;
+        map.tone_mapping_function = fun;
+        map.gamut_mapping = &pl_gamut_map_perceptual;
+        pipe = pl_color_pipeline_create(log, pl_color_pipeline_params(
+            .src_csp = pl_color_space_hdr10,
+            .dst_csp = pl_color_space_bt709,
+            .color_map_params = &map,
+        ));
+        REQUIRE(pipe);
+
+        static uint16_t out[NUM_PIXELS][4], ref[256][4];
+        memcpy(out, hdr, sizeof(hdr));
+        pl_color_pipeline_apply(pipe, &packed, &(struct pl_color_buf) {
+            .type = PL_COLOR_BUF_UINT16,
+            .data = { &out[0][0], &out[0][1], &out[0][2] },
+            .pixel_stride = sizeof(out[0]),
+        }, NUM_PIXELS);
+
+        // Results must not depend on how the work was split up
+        const int offset = NUM_PIXELS - PL_ARRAY_SIZE(ref) - 13;
+        memcpy(ref, &hdr[offset], sizeof(ref));
+        pl_color_pipeline_apply(pipe, &(struct pl_color_buf) {
+            .type = PL_COLOR_BUF_UINT16,
+            .data = { &ref[0][0], &ref[0][1], &ref[0][2] },
+            .pixel_stride = sizeof(ref[0]),
+        }, &(struct pl_color_buf) {
+            .type = PL_COLOR_BUF_UINT16,
+            .data = { &ref[0][0], &ref[0][1], &ref[0][2] },
+            .pixel_stride = sizeof(ref[0]),
+        }, PL_ARRAY_SIZE(ref));
+
+        for (int n = 0; n < PL_ARRAY_SIZE(ref); n++) {
+            for (int c = 0; c < 3; c++)
+                REQUIRE_CMP(abs(out[offset + n][c] - ref[n][c]), <=, 1, "d");
+            REQUIRE_CMP(out[offset + n][3], ==, 0xABCD, "d");
+        }
+
+        // Black stays (nearly) black
+        REQUIRE_CMP(out[0][0], <=, 0x100, "d");
+        pl_color_pipeline_destroy(&pipe);
+    }
+
+    // Unsupported color systems should fail gracefully
+    REQUIRE(!pl_color_pipeline_create(log, pl_color_pipeline_params(
+        .src_repr = { .sys = PL_COLOR_SYSTEM_DOLBYVISION },
+        .src_csp  = pl_color_space_hdr10,
+        .dst_csp  = pl_color_space_bt709,
+    )));
+
+    pl_log_destroy(&log);
+}
@@ -19,9 +19,14 @@ int main()
 
     printf("Blue noise dither matrix:\n");
     pl_generate_blue_noise(&data[0][0], SIZE);
+    bool seen[SIZE * SIZE] = {0};
     for (int y = 0; y < SIZE; y++) {
-        for (int x = 0; x < SIZE; x++)
-            printf(" %3d,", (int)(data[y][x] * SIZE * SIZE));
+        for (int x = 0; x < SIZE; x++) {
+            int idx = (int)(data[y][x] * SIZE * SIZE);
+            printf(" %3d,", idx);
+            REQUIRE(idx >= 0 && idx < SIZE * SIZE && !seen[idx]);
+            seen[idx] = true;
+        }
         printf("\n");
     }
 
@@ -35,6 +40,33 @@ int main()
     REQUIRE(res);
     printf("Generated dither shader:\n%s\n", res->glsl);
 
+    // Test the banded error diffusion (as used by `pl_shader_error_diffusion`)
+    // against the reference implementation
+    enum { ED_W = 256, ED_H = 256, ED_BAND = 32 };
+    static float ed_in[ED_H * ED_W], ed_ref[ED_H * ED_W], ed_band[ED_H * ED_W];
+    for (int y = 0; y < ED_H; y++) {
+        for (int x = 0; x < ED_W; x++)
+            ed_in[y * ED_W + x] = 0.4f + 0.02f * x / ED_W + 0.01f * sinf(0.05f * y);
+    }
+
+    for (int i = 0; i < pl_num_error_diffusion_kernels; i++) {
+        const struct pl_error_diffusion_kernel *k = pl_error_diffusion_kernels[i];
+        pl_test_error_diffusion(k, ed_in, ed_ref, ED_W, ED_H, 4, 0);
+        pl_test_error_diffusion(k, ed_in, ed_band, ED_W, ED_H, 4, ED_BAND);
+        double ref = pl_test_lowpass_diff(ed_ref, ed_in, ED_W, ED_H, 3);
+        double band = pl_test_lowpass_diff(ed_band, ed_in, ED_W, ED_H, 3);
+        printf("Error diffusion kernel '%s': %f (reference), %f (banded)\n",
+               k->name, ref, band);
+
+        // The local average must be preserved much better than by plain
+        // rounding to 4 bits (which would be off by up to 1/30)
+        REQUIRE_CMP(ref, <, 0.005, "f");
+        REQUIRE_CMP(band, <, 1.1 * ref, "f");
+
+        // Bands must not change the result before the first band boundary
+        REQUIRE_MEMEQ(ed_ref, ed_band, ED_BAND * ED_W * sizeof(float));
+    }
+
     pl_shader_obj_destroy(&obj);
     pl_shader_free(&sh);
     pl_log_destroy(&log);
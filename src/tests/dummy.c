@@ -1,7 +1,21 @@
 #include "gpu_tests.h"
+#include "gpu.h"
 
 #include <libplacebo/dummy.h>
 #include <libplacebo/renderer.h>
+#include <libplacebo/utils/frame_queue.h>
+#include <libplacebo/utils/upload.h>
+
+static bool frame_upload(pl_gpu gpu, pl_tex *tex,
+                         const struct pl_source_frame *src, struct pl_frame *out)
+{
+    *out = (struct pl_frame) {
+        .num_planes = 1,
+        .repr = pl_color_repr_rgb,
+        .color = pl_color_space_srgb,
+    };
+    return pl_upload_plane(gpu, &out->planes[0], &tex[0], src->frame_data);
+}
 
 int main()
 {
@@ -63,6 +77,225 @@ int main()
     REQUIRE((res = pl_shader_finalize(sh)));
     REQUIRE_CMP(res->input, ==, PL_SHADER_SIG_SAMPLER, "u");
 
+    // Test recycling of staging buffers
+    pl_tex tex = pl_tex_create(gpu, pl_tex_params(
+        .w = 256,
+        .h = 256,
+        .format = pl_find_named_fmt(gpu, "rgba8"),
+        .host_writable = true,
+        .host_readable = true,
+    ));
+    REQUIRE(tex);
+
+    const size_t tex_size = 256 * 256 * 4;
+    uint8_t *tex_src = malloc(tex_size), *tex_dst = malloc(tex_size);
+    REQUIRE(tex_src && tex_dst);
+    for (int i = 0; i < 4; i++) {
+        memset(tex_src, i + 1, tex_size);
+        struct pl_tex_transfer_params xfer = {
+            .tex = tex,
+            .rc = { .x1 = 256, .y1 = 256, .z1 = 1 },
+            .row_pitch = 256 * 4,
+            .depth_pitch = tex_size,
+            .ptr = tex_src,
+        };
+        REQUIRE(pl_tex_upload_pbo(gpu, &xfer));
+        xfer.ptr = tex_dst;
+        REQUIRE(pl_tex_download_pbo(gpu, &xfer));
+        REQUIRE_MEMEQ(tex_src, tex_dst, tex_size);
+    }
+
+    struct pl_staging_stats stats = pl_staging_stats(gpu);
+    REQUIRE_CMP(stats.num_bufs, ==, 2, "d"); // one for each direction
+    REQUIRE_CMP(stats.size, >=, 2 * tex_size, "zu");
+    REQUIRE_CMP(stats.misses, ==, 2, PRIu64);
+    REQUIRE_CMP(stats.hits, ==, 6, PRIu64);
+    pl_tex_destroy(gpu, &tex);
+
+    // Test sliced transfers, by forcing a small buffer size limit
+    struct pl_gpu_dummy_params small_params = pl_gpu_dummy_default_params;
+    struct pl_gpu_limits *limits = &small_params.limits;
+    limits->max_buf_size = limits->max_ubo_size = limits->max_ssbo_size =
+    limits->max_vbo_size = limits->max_mapped_size = 64 << 10;
+    pl_gpu small = pl_gpu_dummy_create(log, &small_params);
+    REQUIRE(small);
+
+    tex = pl_tex_create(small, pl_tex_params(
+        .w = 256,
+        .h = 256,
+        .format = pl_find_named_fmt(small, "rgba8"),
+        .host_writable = true,
+        .host_readable = true,
+    ));
+    REQUIRE(tex);
+
+    for (int i = 0; i < tex_size; i++)
+        tex_src[i] = i * 7;
+    REQUIRE(pl_tex_upload(small, pl_tex_transfer_params(
+        .tex = tex,
+        .ptr = tex_src,
+    )));
+
+    memset(tex_dst, 0, tex_size);
+    REQUIRE(pl_tex_download(small, pl_tex_transfer_params(
+        .tex = tex,
+        .ptr = tex_dst,
+    )));
+    REQUIRE_MEMEQ(tex_src, tex_dst, tex_size);
+
+    // Sub-rect transfer, to test the slice offsets
+    const pl_rect3d rc = { .x0 = 16, .y0 = 100, .x1 = 240, .y1 = 256, .z1 = 1 };
+    memset(tex_dst, 0, tex_size);
+    REQUIRE(pl_tex_download(small, pl_tex_transfer_params(
+        .tex = tex,
+        .rc = rc,
+        .row_pitch = 256 * 4,
+        .ptr = tex_dst,
+    )));
+    for (int y = 0; y < pl_rect_h(rc); y++) {
+        const size_t offset = (rc.y0 + y) * 256 * 4 + rc.x0 * 4;
+        REQUIRE_MEMEQ(tex_src + offset, tex_dst + y * 256 * 4, pl_rect_w(rc) * 4);
+    }
+
+    stats = pl_staging_stats(small);
+    REQUIRE_CMP(stats.num_bufs, >, 1, "d");
+    REQUIRE_CMP(stats.size, <=, 16 * limits->max_buf_size, "zu");
+
+    free(tex_src);
+    free(tex_dst);
+    pl_tex_destroy(small, &tex);
+
+    // Buffers released after the pool is gone (e.g. by completion callbacks
+    // run during GPU destruction) must be destroyed directly
+    pl_buf staging = pl_staging_get(small, 1024, true);
+    REQUIRE(staging);
+    pl_staging_pool_destroy(small);
+    pl_staging_release(small, &staging);
+    REQUIRE(!staging);
+    staging = pl_staging_get(small, 1024, false);
+    REQUIRE(staging);
+    pl_staging_release(small, &staging);
+    REQUIRE_CMP(pl_staging_stats(small).num_bufs, ==, 0, "d");
+    pl_gpu_dummy_destroy(&small);
+
+    // Test memory budget accounting
+    pl_gpu budget = pl_gpu_dummy_create(log, NULL);
+    REQUIRE(budget);
+    pl_gpu_set_mem_budget(budget, 1 << 20);
+
+    pl_tex texs[4];
+    for (int i = 0; i < PL_ARRAY_SIZE(texs); i++) {
+        texs[i] = pl_tex_create(budget, pl_tex_params(
+            .w = 256,
+            .h = 256,
+            .format = pl_find_named_fmt(budget, "rgba8"),
+            .sampleable = true,
+            .debug_tag = PL_DEBUG_TAG,
+        ));
+        REQUIRE(texs[i]);
+    }
+
+    pl_buf buf = pl_buf_create(budget, pl_buf_params( .size = 1024 ));
+    REQUIRE(buf);
+
+    struct pl_gpu_mem_report *report = pl_gpu_mem_report(budget);
+    REQUIRE_CMP(report->total, ==, 4 * tex_size + 1024, "zu");
+    REQUIRE_CMP(report->tex_size, ==, 4 * tex_size, "zu");
+    REQUIRE_CMP(report->buf_size, ==, 1024, "zu");
+    REQUIRE_CMP(report->num_entries, >=, 1, "d");
+    REQUIRE_CMP(report->entries[0].size, ==, 4 * tex_size, "zu");
+    REQUIRE_CMP(report->entries[0].num_tex, ==, 4, "d");
+    pl_gpu_mem_report_free(&report);
+    REQUIRE_CMP(pl_mem_budget_excess(budget), ==, 4 * tex_size + 1024 - (1 << 20), "zu");
+
+    for (int i = 0; i < PL_ARRAY_SIZE(texs); i++)
+        pl_tex_destroy(budget, &texs[i]);
+    pl_buf_destroy(budget, &buf);
+
+    report = pl_gpu_mem_report(budget);
+    REQUIRE_CMP(report->total, ==, 0, "zu");
+    REQUIRE_CMP(report->peak, ==, 4 * tex_size + 1024, "zu");
+    REQUIRE_CMP(report->num_entries, ==, 0, "d");
+    pl_gpu_mem_report_free(&report);
+    REQUIRE_CMP(pl_mem_budget_excess(budget), ==, 0, "zu");
+
+    // Test eviction of cached frame queue textures. Spread the cached
+    // textures over several queues, none of which can cover the excess alone
+    static uint8_t pixels[64][64][4];
+    struct pl_plane_data plane = {
+        .type           = PL_FMT_UNORM,
+        .width          = 64,
+        .height         = 64,
+        .component_size = {8, 8, 8, 8},
+        .component_map  = {0, 1, 2, 3},
+        .pixel_stride   = sizeof(pixels[0][0]),
+        .pixels         = pixels,
+    };
+
+    enum { NUM_QUEUES = 3, NUM_FRAMES = 8 };
+    pl_queue queues[NUM_QUEUES];
+    for (int q = 0; q < NUM_QUEUES; q++) {
+        queues[q] = pl_queue_create(budget);
+        REQUIRE(queues[q]);
+        for (int i = 0; i < NUM_FRAMES; i++) {
+            pl_queue_push(queues[q], &(struct pl_source_frame) {
+                .pts        = i,
+                .duration   = 1,
+                .map        = frame_upload,
+                .frame_data = &plane,
+            });
+        }
+        pl_queue_push(queues[q], NULL);
+
+        struct pl_frame_mix mix;
+        for (int i = 0; i < NUM_FRAMES; i++) {
+            REQUIRE_CMP(pl_queue_update(queues[q], &mix, pl_queue_params(
+                .pts            = i,
+                .vsync_duration = 1,
+            )), ==, PL_QUEUE_OK, "u");
+        }
+
+        // Past the end, all textures are released to the cache
+        REQUIRE_CMP(pl_queue_update(queues[q], &mix, pl_queue_params(
+            .pts            = NUM_FRAMES + 1,
+            .vsync_duration = 1,
+        )), ==, PL_QUEUE_EOF, "u");
+    }
+
+    const size_t queue_size = NUM_FRAMES * sizeof(pixels);
+    report = pl_gpu_mem_report(budget);
+    REQUIRE_CMP(report->total, ==, NUM_QUEUES * queue_size, "zu");
+    REQUIRE_CMP(report->evictions, ==, 0, PRIu64);
+    pl_gpu_mem_report_free(&report);
+
+    // Exceed the budget by one texture more than a single queue holds
+    pl_gpu_set_mem_budget(budget, (NUM_QUEUES - 1) * queue_size - sizeof(pixels));
+    for (int q = 0; q < NUM_QUEUES; q++) {
+        struct pl_frame_mix mix;
+        REQUIRE_CMP(pl_queue_update(queues[q], &mix, pl_queue_params(
+            .pts            = NUM_FRAMES + 1,
+            .vsync_duration = 1,
+        )), ==, PL_QUEUE_EOF, "u");
+    }
+
+    report = pl_gpu_mem_report(budget);
+    REQUIRE_CMP(report->evictions, ==, NUM_FRAMES + 1, PRIu64);
+    REQUIRE_CMP(report->total, ==, (NUM_QUEUES - 1) * queue_size - sizeof(pixels), "zu");
+    pl_gpu_mem_report_free(&report);
+    REQUIRE_CMP(pl_mem_budget_excess(budget), ==, 0, "zu");
+
+    for (int q = 0; q < NUM_QUEUES; q++)
+        pl_queue_destroy(&queues[q]);
+    pl_gpu_dummy_destroy(&budget);
+
+    // Querying the timeline must be safe while it is disabled
+    pl_renderer rr = pl_renderer_create(log, gpu);
+    REQUIRE(rr);
+    struct pl_timeline_event events[4];
+    REQUIRE_CMP(pl_renderer_get_timeline(rr, events, PL_ARRAY_SIZE(events)), ==, 0, "d");
+    REQUIRE_CMP(pl_renderer_get_timeline(rr, events, -1), ==, 0, "d");
+    pl_renderer_destroy(&rr);
+
     pl_shader_free(&sh);
     pl_shader_obj_destroy(&lut);
     pl_tex_destroy(gpu, &dummy);
@@ -80,6 +80,30 @@ void pl_buffer_tests(pl_gpu gpu)
         REQUIRE(!pl_buf_poll(gpu, buf, 0));
         REQUIRE_MEMEQ(test_src, buf->data, buf_size);
         pl_buf_destroy(gpu, &buf);
+
+        printf("- test host mapped buffer copy and readback\n");
+        memset(test_dst, 0, buf_size);
+        buf = pl_buf_create(gpu, pl_buf_params(
+            .size = buf_size,
+            .host_writable = true,
+            .host_mapped = true,
+            .initial_data = test_src,
+        ));
+
+        tbuf = pl_buf_create(gpu, pl_buf_params(
+            .size = buf_size,
+            .host_readable = true,
+            .host_mapped = true,
+        ));
+
+        REQUIRE(buf && tbuf);
+        pl_buf_copy(gpu, tbuf, 0, buf, 0, buf_size);
+        // Overwriting the source must not affect the pending copy
+        pl_buf_write(gpu, buf, 0, test_dst, buf_size);
+        REQUIRE(pl_buf_read(gpu, tbuf, 0, test_dst, buf_size));
+        REQUIRE_MEMEQ(test_src, test_dst, buf_size);
+        pl_buf_destroy(gpu, &buf);
+        pl_buf_destroy(gpu, &tbuf);
     }
 
     // `compute_queues` check is to exclude dummy GPUs here
@@ -489,6 +513,69 @@ static void pl_shader_tests(pl_gpu gpu)
     pl_pass_destroy(gpu, &pass);
     TEST_FBO_PATTERN(1e-6, "%s", "using indexed rendering");
 
+    // Test batched pass creation, with a distinct shader for each pass
+    enum { NUM_BATCH = 4 };
+    char batch_shaders[NUM_BATCH][512];
+    struct pl_pass_params batch_params[NUM_BATCH];
+    pl_pass batch[NUM_BATCH];
+    struct pl_vertex_attrib batch_attribs[] = {{
+        .name     = "vertex_pos",
+        .fmt      = pl_find_vertex_fmt(gpu, PL_FMT_FLOAT, 2),
+        .location = 0,
+        .offset   = offsetof(struct vertex, pos),
+    }, {
+        .name     = "vertex_color",
+        .fmt      = pl_find_vertex_fmt(gpu, PL_FMT_FLOAT, 3),
+        .location = 1,
+        .offset   = offsetof(struct vertex, color),
+    }};
+    for (int i = 0; i < NUM_BATCH; i++) {
+        snprintf(batch_shaders[i], sizeof(batch_shaders[i]),
+            "#version 410                                       \n"
+            "layout(location=0) in vec3 frag_color;             \n"
+            "layout(location=0) out vec4 out_color;             \n"
+            "void main() {                                      \n"
+            "    out_color = vec4(frag_color * %d.0 / %d.0, 1.0);\n"
+            "}", i + 1, NUM_BATCH);
+
+        batch_params[i] = (struct pl_pass_params) {
+            .type           = PL_PASS_RASTER,
+            .target_format  = fbo_fmt,
+            .vertex_shader  = vert_shader,
+            .glsl_shader    = batch_shaders[i],
+            .vertex_type    = PL_PRIM_TRIANGLE_STRIP,
+            .vertex_stride  = sizeof(struct vertex),
+            .num_vertex_attribs = PL_ARRAY_SIZE(batch_attribs),
+            .vertex_attribs = batch_attribs,
+        };
+    }
+
+    REQUIRE_CMP(pl_pass_create_batch(gpu, batch_params, NUM_BATCH, batch), ==, NUM_BATCH, "d");
+    for (int i = 0; i < NUM_BATCH; i++) {
+        REQUIRE(batch[i]);
+        pl_pass_run(gpu, &(struct pl_pass_run_params) {
+            .pass           = batch[i],
+            .target         = fbo,
+            .vertex_count   = PL_ARRAY_SIZE(vertices),
+            .vertex_data    = vertices,
+        });
+        pl_pass_destroy(gpu, &batch[i]);
+
+        REQUIRE(pl_tex_download(gpu, &(struct pl_tex_transfer_params) {
+            .tex = fbo,
+            .ptr = test_data,
+        }));
+        const float scale = (float) (i + 1) / NUM_BATCH;
+        for (int y = 0; y < FBO_H; y++) {
+            for (int x = 0; x < FBO_W; x++) {
+                float *color = &test_data[(y * FBO_W + x) * 4];
+                REQUIRE_FEQ(color[0], scale * (x + 0.5) / FBO_W, 1e-6);
+                REQUIRE_FEQ(color[1], scale * (y + 0.5) / FBO_H, 1e-6);
+                REQUIRE_FEQ(color[3], 1.0, 1e-6);
+            }
+        }
+    }
+
     // Test the use of pl_dispatch
     pl_dispatch dp = pl_dispatch_create(gpu->log, gpu);
     pl_shader sh = pl_dispatch_begin(dp);
@@ -688,6 +775,73 @@ static void pl_shader_tests(pl_gpu gpu)
         real_avg = real_avg / (FBO_W * FBO_H);
         REQUIRE_FEQ(hdr.max_pq_y, real_peak, 1e-4);
         REQUIRE_FEQ(hdr.avg_pq_y, real_avg,  1e-3);
+
+        // Test delayed readback of multiple frames in flight
+        struct pl_hdr_frame_stats frames[4];
+        struct pl_hdr_stats_ring ring = { .frames = frames, .size = 4 };
+        peak_params.max_delay = 3;
+        peak_params.stats = &ring;
+        for (int i = 0; i < 5; i++) {
+            sh = pl_dispatch_begin(dp);
+            pl_shader_sample_nearest(sh, pl_sample_src( .tex = src ));
+            REQUIRE(pl_shader_detect_peak(sh, csp_gamma22, &peak_state, &peak_params));
+            REQUIRE(pl_dispatch_compute(dp, &(struct pl_dispatch_compute_params) {
+                .shader = &sh,
+                .width = fbo->params.w,
+                .height = fbo->params.h,
+            }));
+        }
+
+        pl_gpu_finish(gpu);
+        REQUIRE(pl_get_detected_hdr_metadata(peak_state, &hdr));
+        REQUIRE_FEQ(hdr.max_pq_y, real_peak, 1e-4);
+        REQUIRE_FEQ(hdr.avg_pq_y, real_avg,  1e-3);
+
+        // Test exported per-frame statistics
+        REQUIRE_CMP(ring.num_frames, ==, 5, PRIu64);
+        const struct pl_hdr_frame_stats *last = &frames[(ring.num_frames - 1) % 4];
+        REQUIRE_CMP(last->frame, ==, 5, PRIu64);
+        REQUIRE(!last->scene_change);
+        REQUIRE_FEQ(last->max_pq, real_peak, 1e-4);
+        REQUIRE_FEQ(last->avg_pq, real_avg,  1e-3);
+        uint64_t hist_total = 0;
+        for (int i = 0; i < PL_HDR_HIST_BINS; i++)
+            hist_total += last->histogram[i];
+        REQUIRE_CMP(hist_total, >, 0, PRIu64);
+        for (int i = 1; i < PL_HDR_NUM_PERCENTILES; i++)
+            REQUIRE_CMP(last->percentiles[i], >=, last->percentiles[i - 1], "f");
+        REQUIRE_CMP(last->percentiles[PL_HDR_NUM_PERCENTILES - 1], <=, last->max_pq, "f");
+
+        // Test replacing and clearing the ring with results still in flight
+        struct pl_hdr_frame_stats frames2[4];
+        struct pl_hdr_stats_ring ring2 = { .frames = frames2, .size = 4 };
+        struct pl_hdr_stats_ring *rings[] = { &ring, &ring, &ring, &ring2, NULL, NULL };
+        uint64_t num_frames[2] = {0};
+        for (int i = 0; i < PL_ARRAY_SIZE(rings); i++) {
+            num_frames[0] = ring.num_frames;
+            num_frames[1] = ring2.num_frames;
+            peak_params.stats = rings[i];
+            sh = pl_dispatch_begin(dp);
+            pl_shader_sample_nearest(sh, pl_sample_src( .tex = src ));
+            REQUIRE(pl_shader_detect_peak(sh, csp_gamma22, &peak_state, &peak_params));
+            REQUIRE(pl_dispatch_compute(dp, &(struct pl_dispatch_compute_params) {
+                .shader = &sh,
+                .width = fbo->params.w,
+                .height = fbo->params.h,
+            }));
+            // Previous rings must not be written to after being replaced
+            if (i >= 3)
+                REQUIRE_CMP(ring.num_frames, ==, num_frames[0], PRIu64);
+            if (i >= 4)
+                REQUIRE_CMP(ring2.num_frames, ==, num_frames[1], PRIu64);
+        }
+
+        pl_gpu_finish(gpu);
+        REQUIRE(pl_get_detected_hdr_metadata(peak_state, &hdr));
+        REQUIRE_CMP(ring.num_frames, ==, num_frames[0], PRIu64);
+        REQUIRE_CMP(ring2.num_frames, ==, num_frames[1], PRIu64);
+        // Frames still in flight when the ring was cleared are dropped
+        REQUIRE_CMP(ring.num_frames + ring2.num_frames, <=, 5 + 4, PRIu64);
     }
 
     pl_dispatch_abort(dp, &sh);
@@ -734,6 +888,40 @@ static void pl_shader_tests(pl_gpu gpu)
     }
     pl_shader_obj_destroy(&grain);
 
+    // Cycle through more grain parameters than there are cached grain
+    // templates, including ones differing only in the presence of luma grain
+    // (which the chroma grain depends on via the AR luma tap). The result
+    // must match generating each template from scratch.
+    static const int grain_order[] = { 0, 1, 2, 3, 0, 1, 4, 5, 0, 2, 3, 1 };
+    static float grain_cached[FBO_H * FBO_W * 4], grain_fresh[FBO_H * FBO_W * 4];
+    grain_params.data.type = PL_FILM_GRAIN_AV1;
+    for (int i = 0; i < PL_ARRAY_SIZE(grain_order); i++) {
+        const int n = grain_order[i];
+        grain_params.data.params.av1 = av1_grain_data;
+        grain_params.data.params.av1.num_points_y = (n & 1) ? 0 : av1_grain_data.num_points_y;
+        grain_params.data.seed = 1000 + n / 2;
+
+        pl_shader_obj fresh = NULL;
+        pl_shader_obj *states[] = { &grain, &fresh };
+        float *results[] = { grain_cached, grain_fresh };
+        for (int j = 0; j < PL_ARRAY_SIZE(states); j++) {
+            sh = pl_dispatch_begin(dp);
+            REQUIRE(pl_shader_film_grain(sh, states[j], &grain_params));
+            REQUIRE(pl_dispatch_finish(dp, &(struct pl_dispatch_params) {
+                .shader = &sh,
+                .target = fbo,
+            }));
+            REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+                .tex = fbo,
+                .ptr = results[j],
+            )));
+        }
+
+        pl_shader_obj_destroy(&fresh);
+        REQUIRE(memcmp(grain_cached, grain_fresh, sizeof(grain_fresh)) == 0);
+    }
+    pl_shader_obj_destroy(&grain);
+
     // Test custom shaders
     struct pl_custom_shader custom = {
         .header =
@@ -823,7 +1011,7 @@ static void pl_scaler_tests(pl_gpu gpu)
         return;
     printf("pl_scaler_tests:\n");
 
-    float *fbo_data = NULL;
+    float *fbo_data = NULL, *tiled_data = NULL;
     pl_shader_obj lut = NULL;
 
     static float data_5x5[5][5] = {
@@ -894,14 +1082,138 @@ static void pl_scaler_tests(pl_gpu gpu)
 #endif
     }
 
+    // Non-default compute tile sizes must not affect the result
+    if (fbo_data && fbo->params.storable && gpu->glsl.compute) {
+        static const int tile_sizes[][2] = {{8, 8}, {13, 5}, {64, 1}};
+        tiled_data = malloc(fbo->params.w * fbo->params.h * sizeof(float));
+        for (int i = 0; i < PL_ARRAY_SIZE(tile_sizes); i++) {
+            sh = pl_dispatch_begin(dp);
+            REQUIRE(pl_shader_sample_polar(sh,
+                pl_sample_src(
+                    .tex        = dot5x5,
+                    .new_w      = fbo->params.w,
+                    .new_h      = fbo->params.h,
+                ),
+                pl_sample_filter_params(
+                    .filter     = pl_filter_ewa_lanczos,
+                    .lut        = &lut,
+                    .tile_size  = { tile_sizes[i][0], tile_sizes[i][1] },
+                )
+            ));
+            REQUIRE(pl_dispatch_finish(dp, &(struct pl_dispatch_params) {
+                .shader = &sh,
+                .target = fbo,
+            }));
+            REQUIRE(pl_tex_download(gpu, &(struct pl_tex_transfer_params) {
+                .tex            = fbo,
+                .ptr            = tiled_data,
+            }));
+
+            printf("- testing tile size %dx%d\n", tile_sizes[i][0], tile_sizes[i][1]);
+            for (int n = 0; n < fbo->params.w * fbo->params.h; n++)
+                REQUIRE_FEQ(tiled_data[n], fbo_data[n], 1e-5);
+        }
+    }
+
 error:
     free(fbo_data);
+    free(tiled_data);
     pl_shader_obj_destroy(&lut);
     pl_dispatch_destroy(&dp);
     pl_tex_destroy(gpu, &dot5x5);
     pl_tex_destroy(gpu, &fbo);
 }
 
+static void pl_error_diffusion_tests(pl_gpu gpu)
+{
+    pl_fmt src_fmt = pl_find_fmt(gpu, PL_FMT_FLOAT, 1, 32, 32, PL_FMT_CAP_SAMPLEABLE);
+    pl_fmt dst_fmt = pl_find_fmt(gpu, PL_FMT_FLOAT, 1, 32, 32,
+                                 PL_FMT_CAP_STORABLE | PL_FMT_CAP_HOST_READABLE);
+    if (!src_fmt || !dst_fmt || !gpu->glsl.compute)
+        return;
+    printf("pl_error_diffusion_tests:\n");
+
+    enum { W = 256, H = 256, BAND = 64, DEPTH = 4 };
+    float *in = malloc(W * H * sizeof(float));
+    float *ref = malloc(W * H * sizeof(float));
+    float *full = malloc(W * H * sizeof(float));
+    float *band = malloc(W * H * sizeof(float));
+    REQUIRE(in && ref && full && band);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++)
+            in[y * W + x] = 0.4f + 0.02f * x / W + 0.01f * sinf(0.05f * y);
+    }
+
+    pl_tex src = pl_tex_create(gpu, pl_tex_params(
+        .w              = W,
+        .h              = H,
+        .format         = src_fmt,
+        .sampleable     = true,
+        .initial_data   = in,
+    ));
+    pl_tex dst = pl_tex_create(gpu, pl_tex_params(
+        .w              = W,
+        .h              = H,
+        .format         = dst_fmt,
+        .storable       = true,
+        .host_readable  = true,
+    ));
+    pl_dispatch dp = pl_dispatch_create(gpu->log, gpu);
+    REQUIRE(src && dst && dp);
+
+    const struct pl_error_diffusion_kernel *k = &pl_error_diffusion_floyd_steinberg;
+    pl_test_error_diffusion(k, in, ref, W, H, DEPTH, 0);
+    const double ref_diff = pl_test_lowpass_diff(ref, in, W, H, 3);
+
+    bool done[2] = {0};
+    for (int b = 0; b < 2; b++) {
+        struct pl_error_diffusion_params params = {
+            .input_tex   = src,
+            .output_tex  = dst,
+            .new_depth   = DEPTH,
+            .kernel      = k,
+            .band_height = b ? BAND : 0,
+        };
+
+        pl_shader sh = pl_dispatch_begin(dp);
+        if (!pl_shader_error_diffusion(sh, &params)) {
+            fprintf(stderr, "error diffusion exceeds GPU limits, skipping...\n");
+            pl_dispatch_abort(dp, &sh);
+            continue;
+        }
+
+        REQUIRE(pl_dispatch_compute(dp, pl_dispatch_compute_params(
+            .shader = &sh,
+            .dispatch_size = { pl_error_diffusion_bands(&params), 1, 1 },
+        )));
+
+        float *out = b ? band : full;
+        REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+            .tex = dst,
+            .ptr = out,
+        )));
+
+        // The GPU quantizes the propagated error, so compare the quality
+        // against the reference rather than the exact values
+        const double diff = pl_test_lowpass_diff(out, in, W, H, 3);
+        printf("- %s: %f (reference %f)\n", b ? "banded" : "full", diff, ref_diff);
+        REQUIRE_CMP(diff, <, 1.5 * ref_diff, "f");
+        done[b] = true;
+    }
+
+    // The first band is unaffected by the split
+    if (done[0] && done[1])
+        REQUIRE_MEMEQ(full, band, BAND * W * sizeof(float));
+
+    pl_dispatch_destroy(&dp);
+    pl_tex_destroy(gpu, &src);
+    pl_tex_destroy(gpu, &dst);
+    free(in);
+    free(ref);
+    free(full);
+    free(band);
+}
+
 static const char *user_shader_tests[] = {
     // Test hooking, saving and loading
     "// Example of a comment at the beginning                               \n"
@@ -1121,6 +1433,48 @@ static void pl_render_tests(pl_gpu gpu)
 
     // TODO: embed a reference texture and ensure it matches
 
+    // Test the timeline, including wrap-around of the event buffer
+    pl_renderer_set_timeline(rr, 64);
+    for (int i = 0; i < 10; i++)
+        REQUIRE(pl_render_image(rr, &image, &target, NULL));
+    pl_gpu_finish(gpu);
+    REQUIRE(pl_render_image(rr, &image, &target, NULL));
+
+    int num_events = pl_renderer_get_timeline(rr, NULL, 0);
+    REQUIRE_CMP(num_events, >, 0, "d");
+    REQUIRE_CMP(num_events, <=, 64, "d");
+    struct pl_timeline_event *events = calloc(num_events, sizeof(*events));
+    REQUIRE(events);
+    REQUIRE_CMP(pl_renderer_get_timeline(rr, events, num_events), ==, num_events, "d");
+    int num_passes = 0;
+    for (int i = 0; i < num_events; i++) {
+        REQUIRE(events[i].name);
+        REQUIRE_CMP(events[i].cpu_end, >=, events[i].cpu_start, PRIu64);
+        num_passes += events[i].op == PL_TIMELINE_PASS;
+        if (i > 0) {
+            REQUIRE_CMP(events[i].frame, >=, events[i - 1].frame, PRIu64);
+            REQUIRE_CMP(events[i].cpu_start, >=, events[i - 1].cpu_start, PRIu64);
+        }
+    }
+    REQUIRE_CMP(num_passes, >, 0, "d");
+    free(events);
+
+    size_t json_size = pl_renderer_save_timeline(rr, NULL, 0);
+    REQUIRE_CMP(json_size, >, 0, "zu");
+    char *json = malloc(json_size + 1);
+    REQUIRE(json);
+    REQUIRE_CMP(pl_renderer_save_timeline(rr, (uint8_t *) json, json_size), ==, json_size, "zu");
+    json[json_size] = '\0';
+    REQUIRE(strstr(json, "\"traceEvents\""));
+    REQUIRE(strstr(json, "\"cat\":\"pass\""));
+    free(json);
+
+    pl_renderer_set_timeline(rr, 0);
+    REQUIRE_CMP(pl_renderer_get_timeline(rr, NULL, 0), ==, 0, "d");
+    struct pl_timeline_event dummy_events[4];
+    REQUIRE_CMP(pl_renderer_get_timeline(rr, dummy_events, 4), ==, 0, "d");
+    REQUIRE_CMP(pl_renderer_get_timeline(rr, dummy_events, -1), ==, 0, "d");
+
     // Test a bunch of different params
 #define TEST(SNAME, STYPE, DEFAULT, FIELD, LIMIT)                       \
     do {                                                                \
@@ -1162,8 +1516,71 @@ static void pl_render_tests(pl_gpu gpu)
         pl_gpu_flush(gpu);
         REQUIRE(pl_renderer_get_errors(rr).errors == PL_RENDER_ERR_NONE);
     }
+
+    // Test pyramidal downscaling, in both and in only one direction
+    target.crop.x1 = width / 10.0;
+    target.crop.y1 = height / 10.0;
+    for (int i = 0; i < 2; i++) {
+        struct pl_render_params params = pl_render_default_params;
+        params.downscaler = &pl_filter_ewa_lanczos;
+        params.pyramid_downscaling = true;
+        REQUIRE(pl_render_image(rr, &image, &target, &params));
+        pl_gpu_flush(gpu);
+        REQUIRE(pl_renderer_get_errors(rr).errors == PL_RENDER_ERR_NONE);
+        params.downscaler = &pl_filter_mitchell;
+        REQUIRE(pl_render_image(rr, &image, &target, &params));
+        pl_gpu_flush(gpu);
+        REQUIRE(pl_renderer_get_errors(rr).errors == PL_RENDER_ERR_NONE);
+        target.crop.y1 = height;
+    }
     target.crop.x1 = target.crop.y1 = 0;
 
+    // Compare pyramidal downscaling of smooth content against the direct
+    // kernel, which should agree to within the documented error bound
+    enum { pyr_size = 200, pyr_out = 10 };
+    static float pyr_data[pyr_size][pyr_size];
+    for (int y = 0; y < pyr_size; y++) {
+        for (int x = 0; x < pyr_size; x++) {
+            pyr_data[y][x] = 0.5f + 0.2f * sinf(2 * M_PI * x / pyr_size + 0.3f)
+                                  + 0.2f * cosf(2 * M_PI * y / pyr_size);
+        }
+    }
+
+    pl_tex pyr_tex = NULL;
+    struct pl_frame pyr_image = image;
+    pyr_image.crop = (pl_rect2df) {0};
+    plane_data.width = plane_data.height = pyr_size;
+    plane_data.pixels = pyr_data;
+    REQUIRE(pl_upload_plane(gpu, &pyr_image.planes[0], &pyr_tex, &plane_data));
+
+    static float pyr_res[2][height][width];
+    target.crop = (pl_rect2df) { 0, 0, pyr_out, pyr_out };
+    uint64_t fbo_passes[2];
+    for (int i = 0; i < 2; i++) {
+        struct pl_render_params params = pl_render_default_params;
+        params.downscaler = &pl_filter_mitchell;
+        params.disable_linear_scaling = true;
+        params.pyramid_downscaling = i;
+        fbo_passes[i] = pl_renderer_get_stats(rr).fbo_passes;
+        REQUIRE(pl_render_image(rr, &pyr_image, &target, &params));
+        REQUIRE(pl_renderer_get_errors(rr).errors == PL_RENDER_ERR_NONE);
+        fbo_passes[i] = pl_renderer_get_stats(rr).fbo_passes - fbo_passes[i];
+        REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+            .tex = fbo,
+            .ptr = pyr_res[i],
+        )));
+    }
+
+    // 200 -> 100 -> 50 -> 25, after which the ratio is at most 4x
+    REQUIRE_CMP(fbo_passes[1], ==, fbo_passes[0] + 3, PRIu64);
+    for (int y = 0; y < pyr_out; y++) {
+        for (int x = 0; x < pyr_out; x++)
+            REQUIRE_FEQ(pyr_res[1][y][x], pyr_res[0][y][x], 0.01);
+    }
+
+    target.crop = (pl_rect2df) {0};
+    pl_tex_destroy(gpu, &pyr_tex);
+
     TEST_PARAMS(deband, iterations, 3);
     TEST_PARAMS(sigmoid, center, 1);
     TEST_PARAMS(color_map, intent, PL_INTENT_ABSOLUTE_COLORIMETRIC);
@@ -1182,8 +1599,10 @@ static void pl_render_tests(pl_gpu gpu)
     // Test HDR tone mapping
     image.color = pl_color_space_hdr10;
     TEST_PARAMS(color_map, visualize_lut, true);
-    if (gpu->limits.max_ssbo_size)
+    if (gpu->limits.max_ssbo_size) {
         TEST_PARAMS(peak_detect, allow_delayed, true);
+        TEST_PARAMS(peak_detect, max_delay, 3);
+    }
 
     // Test inverse tone-mapping and pure BPC
     image.color.hdr.max_luma = 1000;
@@ -1225,6 +1644,37 @@ static void pl_render_tests(pl_gpu gpu)
     REQUIRE(pl_render_image(rr, &image, &target, &params));
     REQUIRE(pl_renderer_get_errors(rr).errors == PL_RENDER_ERR_NONE);
 
+    // Debanding should be fused into the film grain pass, without affecting
+    // the result. (Use debanding without any randomness, since its PRNG
+    // state changes from frame to frame)
+    static float fused[height][width], unfused[height][width];
+    REQUIRE_CMP(fbo->params.format->texel_size, ==, sizeof(float), "zu");
+    struct pl_render_stats rstats = pl_renderer_get_stats(rr);
+    params.deband_params = &(struct pl_deband_params) { .iterations = 0 };
+    REQUIRE(pl_render_image(rr, &image, &target, &params));
+    REQUIRE(pl_renderer_get_errors(rr).errors == PL_RENDER_ERR_NONE);
+    REQUIRE_CMP(pl_renderer_get_stats(rr).fused_passes, >, rstats.fused_passes, PRIu64);
+    REQUIRE_CMP(pl_renderer_get_stats(rr).frames, ==, rstats.frames + 1, PRIu64);
+    REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+        .tex = fbo,
+        .ptr = fused,
+    )));
+
+    rstats = pl_renderer_get_stats(rr);
+    params.disable_pass_fusion = true;
+    REQUIRE(pl_render_image(rr, &image, &target, &params));
+    REQUIRE(pl_renderer_get_errors(rr).errors == PL_RENDER_ERR_NONE);
+    REQUIRE_CMP(pl_renderer_get_stats(rr).fused_passes, ==, rstats.fused_passes, PRIu64);
+    REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+        .tex = fbo,
+        .ptr = unfused,
+    )));
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++)
+            REQUIRE_FEQ(fused[y][x], unfused[y][x], 1e-4);
+    }
+    params = pl_render_default_params;
+
     image.film_grain.type = PL_FILM_GRAIN_H274;
     image.film_grain.params.h274 = h274_grain_data;
     REQUIRE(pl_render_image(rr, &image, &target, &params));
@@ -1397,6 +1847,26 @@ static void pl_render_tests(pl_gpu gpu)
     pl_frames_infer_mix(rr, &mix, &inferred_target, &inferred_image);
     REQUIRE(pl_render_image_mix(rr, &mix, &target, &mix_params));
 
+    // Test bounded frame cache, frames should survive dropping out of the mix
+    struct pl_render_cache_stats stats = pl_renderer_get_cache_stats(rr);
+    mix_params.mixing_cache_size = SIZE_MAX;
+    mix.signatures = (uint64_t[]) { 0xFFF3, 0xFFF4 };
+    mix.timestamps = (float[]) { -0.4, 0.6 };
+    mix.vsync_duration = 1.0;
+    REQUIRE(pl_render_image_mix(rr, &mix, &target, &mix_params));
+    REQUIRE_CMP(pl_renderer_get_cache_stats(rr).misses, ==, stats.misses + 2, PRIu64);
+    mix.signatures = (uint64_t[]) { 0xFFF4, 0xFFF5 };
+    REQUIRE(pl_render_image_mix(rr, &mix, &target, &mix_params));
+    mix.signatures = (uint64_t[]) { 0xFFF3, 0xFFF4 };
+    REQUIRE(pl_render_image_mix(rr, &mix, &target, &mix_params));
+    stats = pl_renderer_get_cache_stats(rr);
+    REQUIRE_CMP(stats.hits, >=, 3, PRIu64);
+    REQUIRE_CMP(stats.num_frames, >=, 3, "d");
+    mix_params.mixing_cache_size = 1;
+    REQUIRE(pl_render_image_mix(rr, &mix, &target, &mix_params));
+    REQUIRE_CMP(pl_renderer_get_cache_stats(rr).num_frames, ==, 2, "d");
+    mix_params.mixing_cache_size = 0;
+
     // Test empty frame mix
     mix = (struct pl_frame_mix) {0};
     REQUIRE(pl_render_image_mix(rr, &mix, &target, &mix_params));
@@ -1746,6 +2216,7 @@ void gpu_shader_tests(pl_gpu gpu)
     pl_texture_tests(gpu);
     pl_planar_tests(gpu);
     pl_shader_tests(gpu);
+    pl_error_diffusion_tests(gpu);
     pl_scaler_tests(gpu);
     pl_render_tests(gpu);
     pl_ycbcr_tests(gpu);
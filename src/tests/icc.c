@@ -1,5 +1,6 @@
 #include "utils.h"
 
+#include <libplacebo/dummy.h>
 #include <libplacebo/shaders/icc.h>
 
 static const uint8_t DisplayP3_v2_micro_icc[] = {
@@ -85,6 +86,22 @@ static const uint8_t Rec2020_v2_micro_icc[] = {
   0xf4, 0x16, 0xff, 0xff
 };
 
+struct lut_cmp {
+    pl_cache ref;
+    int num;
+};
+
+static void compare_lut(void *priv, pl_cache_obj obj)
+{
+    struct lut_cmp *cmp = priv;
+    pl_cache_obj ref = { .key = obj.key };
+    REQUIRE(pl_cache_get(cmp->ref, &ref));
+    REQUIRE_CMP(ref.size, ==, obj.size, "zu");
+    REQUIRE(memcmp(ref.data, obj.data, obj.size) == 0);
+    pl_cache_obj_free(&ref);
+    cmp->num++;
+}
+
 int main()
 {
     pl_log log = pl_test_logger();
@@ -102,5 +119,55 @@ int main()
     REQUIRE_CMP(icc->csp.primaries, ==, PL_COLOR_PRIM_BT_2020, "u");
     pl_icc_close(&icc);
 
+    // Test background 3DLUT generation
+    pl_gpu gpu = pl_gpu_dummy_create(log, NULL);
+    pl_shader sh = pl_shader_alloc(log, pl_shader_params( .gpu = gpu ));
+    pl_shader_obj lut = NULL;
+    icc = pl_icc_open(log, &TEST_PROFILE(sRGB_v2_nano_icc),
+                      pl_icc_params( .prebuild_luts = true ));
+    REQUIRE(icc);
+    pl_icc_decode(sh, icc, &lut, NULL);
+    REQUIRE(pl_shader_finalize(sh));
+
+    // Re-open in-place and close while generation may still be in progress
+    REQUIRE(pl_icc_update(log, &icc, NULL, pl_icc_params(
+        .prebuild_luts = true,
+        .size_r = 17, .size_g = 17, .size_b = 17,
+    )));
+    pl_icc_close(&icc);
+    pl_shader_obj_destroy(&lut);
+
+    // Background generation must produce the same LUTs as generating them
+    // synchronously on first use
+    pl_cache caches[2];
+    for (int i = 0; i < PL_ARRAY_SIZE(caches); i++) {
+        caches[i] = pl_cache_create(pl_cache_params( .log = log ));
+        icc = pl_icc_open(log, &TEST_PROFILE(DisplayP3_v2_micro_icc), pl_icc_params(
+            .size_r = 17, .size_g = 19, .size_b = 23,
+            .cache  = caches[i],
+            .prebuild_luts = i == 0,
+        ));
+        REQUIRE(icc);
+
+        pl_shader_obj luts[2] = {0};
+        pl_shader_reset(sh, pl_shader_params( .gpu = gpu ));
+        pl_icc_decode(sh, icc, &luts[0], NULL);
+        pl_icc_encode(sh, icc, &luts[1]);
+        REQUIRE(pl_shader_finalize(sh));
+        pl_shader_obj_destroy(&luts[0]);
+        pl_shader_obj_destroy(&luts[1]);
+        pl_icc_close(&icc);
+    }
+
+    struct lut_cmp cmp = { .ref = caches[1] };
+    REQUIRE_CMP(pl_cache_objects(caches[0]), ==, 2, "d");
+    pl_cache_iterate(caches[0], compare_lut, &cmp);
+    REQUIRE_CMP(cmp.num, ==, 2, "d");
+    pl_cache_destroy(&caches[0]);
+    pl_cache_destroy(&caches[1]);
+
+    pl_shader_free(&sh);
+    pl_gpu_dummy_destroy(&gpu);
+
     pl_log_destroy(&log);
 }
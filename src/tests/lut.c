@@ -79,6 +79,41 @@ int main()
         pl_lut_free(&lut);
     }
 
+    // Test a large LUT, which gets parsed by multiple threads
+    const int size = 48;
+    pl_str big = {0};
+    pl_str_append_asprintf_c(NULL, &big, "LUT_3D_SIZE %d\n", size);
+    for (int b = 0; b < size; b++) {
+        for (int g = 0; g < size; g++) {
+            for (int r = 0; r < size; r++) {
+                pl_str_append_asprintf_c(NULL, &big, "%f %f %f\n",
+                                         r / (size - 1.0), g / (size - 1.0),
+                                         b / (size - 1.0));
+            }
+        }
+    }
+
+    pl_cache cache = pl_cache_create(pl_cache_params( .log = log ));
+    for (int i = 0; i < 2; i++) {
+        struct pl_custom_lut *lut;
+        lut = pl_lut_parse_cube_cached(log, cache, (char *) big.buf, big.len);
+        REQUIRE(lut);
+        REQUIRE_CMP(lut->size[2], ==, size, "d");
+        REQUIRE_CMP(pl_cache_objects(cache), ==, 1, "d");
+        for (int n = 0; n < size * size * size; n++) {
+            const float r = (n % size) / (size - 1.0);
+            const float b = (n / (size * size)) / (size - 1.0);
+            REQUIRE_FEQ(lut->data[3 * n + 0], r, 1e-5);
+            REQUIRE_FEQ(lut->data[3 * n + 2], b, 1e-5);
+        }
+        pl_lut_free(&lut);
+    }
+
+    // Truncated LUTs must fail
+    REQUIRE(!pl_lut_parse_cube(log, (char *) big.buf, big.len / 2));
+    pl_cache_destroy(&cache);
+    pl_free(big.buf);
+
     pl_shader_obj_destroy(&obj);
     pl_shader_free(&sh);
     pl_gpu_dummy_destroy(&gpu);
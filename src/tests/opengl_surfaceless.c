@@ -1,8 +1,11 @@
 #include "gpu_tests.h"
+#include "gpu.h"
 #include "opengl/utils.h"
 
+#include <libplacebo/dispatch.h>
 #include <libplacebo/opengl.h>
 #include <libplacebo/renderer.h>
+#include <libplacebo/shaders/custom.h>
 
 static void opengl_interop_tests(pl_gpu gpu)
 {
@@ -41,6 +44,143 @@ static void opengl_interop_tests(pl_gpu gpu)
     pl_tex_destroy(gpu, &export);
 }
 
+// Renders a solid color using a fresh dispatch, and returns the red channel
+static uint8_t render_solid(pl_gpu gpu, pl_tex tex, const char *body)
+{
+    pl_dispatch dp = pl_dispatch_create(gpu->log, gpu);
+    REQUIRE(dp);
+    pl_shader sh = pl_dispatch_begin(dp);
+    REQUIRE(pl_shader_custom(sh, &(struct pl_custom_shader) {
+        .body   = body,
+        .output = PL_SHADER_SIG_COLOR,
+    }));
+    REQUIRE(pl_dispatch_finish(dp, pl_dispatch_params(
+        .shader = &sh,
+        .target = tex,
+    )));
+    pl_dispatch_destroy(&dp);
+
+    uint8_t data[16 * 16 * 4];
+    REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+        .tex = tex,
+        .ptr = data,
+    )));
+    return data[0];
+}
+
+static void opengl_cache_tests(pl_gpu gpu)
+{
+    pl_fmt fmt = pl_find_named_fmt(gpu, "rgba8");
+    if (!fmt || !(fmt->caps & PL_FMT_CAP_RENDERABLE) || !fmt->host_readable)
+        return;
+    printf("opengl_cache_tests:\n");
+
+    pl_tex tex = pl_tex_create(gpu, pl_tex_params(
+        .w = 16,
+        .h = 16,
+        .format = fmt,
+        .renderable = true,
+        .host_readable = true,
+    ));
+    REQUIRE(tex);
+
+    static const char *bodies[] = {
+        "color = vec4(0.25, 0.0, 0.0, 1.0);",
+        "color = vec4(0.5, 0.0, 0.0, 1.0);",
+        "color = vec4(0.75, 0.0, 0.0, 1.0);",
+    };
+
+    pl_cache cold = pl_cache_create(pl_cache_params( .log = gpu->log ));
+    pl_gpu_set_cache(gpu, cold);
+    uint8_t ref[PL_ARRAY_SIZE(bodies)];
+    for (int i = 0; i < PL_ARRAY_SIZE(bodies); i++)
+        ref[i] = render_solid(gpu, tex, bodies[i]);
+
+    // Re-create the same passes from a copy of the cache, which exercises
+    // the program binary preloading path
+    size_t size = pl_cache_save(cold, NULL, 0);
+    uint8_t *data = malloc(size);
+    REQUIRE(data);
+    REQUIRE_CMP(pl_cache_save(cold, data, size), ==, size, "zu");
+    pl_cache warm = pl_cache_create(pl_cache_params( .log = gpu->log ));
+    REQUIRE_CMP(pl_cache_load(warm, data, size), ==, pl_cache_objects(cold), "d");
+    free(data);
+
+    pl_gpu_set_cache(gpu, warm);
+    for (int i = PL_ARRAY_SIZE(bodies) - 1; i >= 0; i--)
+        REQUIRE_CMP(render_solid(gpu, tex, bodies[i]), ==, ref[i], "u");
+
+    pl_gpu_set_cache(gpu, NULL);
+    pl_cache_destroy(&cold);
+    pl_cache_destroy(&warm);
+    pl_tex_destroy(gpu, &tex);
+}
+
+static void count_cb(void *priv)
+{
+    int *count = priv;
+    (*count)++;
+}
+
+static void opengl_streaming_tests(pl_gpu gpu)
+{
+    pl_fmt fmt = pl_find_named_fmt(gpu, "rgba8");
+    if (!fmt || !fmt->host_readable || !gpu->limits.max_mapped_size)
+        return;
+    printf("opengl_streaming_tests:\n");
+
+    enum { W = 512, H = 512, FRAMES = 32 };
+    pl_tex tex = pl_tex_create(gpu, pl_tex_params(
+        .w = W,
+        .h = H,
+        .format = fmt,
+        .host_writable = true,
+        .host_readable = true,
+    ));
+    REQUIRE(tex);
+
+    const size_t size = W * H * 4;
+    uint8_t *src = malloc(size), *dst = malloc(FRAMES * size);
+    REQUIRE(src && dst);
+
+    // Upload synchronously and read back asynchronously, which should
+    // recycle the same few persistently mapped staging buffers
+    struct pl_staging_stats before = pl_staging_stats(gpu);
+    pl_clock_t start = pl_clock_now();
+    int done = 0;
+    for (int i = 0; i < FRAMES; i++) {
+        memset(src, i, size);
+        REQUIRE(pl_tex_upload(gpu, pl_tex_transfer_params(
+            .tex = tex,
+            .ptr = src,
+        )));
+        REQUIRE(pl_tex_download(gpu, pl_tex_transfer_params(
+            .tex = tex,
+            .ptr = dst + i * size,
+            .callback = count_cb,
+            .priv = &done,
+        )));
+    }
+
+    pl_gpu_finish(gpu);
+    const double secs = pl_clock_diff(pl_clock_now(), start);
+    printf("streamed %d frames of %dx%d in %.3f ms (%.1f MB/s)\n", FRAMES,
+           W, H, secs * 1e3, 2.0 * FRAMES * size / (secs * 1e6));
+    REQUIRE_CMP(done, ==, FRAMES, "d");
+    for (int i = 0; i < FRAMES; i++) {
+        const uint8_t *frame = dst + i * size;
+        REQUIRE_CMP(frame[0], ==, i, "u");
+        REQUIRE_CMP(frame[size - 1], ==, i, "u");
+    }
+
+    struct pl_staging_stats after = pl_staging_stats(gpu);
+    REQUIRE_CMP(after.hits - before.hits, >, 0, PRIu64);
+
+    free(src);
+    free(dst);
+    pl_tex_destroy(gpu, &tex);
+}
+
 #define PBUFFER_WIDTH 640
 #define PBUFFER_HEIGHT 480
 
@@ -223,6 +363,8 @@ int main()
         gpu_shader_tests(gpu);
         gpu_interop_tests(gpu);
         opengl_interop_tests(gpu);
+        opengl_cache_tests(gpu);
+        opengl_streaming_tests(gpu);
         opengl_swapchain_tests(gl, dpy, surf);
 
         // Reduce log spam after first successful test
@@ -21,6 +21,7 @@
 
 #include <libplacebo/log.h>
 #include <libplacebo/colorspace.h>
+#include <libplacebo/shaders/dithering.h>
 #include <libplacebo/shaders/film_grain.h>
 
 #include <stdio.h>
@@ -237,6 +238,77 @@ static inline void require_memeq(const void *aptr, const void *bptr, size_t size
         break;                                                                  \
     }
 
+// CPU reference implementation of `pl_shader_error_diffusion`, operating on a
+// single channel of `w * h` floats. If `band_height` is nonzero, the image is
+// split into independent bands exactly like the GPU implementation does.
+static inline void pl_test_error_diffusion(const struct pl_error_diffusion_kernel *k,
+                                           const float *in, float *out,
+                                           int w, int h, int depth,
+                                           int band_height)
+{
+    const float quant = (1 << depth) - 1;
+    int overlap = PL_EDF_BAND_OVERLAP;
+    if (band_height <= 0 || band_height >= h) {
+        band_height = h;
+        overlap = 0;
+    }
+
+    // Pad the error buffer on both sides, to avoid having to bounds check
+    const int stride = w - PL_EDF_MIN_DX + PL_EDF_MAX_DX;
+    const int rows = band_height + overlap + PL_EDF_MAX_DY;
+    float *err = malloc(rows * stride * sizeof(float));
+    REQUIRE(err);
+
+    for (int y0 = 0; y0 < h; y0 += band_height) {
+        const int ys = PL_MAX(y0 - overlap, 0), ye = PL_MIN(y0 + band_height, h);
+        memset(err, 0, rows * stride * sizeof(float));
+        for (int y = ys; y < ye; y++) {
+            for (int x = 0; x < w; x++) {
+                float *e = &err[(y - ys) * stride + x - PL_EDF_MIN_DX];
+                const float pix = in[y * w + x] * quant + *e;
+                const float dithered = roundf(pix);
+                if (y >= y0)
+                    out[y * w + x] = dithered / quant;
+
+                const float diff = (pix - dithered) / k->divisor;
+                for (int dy = 0; dy <= PL_EDF_MAX_DY; dy++) {
+                    for (int dx = PL_EDF_MIN_DX; dx <= PL_EDF_MAX_DX; dx++) {
+                        const int weight = k->pattern[dy][dx - PL_EDF_MIN_DX];
+                        if (weight && x + dx >= 0 && x + dx < w)
+                            e[dy * stride + dx] += weight * diff;
+                    }
+                }
+            }
+        }
+    }
+
+    free(err);
+}
+
+// Returns the mean absolute difference between two images after low-pass
+// filtering both with a box filter of the given radius, i.e. how well the
+// local average intensity of `a` matches that of `b`.
+static inline double pl_test_lowpass_diff(const float *a, const float *b,
+                                          int w, int h, int radius)
+{
+    double sum = 0.0;
+    int num = 0;
+    for (int y = radius; y < h - radius; y++) {
+        for (int x = radius; x < w - radius; x++) {
+            double diff = 0.0;
+            for (int j = -radius; j <= radius; j++) {
+                for (int i = -radius; i <= radius; i++)
+                    diff += a[(y + j) * w + x + i] - b[(y + j) * w + x + i];
+            }
+            sum += fabs(diff);
+            num++;
+        }
+    }
+
+    const int size = 2 * radius + 1;
+    return sum / (num * size * size);
+}
+
 static const struct pl_av1_grain_data av1_grain_data = {
     .num_points_y = 6,
     .points_y = {{0, 4}, {27, 33}, {54, 55}, {67, 61}, {108, 71}, {255, 72}},
@@ -203,6 +203,13 @@ int main()
         gpu_shader_tests(vk->gpu);
         vulkan_swapchain_tests(vk, surf);
 
+        // Submission statistics
+        pl_gpu_flush(vk->gpu);
+        struct pl_vulkan_submit_stats stats = pl_vulkan_submit_stats(vk->gpu);
+        REQUIRE_CMP(stats.frames, >, 0, PRIu64);
+        REQUIRE_CMP(stats.submissions, >, 0, PRIu64);
+        REQUIRE_CMP(stats.operations, >, 0, PRIu64);
+
         // Print heap statistics
         pl_vk_print_heap(vk->gpu, PL_LOG_DEBUG);
 
@@ -252,6 +259,14 @@ int main()
         gpu_interop_tests(vk->gpu);
         pl_vulkan_destroy(&vk);
 
+        // Re-run the shader tests with the variable-size sub-allocator
+        params.malloc_tlsf = true;
+        vk = pl_vulkan_create(log, &params);
+        REQUIRE(vk);
+        gpu_shader_tests(vk->gpu);
+        pl_vk_print_heap(vk->gpu, PL_LOG_DEBUG);
+        pl_vulkan_destroy(&vk);
+
         // Reduce log spam after first tested device
         pl_log_level_update(log, PL_LOG_INFO);
     }
@@ -19,6 +19,7 @@
 #include <math.h>
 
 #include "common.h"
+#include "gpu.h"
 #include "log.h"
 #include "pl_thread.h"
 
@@ -148,6 +149,24 @@ static void recycle_cache(pl_queue p, struct cache_entry *cache, bool recycle)
     memset(cache, 0, sizeof(*cache)); // sanity
 }
 
+// Frees spare textures, oldest first, while the GPU memory budget is exceeded
+static void trim_cache(pl_queue p)
+{
+    if (!p->cache.num || !pl_mem_budget_excess(p->gpu))
+        return;
+
+    int evicted = 0;
+    while (p->cache.num && pl_mem_budget_excess(p->gpu)) {
+        struct cache_entry *cache = &p->cache.elem[0];
+        for (int i = 0; i < PL_ARRAY_SIZE(cache->tex); i++)
+            pl_tex_destroy(p->gpu, &cache->tex[i]);
+        PL_ARRAY_REMOVE_AT(p->cache, 0);
+        evicted++;
+    }
+
+    pl_mem_budget_evicted(p->gpu, evicted);
+}
+
 static void entry_deref(pl_queue p, struct entry **pentry, bool recycle)
 {
     struct entry *entry = *pentry;
@@ -969,6 +988,7 @@ enum pl_queue_status pl_queue_update(pl_queue p, struct pl_frame_mix *out_mix,
     pl_mutex_lock(&p->lock_strong);
     pl_mutex_lock(&p->lock_weak);
     default_estimate(&p->vps, params->vsync_duration);
+    trim_cache(p);
 
     float delta = params->pts - p->prev_pts;
     if (delta < 0.0f) {
@@ -92,6 +92,41 @@ error:
     return NULL;
 }
 
+// Pushes the chain of commands `first` to `last` onto the pool's free list.
+// Pushing with a CAS loop is ABA-safe, since the pushed commands are owned
+// exclusively by the caller.
+static void cmd_push_free(struct vk_cmdpool *pool, struct vk_cmd *first,
+                          struct vk_cmd *last)
+{
+    struct vk_cmd *head = atomic_load_explicit(&pool->free_cmds, memory_order_relaxed);
+    do {
+        last->next_free = head;
+    } while (!atomic_compare_exchange_weak_explicit(&pool->free_cmds, &head, first,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
+// Pops a command from the pool's free list, or returns NULL. To sidestep the
+// ABA problem, this detaches the entire list and pushes back the remainder,
+// rather than swapping out the head in-place.
+static struct vk_cmd *cmd_pop_free(struct vk_cmdpool *pool)
+{
+    struct vk_cmd *cmd = atomic_exchange_explicit(&pool->free_cmds, NULL,
+                                                  memory_order_acquire);
+    if (!cmd)
+        return NULL;
+
+    if (cmd->next_free) {
+        struct vk_cmd *last = cmd->next_free;
+        while (last->next_free)
+            last = last->next_free;
+        cmd_push_free(pool, cmd->next_free, last);
+    }
+
+    cmd->next_free = NULL;
+    return cmd;
+}
+
 void vk_dev_callback(struct vk_ctx *vk, vk_cb callback,
                      const void *priv, const void *arg)
 {
@@ -320,6 +355,9 @@ struct vk_cmdpool *vk_cmdpool_create(struct vk_ctx *vk, int qf, int qnum,
         .num_queues = qnum,
     };
 
+    atomic_init(&pool->idx_queues, 0);
+    atomic_init(&pool->free_cmds, NULL);
+
     static const VkSemaphoreTypeCreateInfo stinfo = {
         .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
         .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
@@ -358,8 +396,9 @@ void vk_cmdpool_destroy(struct vk_cmdpool *pool)
     if (!pool)
         return;
 
-    for (int i = 0; i < pool->cmds.num; i++)
-        vk_cmd_destroy(pool->cmds.elem[i]);
+    struct vk_cmd *cmd;
+    while ((cmd = cmd_pop_free(pool)))
+        vk_cmd_destroy(cmd);
 
     struct vk_ctx *vk = pool->vk;
     for (int i = 0; i < pool->num_queues; i++)
@@ -373,23 +412,24 @@ struct vk_cmd *vk_cmd_begin(struct vk_cmdpool *pool, pl_debug_tag debug_tag)
 {
     struct vk_ctx *vk = pool->vk;
 
-    // Garbage collect the cmdpool first, to increase the chances of getting
-    // an already-available command buffer.
-    vk_poll_commands(vk, 0);
+    // Only garbage collect the cmdpool (which requires taking the lock) if
+    // there is no already-available command buffer.
+    struct vk_cmd *cmd = cmd_pop_free(pool);
+    if (!cmd) {
+        vk_poll_commands(vk, 0);
+        cmd = cmd_pop_free(pool);
+    }
 
-    struct vk_cmd *cmd = NULL;
-    pl_mutex_lock(&vk->lock);
-    if (!PL_ARRAY_POP(pool->cmds, &cmd)) {
+    if (!cmd) {
+        pl_mutex_lock(&vk->lock);
         cmd = vk_cmd_create(pool);
-        if (!cmd) {
-            pl_mutex_unlock(&vk->lock);
+        pl_mutex_unlock(&vk->lock);
+        if (!cmd)
             goto error;
-        }
     }
 
-    cmd->qindex = pool->idx_queues;
+    cmd->qindex = atomic_load(&pool->idx_queues);
     cmd->queue = pool->queues[cmd->qindex];
-    pl_mutex_unlock(&vk->lock);
 
     VkCommandBufferBeginInfo binfo = {
         .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
@@ -515,18 +555,25 @@ bool vk_cmd_submit(struct vk_cmd **pcmd)
 
     pl_mutex_lock(&vk->lock);
     PL_ARRAY_APPEND(vk->alloc, vk->cmds_pending, cmd);
+    vk->num_submits++;
     pl_mutex_unlock(&vk->lock);
     return true;
 
 error:
     vk_cmd_reset(cmd);
-    pl_mutex_lock(&vk->lock);
-    PL_ARRAY_APPEND(pool, pool->cmds, cmd);
-    pl_mutex_unlock(&vk->lock);
+    cmd_push_free(pool, cmd, cmd);
     vk->failed = true;
     return false;
 }
 
+uint64_t vk_num_submits(struct vk_ctx *vk)
+{
+    pl_mutex_lock(&vk->lock);
+    uint64_t num = vk->num_submits;
+    pl_mutex_unlock(&vk->lock);
+    return num;
+}
+
 bool vk_poll_commands(struct vk_ctx *vk, uint64_t timeout)
 {
     bool ret = false;
@@ -546,7 +593,7 @@ bool vk_poll_commands(struct vk_ctx *vk, uint64_t timeout)
                  (uint64_t) cmd->sync.sem, cmd->sync.value);
         PL_ARRAY_REMOVE_AT(vk->cmds_pending, 0); // remove before callbacks
         vk_cmd_reset(cmd);
-        PL_ARRAY_APPEND(pool, pool->cmds, cmd);
+        cmd_push_free(pool, cmd, cmd);
         ret = true;
 
         // If we've successfully spent some time waiting for at least one
@@ -568,8 +615,9 @@ void vk_rotate_queues(struct vk_ctx *vk)
     // Rotate the queues to ensure good parallelism across frames
     for (int i = 0; i < vk->pools.num; i++) {
         struct vk_cmdpool *pool = vk->pools.elem[i];
-        pool->idx_queues = (pool->idx_queues + 1) % pool->num_queues;
-        PL_TRACE(vk, "QF %d: %d/%d", pool->qf, pool->idx_queues, pool->num_queues);
+        int idx = (atomic_load(&pool->idx_queues) + 1) % pool->num_queues;
+        atomic_store(&pool->idx_queues, idx);
+        PL_TRACE(vk, "QF %d: %d/%d", pool->qf, idx, pool->num_queues);
     }
 
     pl_mutex_unlock(&vk->lock);
@@ -56,6 +56,8 @@ struct vk_cmd {
     // "Callbacks" to fire once a command completes. These are used for
     // multiple purposes, ranging from resource deallocation to fencing.
     PL_ARRAY(struct vk_callback) callbacks;
+    // Link in the cmdpool's free list, only valid while in that list
+    struct vk_cmd *next_free;
 };
 
 // Associate a callback with the completion of the current command. This
@@ -105,10 +107,10 @@ struct vk_cmdpool {
     pl_vulkan_sem *sync;
     VkQueue *queues;
     int num_queues;
-    int idx_queues;
-    // Command buffers associated with this queue. These are available for
-    // re-recording
-    PL_ARRAY(struct vk_cmd *) cmds;
+    atomic_int idx_queues;
+    // Lock-free list of command buffers associated with this queue. These
+    // are available for re-recording.
+    _Atomic(struct vk_cmd *) free_cmds;
 };
 
 // Set up a vk_cmdpool corresponding to a queue family. `qnum` may be less than
@@ -126,6 +128,9 @@ struct vk_cmd *vk_cmd_begin(struct vk_cmdpool *pool, pl_debug_tag debug_tag);
 // takes over ownership of **cmd, and sets *cmd to NULL in doing so.
 bool vk_cmd_submit(struct vk_cmd **cmd);
 
+// Total number of queue submissions performed so far.
+uint64_t vk_num_submits(struct vk_ctx *vk);
+
 // Block until some commands complete executing. This is the only function that
 // actually processes the callbacks. Will wait at most `timeout` nanoseconds
 // for the completion of any command. The timeout may also be passed as 0, in
@@ -93,6 +93,7 @@ struct vk_ctx {
     // Pending commands. These are shared for the entire mpvk_ctx to ensure
     // submission and callbacks are FIFO
     PL_ARRAY(struct vk_cmd *) cmds_pending; // submitted but not completed
+    uint64_t num_submits; // total number of queue submissions
 
     // Pending callbacks that still need to be drained before processing
     // callbacks for the next command (in case commands are recursively being
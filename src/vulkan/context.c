@@ -1382,7 +1382,7 @@ static void unlock_queue(pl_vulkan pl_vk, uint32_t qf, uint32_t qidx)
 }
 
 static bool finalize_context(struct pl_vulkan_t *pl_vk, int max_glsl_version,
-                             bool no_compute)
+                             bool no_compute, bool malloc_tlsf)
 {
     struct vk_ctx *vk = PL_PRIV(pl_vk);
 
@@ -1390,7 +1390,7 @@ static bool finalize_context(struct pl_vulkan_t *pl_vk, int max_glsl_version,
     pl_assert(vk->pool_compute);
     pl_assert(vk->pool_transfer);
 
-    vk->ma = vk_malloc_create(vk);
+    vk->ma = vk_malloc_create(vk, malloc_tlsf);
     if (!vk->ma)
         return false;
 
@@ -1554,7 +1554,8 @@ pl_vulkan pl_vulkan_create(pl_log log, const struct pl_vulkan_params *params)
     if (!device_init(vk, params))
         goto error;
 
-    if (!finalize_context(pl_vk, params->max_glsl_version, params->no_compute))
+    if (!finalize_context(pl_vk, params->max_glsl_version, params->no_compute,
+                          params->malloc_tlsf))
         goto error;
 
     return pl_vk;
@@ -1723,7 +1724,8 @@ next_qf: ;
         goto error;
     }
 
-    if (!finalize_context(pl_vk, params->max_glsl_version, params->no_compute))
+    if (!finalize_context(pl_vk, params->max_glsl_version, params->no_compute,
+                          params->malloc_tlsf))
         goto error;
 
     pl_free(tmp);
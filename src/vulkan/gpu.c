@@ -26,6 +26,12 @@
 // Gives us enough queries for 8 results
 #define QUERY_POOL_SIZE 16
 
+// Bounds for coalescing operations into a single submission. A batch is
+// submitted once it contains this many operations, or once its first
+// operation was recorded this long ago, whichever comes first.
+#define MAX_BATCH_OPS       32
+#define MAX_BATCH_LATENCY   1e-3 // seconds
+
 struct pl_timer_t {
     VkQueryPool qpool; // even=start, odd=stop
     int index_write; // next index to write to
@@ -170,6 +176,8 @@ struct vk_cmd *_begin_cmd(pl_gpu gpu, enum queue_type type, const char *label,
             pl_mutex_unlock(&p->recording);
             return NULL;
         }
+        p->cmd_ops = 0;
+        p->cmd_start = pl_clock_now();
     }
 
     if (vk->CmdBeginDebugUtilsLabelEXT && supports_marks(p->cmd)) {
@@ -190,7 +198,16 @@ static void timer_end_cb(void *ptimer, void *pindex)
     timer->pending &= ~timer_bit(index);
 }
 
-bool _end_cmd(pl_gpu gpu, struct vk_cmd **pcmd, bool submit)
+// Returns whether the currently recording batch is full or old enough that it
+// should be submitted, rather than waiting for more work to coalesce with
+static bool batch_full(const struct pl_vk *p)
+{
+    if (p->cmd_ops >= MAX_BATCH_OPS)
+        return true;
+    return pl_clock_diff(pl_clock_now(), p->cmd_start) >= MAX_BATCH_LATENCY;
+}
+
+bool _end_cmd(pl_gpu gpu, struct vk_cmd **pcmd, enum cmd_submit submit)
 {
     struct pl_vk *p = PL_PRIV(gpu);
     struct vk_ctx *vk = p->vk;
@@ -228,8 +245,18 @@ bool _end_cmd(pl_gpu gpu, struct vk_cmd **pcmd, bool submit)
     if (vk->CmdEndDebugUtilsLabelEXT && supports_marks(cmd))
         vk->CmdEndDebugUtilsLabelEXT(cmd->buf);
 
-    if (submit)
+    p->cmd_ops++;
+    p->frame_ops++;
+    switch (submit) {
+    case SUBMIT_NONE: break;
+    case SUBMIT_COALESCE:
+        if (batch_full(p))
+            ret = vk_cmd_submit(&p->cmd);
+        break;
+    case SUBMIT_NOW:
         ret = vk_cmd_submit(&p->cmd);
+        break;
+    }
 
     pl_mutex_unlock(&p->recording);
     return ret;
@@ -754,6 +781,33 @@ static void vk_gpu_flush(pl_gpu gpu)
     CMD_SUBMIT(NULL);
     vk_rotate_queues(vk);
     vk_malloc_garbage_collect(vk->ma);
+
+    // Update the per-frame submission statistics
+    pl_mutex_lock(&p->recording);
+    const uint64_t submits = vk_num_submits(vk);
+    struct pl_vulkan_submit_stats *stats = &p->stats;
+    stats->frames++;
+    stats->frame_submissions = submits - p->frame_submits;
+    stats->frame_operations = p->frame_ops;
+    stats->submissions = submits;
+    stats->operations += p->frame_ops;
+    PL_TRACE(gpu, "Frame %"PRIu64": %d operations in %d submissions",
+             stats->frames, stats->frame_operations, stats->frame_submissions);
+    p->frame_submits = submits;
+    p->frame_ops = 0;
+    pl_mutex_unlock(&p->recording);
+}
+
+struct pl_vulkan_submit_stats pl_vulkan_submit_stats(pl_gpu gpu)
+{
+    if (!pl_vulkan_get(gpu))
+        return (struct pl_vulkan_submit_stats) {0};
+
+    struct pl_vk *p = PL_PRIV(gpu);
+    pl_mutex_lock(&p->recording);
+    struct pl_vulkan_submit_stats stats = p->stats;
+    pl_mutex_unlock(&p->recording);
+    return stats;
 }
 
 static void vk_gpu_finish(pl_gpu gpu)
@@ -816,6 +870,7 @@ static const struct pl_gpu_fns pl_fns_vk = {
     .buf_poll               = vk_buf_poll,
     .desc_namespace         = vk_desc_namespace,
     .pass_create            = vk_pass_create,
+    .pass_create_batch      = vk_pass_create_batch,
     .pass_destroy           = vk_pass_destroy,
     .pass_run               = vk_pass_run,
     .timer_create           = vk_timer_create,
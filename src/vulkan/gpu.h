@@ -68,6 +68,16 @@ struct pl_vk {
     struct vk_cmd *cmd;
     pl_timer cmd_timer;
 
+    // Submission coalescing state for `cmd`: number of operations recorded
+    // into it, and the time at which recording started
+    int cmd_ops;
+    pl_clock_t cmd_start;
+
+    // Submission statistics, protected by `recording`
+    struct pl_vulkan_submit_stats stats;
+    uint64_t frame_submits; // value of `vk_num_submits` at the last flush
+    int frame_ops;
+
     // Array of VkSamplers for every combination of sample/address modes
     VkSampler samplers[PL_TEX_SAMPLE_MODE_COUNT][PL_TEX_ADDRESS_MODE_COUNT];
 
@@ -79,13 +89,20 @@ struct pl_vk {
     PL_ARRAY(VkImageLayout) host_dl_layouts;
 };
 
+enum cmd_submit {
+    SUBMIT_NONE,        // keep recording into the same command buffer
+    SUBMIT_COALESCE,    // submit once enough work has been batched up
+    SUBMIT_NOW,         // submit immediately
+};
+
 struct vk_cmd *_begin_cmd(pl_gpu, enum queue_type, const char *label, pl_timer);
-bool _end_cmd(pl_gpu, struct vk_cmd **, bool submit);
+bool _end_cmd(pl_gpu, struct vk_cmd **, enum cmd_submit submit);
 
 #define CMD_BEGIN(type)              _begin_cmd(gpu, type, __func__, NULL)
 #define CMD_BEGIN_TIMED(type, timer) _begin_cmd(gpu, type, __func__, timer)
-#define CMD_FINISH(cmd) _end_cmd(gpu, cmd, false)
-#define CMD_SUBMIT(cmd) _end_cmd(gpu, cmd, true)
+#define CMD_FINISH(cmd) _end_cmd(gpu, cmd, SUBMIT_NONE)
+#define CMD_QUEUE(cmd)  _end_cmd(gpu, cmd, SUBMIT_COALESCE)
+#define CMD_SUBMIT(cmd) _end_cmd(gpu, cmd, SUBMIT_NOW)
 
 // Helper to fire a callback the next time the `pl_gpu` is in an idle state
 //
@@ -167,5 +184,7 @@ struct pl_pass_vk;
 
 int vk_desc_namespace(pl_gpu, enum pl_desc_type);
 pl_pass vk_pass_create(pl_gpu, const struct pl_pass_params *);
+int vk_pass_create_batch(pl_gpu, const struct pl_pass_params *, int num,
+                         pl_pass *out);
 void vk_pass_destroy(pl_gpu, pl_pass);
 void vk_pass_run(pl_gpu, const struct pl_pass_run_params *);
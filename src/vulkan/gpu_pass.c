@@ -17,6 +17,7 @@
 
 #include "gpu.h"
 #include "cache.h"
+#include "pl_thread.h"
 #include "glsl/spirv.h"
 
 // For pl_pass.priv
@@ -129,19 +130,21 @@ static inline void destroy_pipeline(struct vk_ctx *vk, void *pipeline)
 
 VK_CB_FUNC_DEF(destroy_pipeline);
 
-static VkResult vk_recreate_pipelines(struct vk_ctx *vk, pl_pass pass,
+static VkResult vk_recreate_pipelines(pl_gpu gpu, pl_pass pass,
                                       bool derivable, VkPipeline base,
                                       VkPipeline *out_pipe)
 {
+    struct pl_vk *p = PL_PRIV(gpu);
+    struct vk_ctx *vk = p->vk;
     struct pl_pass_vk *pass_vk = PL_PRIV(pass);
     const struct pl_pass_params *params = &pass->params;
 
     // The old pipeline might still be in use, so we have to destroy it
-    // asynchronously with a device idle callback
+    // asynchronously with a device idle callback. Since `vk_pass_run` may
+    // leave `p->cmd` unsubmitted, this needs to wait for that as well.
     if (*out_pipe) {
-        // We don't need to use `vk_gpu_idle_callback` because the only command
-        // that can access a VkPipeline, `vk_pass_run`, always flushes `p->cmd`.
-        vk_dev_callback(vk, VK_CB_FUNC(destroy_pipeline), vk, vk_wrap_handle(*out_pipe));
+        vk_gpu_idle_callback(gpu, VK_CB_FUNC(destroy_pipeline), vk,
+                             vk_wrap_handle(*out_pipe));
         *out_pipe = VK_NULL_HANDLE;
     }
 
@@ -572,7 +575,7 @@ no_descriptors: ;
 
     // Create the graphics/compute pipeline
     VkPipeline *pipe = has_spec ? &pass_vk->base : &pass_vk->pipe;
-    VK(vk_recreate_pipelines(vk, pass, has_spec, VK_NULL_HANDLE, pipe));
+    VK(vk_recreate_pipelines(gpu, pass, has_spec, VK_NULL_HANDLE, pipe));
     pl_log_cpu_time(gpu->log, after_compilation, pl_clock_now(), "creating pipeline");
 
     // Update pipeline cache
@@ -612,6 +615,64 @@ error:
     return pass;
 }
 
+struct pass_create_args {
+    pl_gpu gpu;
+    const struct pl_pass_params *params;
+    pl_pass *out;
+    int start;
+    int num;
+    int stride;
+};
+
+static PL_THREAD_VOID pass_create_thread(void *priv)
+{
+    const struct pass_create_args *args = priv;
+    for (int i = args->start; i < args->num; i += args->stride) {
+        if (!args->out[i])
+            args->out[i] = vk_pass_create(args->gpu, &args->params[i]);
+    }
+    PL_THREAD_RETURN();
+}
+
+int vk_pass_create_batch(pl_gpu gpu, const struct pl_pass_params *params,
+                         int num, pl_pass *out)
+{
+    // Each pass compiles its pipeline into its own VkPipelineCache, which is
+    // only merged into the pl_cache once the pipeline is created, so passes
+    // can be created on separate threads without any shared state
+    enum { MAX_WORKERS = 8 };
+    struct pass_create_args args[MAX_WORKERS];
+    const int num_workers = PL_CLAMP(num, 1, MAX_WORKERS);
+    for (int i = 0; i < num; i++)
+        out[i] = NULL;
+    for (int i = 0; i < num_workers; i++) {
+        args[i] = (struct pass_create_args) {
+            .gpu    = gpu,
+            .params = params,
+            .out    = out,
+            .start  = i,
+            .num    = num,
+            .stride = num_workers,
+        };
+    }
+
+    pl_thread workers[MAX_WORKERS] = {0};
+    for (int i = 0; i < num_workers; i++) {
+        if (pl_thread_create(&workers[i], pass_create_thread, &args[i]) != 0)
+            pass_create_thread(&args[i]); // fallback
+    }
+
+    for (int i = 0; i < num_workers; i++) {
+        if (workers[i] && pl_thread_join(workers[i]) != 0)
+            pass_create_thread(&args[i]); // fallback
+    }
+
+    int num_created = 0;
+    for (int i = 0; i < num; i++)
+        num_created += !!out[i];
+    return num_created;
+}
+
 static const VkPipelineStageFlags2 shaderStages[] = {
     [PL_PASS_RASTER]  = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
     [PL_PASS_COMPUTE] = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
@@ -793,12 +854,16 @@ void vk_pass_run(pl_gpu gpu, const struct pl_pass_run_params *params)
     // Check if we need to re-specialize this pipeline
     if (need_respec(pass, params)) {
         pl_clock_t start = pl_clock_now();
-        VK(vk_recreate_pipelines(vk, pass, false, pass_vk->base, &pass_vk->pipe));
+        VK(vk_recreate_pipelines(gpu, pass, false, pass_vk->base, &pass_vk->pipe));
         pl_log_cpu_time(gpu->log, start, pl_clock_now(), "re-specializing shader");
     }
 
     if (!pass_vk->use_pushd) {
-        // Wait for a free descriptor set
+        // Wait for a free descriptor set. All of them may be held by
+        // operations coalesced into the current command buffer, so submit
+        // it first to make sure they can actually be released.
+        if (!pass_vk->dmask)
+            CMD_SUBMIT(NULL);
         while (!pass_vk->dmask) {
             PL_TRACE(gpu, "No free descriptor sets! ...blocking (slow path)");
             vk_poll_commands(vk, 10000000); // 10 ms
@@ -962,8 +1027,9 @@ void vk_pass_run(pl_gpu gpu, const struct pl_pass_run_params *params)
     for (int i = 0; i < pass->params.num_descriptors; i++)
         vk_release_descriptor(gpu, cmd, pass, params->desc_bindings[i], i);
 
-    // submit this command buffer for better intra-frame granularity
-    CMD_SUBMIT(&cmd);
+    // submit this command buffer for better intra-frame granularity, but
+    // coalesce small passes to avoid excessive per-submission overhead
+    CMD_QUEUE(&cmd);
 
 error:
     return;
@@ -56,6 +56,37 @@
 // one go. (For a 256 MB non-resizable BAR, this is equivalent to 4 MB)
 #define MAPPED_VRAM_THRESHOLD 256
 
+// Controls the granularity of variable-size (TLSF) sub-allocations, and the
+// number of second-level size classes per power of two. Block sizes are
+// rounded up to multiples of the granularity. (Default: 256 bytes, 16 classes)
+#define TLSF_MIN_SHIFT 8
+#define TLSF_SL_BITS   4
+#define TLSF_SL_COUNT  (1 << TLSF_SL_BITS)
+#define TLSF_FL_COUNT  (sizeof(uint64_t) * 8)
+
+// A single block of a variable-size slab, either free or in use. All blocks
+// are linked in address order, and free blocks are additionally linked into
+// the free list of their size class.
+struct tlsf_block {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    bool free;
+    struct tlsf_block *prev, *next;           // physical neighbours
+    struct tlsf_block *prev_free, *next_free; // free list (or spare list)
+};
+
+// Two-level segregated fit allocator, which tracks the free blocks of a slab
+// in size-segregated lists. Both allocation and freeing are O(1).
+struct tlsf {
+    uint64_t fl_bitmap;                   // non-empty first-level classes
+    uint32_t sl_bitmap[TLSF_FL_COUNT];    // non-empty second-level classes
+    struct tlsf_block *free[TLSF_FL_COUNT][TLSF_SL_COUNT];
+    struct tlsf_block *spare;             // unused block structs, for re-use
+    VkDeviceSize free_size;               // total size of all free blocks
+    int num_blocks;
+    int num_free;
+};
+
 // A single slab represents a contiguous region of allocated memory. Actual
 // allocations are served as pages of this. Slabs are organized into pools,
 // each of which contains a list of slabs of differing page sizes.
@@ -71,6 +102,7 @@ struct vk_slab {
     // free space accounting (only for non-dedicated slabs)
     uint64_t spacemap;      // bitset of available pages
     size_t pagesize;        // size in bytes per page
+    struct tlsf *tlsf;      // variable-size allocator (replaces pages)
     size_t used;            // number of bytes actually in use
     uint64_t age;           // timestamp of last use
 
@@ -105,8 +137,220 @@ struct vk_malloc {
     size_t max_mapped_vram; // maximum allocation size from host-visible VRAM
     PL_ARRAY(struct vk_pool) pools;
     uint64_t age;
+    bool tlsf;              // use variable-size slabs instead of pages
 };
 
+static inline void tlsf_mapping(VkDeviceSize size, int *fl, int *sl)
+{
+    uint64_t units = size >> TLSF_MIN_SHIFT;
+    if (units < TLSF_SL_COUNT) {
+        *fl = 0;
+        *sl = units;
+        return;
+    }
+
+    int log2 = 63 - __builtin_clzll(units);
+    *fl = log2 - TLSF_SL_BITS + 1;
+    *sl = (units >> (log2 - TLSF_SL_BITS)) ^ TLSF_SL_COUNT;
+}
+
+static struct tlsf_block *tlsf_block_new(struct tlsf *t)
+{
+    struct tlsf_block *block = t->spare;
+    if (block) {
+        t->spare = block->next_free;
+    } else {
+        block = pl_alloc_ptr(t, block);
+    }
+
+    t->num_blocks++;
+    return block;
+}
+
+static void tlsf_block_release(struct tlsf *t, struct tlsf_block *block)
+{
+    block->next_free = t->spare;
+    t->spare = block;
+    t->num_blocks--;
+}
+
+static void tlsf_insert(struct tlsf *t, struct tlsf_block *block)
+{
+    int fl, sl;
+    tlsf_mapping(block->size, &fl, &sl);
+    block->free = true;
+    block->prev_free = NULL;
+    block->next_free = t->free[fl][sl];
+    if (block->next_free)
+        block->next_free->prev_free = block;
+    t->free[fl][sl] = block;
+    t->fl_bitmap |= 1LLU << fl;
+    t->sl_bitmap[fl] |= 1U << sl;
+    t->free_size += block->size;
+    t->num_free++;
+}
+
+static void tlsf_remove(struct tlsf *t, struct tlsf_block *block)
+{
+    int fl, sl;
+    tlsf_mapping(block->size, &fl, &sl);
+    if (block->next_free)
+        block->next_free->prev_free = block->prev_free;
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        t->free[fl][sl] = block->next_free;
+        if (!block->next_free) {
+            t->sl_bitmap[fl] &= ~(1U << sl);
+            if (!t->sl_bitmap[fl])
+                t->fl_bitmap &= ~(1LLU << fl);
+        }
+    }
+
+    block->free = false;
+    t->free_size -= block->size;
+    t->num_free--;
+}
+
+static struct tlsf *tlsf_create(void *alloc, VkDeviceSize size)
+{
+    struct tlsf *t = pl_zalloc_ptr(alloc, t);
+    struct tlsf_block *block = tlsf_block_new(t);
+    *block = (struct tlsf_block) {
+        .size = size & ~((1LLU << TLSF_MIN_SHIFT) - 1),
+    };
+
+    tlsf_insert(t, block);
+    return t;
+}
+
+// Returns the smallest block size that `tlsf_alloc` needs to find in order to
+// satisfy an allocation of this size and alignment
+static VkDeviceSize tlsf_search_size(VkDeviceSize size, VkDeviceSize align)
+{
+    // All block offsets are multiples of the granularity, so only larger
+    // alignments can require padding
+    const VkDeviceSize gran = 1LLU << TLSF_MIN_SHIFT;
+    align = align ? pl_lcm(align, gran) : gran;
+    return PL_ALIGN2(size, gran) + align - gran;
+}
+
+// Returns the allocated block, or NULL if no free block is large enough
+static struct tlsf_block *tlsf_alloc(struct tlsf *t, VkDeviceSize size,
+                                     VkDeviceSize align)
+{
+    const VkDeviceSize gran = 1LLU << TLSF_MIN_SHIFT;
+    align = align ? pl_lcm(align, gran) : gran;
+    size = PL_ALIGN2(size, gran);
+
+    // Round the search size up to the next size class, so that every block
+    // in the resulting class is guaranteed to be large enough
+    VkDeviceSize search = tlsf_search_size(size, align);
+    uint64_t units = search >> TLSF_MIN_SHIFT;
+    if (units >= TLSF_SL_COUNT) {
+        int log2 = 63 - __builtin_clzll(units);
+        search += (1LLU << (log2 - TLSF_SL_BITS + TLSF_MIN_SHIFT)) - 1;
+    }
+
+    int fl, sl;
+    tlsf_mapping(search, &fl, &sl);
+    if (fl >= TLSF_FL_COUNT)
+        return NULL;
+
+    uint32_t sl_map = t->sl_bitmap[fl] & (~0U << sl);
+    if (!sl_map) {
+        uint64_t fl_map = 0;
+        if (fl + 1 < TLSF_FL_COUNT)
+            fl_map = t->fl_bitmap & (~0LLU << (fl + 1));
+        if (!fl_map)
+            return NULL;
+        fl = __builtin_ctzll(fl_map);
+        sl_map = t->sl_bitmap[fl];
+    }
+
+    sl = __builtin_ctz(sl_map);
+    struct tlsf_block *block = t->free[fl][sl];
+    tlsf_remove(t, block);
+
+    // Split off any leading padding required for alignment. Note that the
+    // neighbours of a free block are never free, so no merging is needed.
+    const VkDeviceSize pad = PL_ALIGN(block->offset, align) - block->offset;
+    if (pad) {
+        struct tlsf_block *head = tlsf_block_new(t);
+        *head = (struct tlsf_block) {
+            .offset = block->offset,
+            .size   = pad,
+            .prev   = block->prev,
+            .next   = block,
+        };
+        if (head->prev)
+            head->prev->next = head;
+        block->prev = head;
+        block->offset += pad;
+        block->size -= pad;
+        tlsf_insert(t, head);
+    }
+
+    // Split off the remainder
+    pl_assert(block->size >= size);
+    if (block->size > size) {
+        struct tlsf_block *tail = tlsf_block_new(t);
+        *tail = (struct tlsf_block) {
+            .offset = block->offset + size,
+            .size   = block->size - size,
+            .prev   = block,
+            .next   = block->next,
+        };
+        if (tail->next)
+            tail->next->prev = tail;
+        block->next = tail;
+        block->size = size;
+        tlsf_insert(t, tail);
+    }
+
+    return block;
+}
+
+static void tlsf_free(struct tlsf *t, struct tlsf_block *block)
+{
+    pl_assert(!block->free);
+    struct tlsf_block *prev = block->prev, *next = block->next;
+    if (prev && prev->free) {
+        tlsf_remove(t, prev);
+        prev->size += block->size;
+        prev->next = next;
+        if (next)
+            next->prev = prev;
+        tlsf_block_release(t, block);
+        block = prev;
+    }
+
+    if (next && next->free) {
+        tlsf_remove(t, next);
+        block->size += next->size;
+        block->next = next->next;
+        if (block->next)
+            block->next->prev = block;
+        tlsf_block_release(t, next);
+    }
+
+    tlsf_insert(t, block);
+}
+
+static VkDeviceSize tlsf_largest_free(const struct tlsf *t)
+{
+    if (!t->fl_bitmap)
+        return 0;
+
+    // The largest block must be in the highest non-empty size class
+    const int fl = 63 - __builtin_clzll(t->fl_bitmap);
+    const int sl = 31 - __builtin_clz(t->sl_bitmap[fl]);
+    VkDeviceSize largest = 0;
+    for (const struct tlsf_block *b = t->free[fl][sl]; b; b = b->next_free)
+        largest = PL_MAX(largest, b->size);
+    return largest;
+}
+
 static inline float efficiency(size_t used, size_t total)
 {
     if (!total)
@@ -171,21 +415,45 @@ void vk_malloc_print_stats(struct vk_malloc *ma, enum pl_log_level lev)
         size_t pool_size = 0;
         size_t pool_used = 0;
         size_t pool_res = 0;
+        size_t pool_avail = 0;   // only for TLSF slabs
+        size_t pool_largest = 0; // only for TLSF slabs
 
         for (int j = 0; j < pool->slabs.num; j++) {
             struct vk_slab *slab = pool->slabs.elem[j];
             pl_mutex_lock(&slab->lock);
 
-            size_t avail = __builtin_popcountll(slab->spacemap) * slab->pagesize;
-            size_t slab_res = slab->size - avail;
-
-            PL_MSG(vk, lev, "    Slab %2d: %8"PRIx64" x %s: "
-                   "%s used %s res %s alloc from heap %d, efficiency %.2f%%  [%s]",
-                   j, slab->spacemap, PRINT_SIZE(slab->pagesize),
-                   PRINT_SIZE(slab->used), PRINT_SIZE(slab_res),
-                   PRINT_SIZE(slab->size), (int) slab->mtype.heapIndex,
-                   efficiency(slab->used, slab_res),
-                   PL_DEF(slab->debug_tag, "unknown"));
+            size_t avail, slab_res;
+            if (slab->tlsf) {
+                // Fragmentation is the fraction of free space that can't be
+                // served by a single allocation
+                const struct tlsf *t = slab->tlsf;
+                const size_t largest = tlsf_largest_free(t);
+                avail = t->free_size;
+                slab_res = slab->size - avail;
+                pool_avail += avail;
+                pool_largest = PL_MAX(pool_largest, largest);
+
+                PL_MSG(vk, lev, "    Slab %2d: %4d blocks (%4d free, largest %s): "
+                       "%s used %s res %s alloc from heap %d, efficiency %.2f%%, "
+                       "fragmentation %.2f%%  [%s]",
+                       j, t->num_blocks, t->num_free, PRINT_SIZE(largest),
+                       PRINT_SIZE(slab->used), PRINT_SIZE(slab_res),
+                       PRINT_SIZE(slab->size), (int) slab->mtype.heapIndex,
+                       efficiency(slab->used, slab_res),
+                       100.0f - efficiency(largest, avail),
+                       PL_DEF(slab->debug_tag, "unknown"));
+            } else {
+                avail = __builtin_popcountll(slab->spacemap) * slab->pagesize;
+                slab_res = slab->size - avail;
+
+                PL_MSG(vk, lev, "    Slab %2d: %8"PRIx64" x %s: "
+                       "%s used %s res %s alloc from heap %d, efficiency %.2f%%  [%s]",
+                       j, slab->spacemap, PRINT_SIZE(slab->pagesize),
+                       PRINT_SIZE(slab->used), PRINT_SIZE(slab_res),
+                       PRINT_SIZE(slab->size), (int) slab->mtype.heapIndex,
+                       efficiency(slab->used, slab_res),
+                       PL_DEF(slab->debug_tag, "unknown"));
+            }
 
             pool_size += slab->size;
             pool_used += slab->used;
@@ -198,6 +466,12 @@ void vk_malloc_print_stats(struct vk_malloc *ma, enum pl_log_level lev)
                PRINT_SIZE(pool_used), PRINT_SIZE(pool_res),
                PRINT_SIZE(pool_size), efficiency(pool_used, pool_res),
                efficiency(pool_res, pool_size));
+        if (pool_avail) {
+            PL_MSG(vk, lev, "    Pool free space: %s, largest block %s, "
+                   "fragmentation %.2f%%", PRINT_SIZE(pool_avail),
+                   PRINT_SIZE(pool_largest),
+                   100.0f - efficiency(pool_largest, pool_avail));
+        }
 
         total_size += pool_size;
         total_used += pool_used;
@@ -206,11 +480,11 @@ void vk_malloc_print_stats(struct vk_malloc *ma, enum pl_log_level lev)
     pl_mutex_unlock(&ma->lock);
 
     PL_MSG(vk, lev, "Memory summary: %s used %s res %s alloc, "
-           "efficiency %.2f%%, utilization %.2f%%, max page: %s",
+           "efficiency %.2f%%, utilization %.2f%%, max page: %s, allocator: %s",
            PRINT_SIZE(total_used), PRINT_SIZE(total_res),
            PRINT_SIZE(total_size), efficiency(total_used, total_res),
            efficiency(total_res, total_size),
-           PRINT_SIZE(ma->maximum_page_size));
+           PRINT_SIZE(ma->maximum_page_size), ma->tlsf ? "tlsf" : "pages");
 }
 
 static void slab_free(struct vk_ctx *vk, struct vk_slab *slab)
@@ -558,12 +832,13 @@ static void pool_uninit(struct vk_ctx *vk, struct vk_pool *pool)
     *pool = (struct vk_pool) {0};
 }
 
-struct vk_malloc *vk_malloc_create(struct vk_ctx *vk)
+struct vk_malloc *vk_malloc_create(struct vk_ctx *vk, bool tlsf)
 {
     struct vk_malloc *ma = pl_zalloc_ptr(NULL, ma);
     pl_mutex_init(&ma->lock);
     vk->GetPhysicalDeviceMemoryProperties(vk->physd, &ma->props);
     ma->vk = vk;
+    ma->tlsf = tlsf;
 
     // Determine maximum page size
     ma->maximum_page_size = MAXIMUM_PAGE_SIZE_ABSOLUTE;
@@ -658,8 +933,13 @@ void vk_malloc_free(struct vk_malloc *ma, struct vk_memslice *slice)
 
     pl_mutex_lock(&slab->lock);
 
-    int page_idx = slice->offset / slab->pagesize;
-    slab->spacemap |= 0x1LLU << page_idx;
+    if (slab->tlsf) {
+        tlsf_free(slab->tlsf, slice->block);
+    } else {
+        int page_idx = slice->offset / slab->pagesize;
+        slab->spacemap |= 0x1LLU << page_idx;
+    }
+
     slab->used -= slice->size;
     slab->age = ma->age;
     pl_assert(slab->used >= 0);
@@ -776,6 +1056,63 @@ static struct vk_slab *pool_get_page(struct vk_malloc *ma, struct vk_pool *pool,
     return slab;
 }
 
+// Variable-size equivalent of `pool_get_page`, which serves allocations of
+// any size and alignment from the same slabs.
+//
+// Note: This locks the slab it returns
+static struct vk_slab *pool_get_block(struct vk_malloc *ma, struct vk_pool *pool,
+                                      size_t size, size_t align,
+                                      VkDeviceSize *offset,
+                                      struct tlsf_block **out_block)
+{
+    // The full aligned size is reported to the `vk_memslice`, so reserve it
+    size = PL_ALIGN(size, align);
+
+    struct tlsf_block *block;
+    VkDeviceSize slab_size = MINIMUM_SLAB_SIZE;
+    for (int i = 0; i < pool->slabs.num; i++) {
+        struct vk_slab *slab = pool->slabs.elem[i];
+        pl_mutex_lock(&slab->lock);
+        block = tlsf_alloc(slab->tlsf, size, align);
+        if (block) {
+            *offset = block->offset;
+            *out_block = block;
+            return slab;
+        }
+
+        pl_mutex_unlock(&slab->lock);
+        // Grow the size of new slabs with the number of exhausted slabs
+        slab_size = PL_MAX(slab_size, 2 * slab->size);
+    }
+
+    // Otherwise, allocate a new vk_slab and append it to the list. Make sure
+    // it's large enough to fit this allocation, including worst-case padding
+    const VkDeviceSize min_size = tlsf_search_size(size, align);
+    slab_size = PL_MIN(slab_size, ma->maximum_page_size);
+    slab_size = PL_MAX(slab_size, min_size);
+
+    struct vk_malloc_params params = pool->params;
+    params.reqs.size = PL_ALIGN2(slab_size, 1LLU << TLSF_MIN_SHIFT);
+
+    // Don't hold the lock while allocating the slab, because it can be a
+    // potentially very costly operation.
+    pl_mutex_unlock(&ma->lock);
+    struct vk_slab *slab = slab_alloc(ma, &params);
+    pl_mutex_lock(&ma->lock);
+    if (!slab)
+        return NULL;
+    pl_mutex_lock(&slab->lock);
+
+    slab->tlsf = tlsf_create(slab, slab->size);
+    PL_ARRAY_APPEND(NULL, pool->slabs, slab);
+
+    block = tlsf_alloc(slab->tlsf, size, align);
+    pl_assert(block);
+    *offset = block->offset;
+    *out_block = block;
+    return slab;
+}
+
 static bool vk_malloc_import(struct vk_malloc *ma, struct vk_memslice *out,
                              const struct vk_malloc_params *params)
 {
@@ -1035,6 +1372,7 @@ bool vk_malloc_slice(struct vk_malloc *ma, struct vk_memslice *out,
     align = pl_lcm(align, vk->props.limits.nonCoherentAtomSize);
 
     struct vk_slab *slab;
+    struct tlsf_block *block = NULL;
     VkDeviceSize offset;
 
     if (params->ded_image || size > ma->maximum_page_size) {
@@ -1046,7 +1384,11 @@ bool vk_malloc_slice(struct vk_malloc *ma, struct vk_memslice *out,
     } else {
         pl_mutex_lock(&ma->lock);
         struct vk_pool *pool = find_pool(ma, params);
-        slab = pool_get_page(ma, pool, size, align, &offset);
+        if (ma->tlsf) {
+            slab = pool_get_block(ma, pool, size, align, &offset, &block);
+        } else {
+            slab = pool_get_page(ma, pool, size, align, &offset);
+        }
         pl_mutex_unlock(&ma->lock);
         if (!slab) {
             PL_ERR(ma->vk, "No slab to serve request for %s bytes (with "
@@ -1077,6 +1419,7 @@ bool vk_malloc_slice(struct vk_malloc *ma, struct vk_memslice *out,
         .map_offset = slab->data ? offset : 0,
         .map_size = slab->data ? size : 0,
         .priv = slab,
+        .block = block,
         .shared_mem = {
             .handle = slab->handle,
             .offset = offset,
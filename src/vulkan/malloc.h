@@ -21,7 +21,10 @@
 
 // All memory allocated from a vk_malloc MUST be explicitly released by
 // the caller before vk_malloc_destroy is called.
-struct vk_malloc *vk_malloc_create(struct vk_ctx *vk);
+//
+// If `tlsf` is true, non-dedicated allocations are served by a variable-size
+// (two-level segregated fit) sub-allocator, rather than fixed-size pages.
+struct vk_malloc *vk_malloc_create(struct vk_ctx *vk, bool tlsf);
 void vk_malloc_destroy(struct vk_malloc **ma);
 
 // Get the supported handle types for this malloc instance
@@ -34,6 +37,7 @@ struct vk_memslice {
     VkDeviceSize offset;
     VkDeviceSize size;
     void *priv;
+    void *block;    // sub-allocation within `priv` (for variable-size slabs)
     // depending on the type/flags:
     struct pl_shared_mem shared_mem;
     VkBuffer buf;   // associated buffer (when `buf_usage` is nonzero)
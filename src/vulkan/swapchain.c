@@ -831,7 +831,7 @@ static bool vk_sw_submit_frame(pl_swapchain sw)
     }
 
     struct vk_cmdpool *pool = vk->pool_graphics;
-    int qidx = pool->idx_queues;
+    int qidx = atomic_load(&pool->idx_queues);
     VkQueue queue = pool->queues[qidx];
 
     vk_rotate_queues(p->vk);